@@ -0,0 +1,219 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/message.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/vtable.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace nvidia::startup
+{
+
+constexpr auto profileInterface = "com.Nvidia.StartupProfile";
+
+/** @brief phase name, start offset and accumulated duration in usec */
+using PhaseRecord = std::tuple<std::string, uint64_t, uint64_t>;
+
+/**
+ * @class StartupProfiler
+ *
+ * Records named start up phases of a daemon with monotonic timestamps. Phases
+ * recorded more than once under the same name, e.g. one mapper call per
+ * object, are accumulated into a single record.
+ */
+class StartupProfiler
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @class Phase
+     *
+     * Scoped timer, the phase is recorded when it goes out of scope or when
+     * stop() is called.
+     */
+    class Phase
+    {
+      public:
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+        Phase(Phase&&) = delete;
+        Phase& operator=(Phase&&) = delete;
+
+        Phase(StartupProfiler& profiler, std::string name) :
+            profiler(profiler), name(std::move(name)), start(Clock::now())
+        {}
+
+        ~Phase()
+        {
+            stop();
+        }
+
+        void stop()
+        {
+            if (!stopped)
+            {
+                stopped = true;
+                profiler.record(name, start, Clock::now());
+            }
+        }
+
+      private:
+        StartupProfiler& profiler;
+        std::string name;
+        Clock::time_point start;
+        bool stopped = false;
+    };
+
+    StartupProfiler(const StartupProfiler&) = delete;
+    StartupProfiler& operator=(const StartupProfiler&) = delete;
+
+    /** @brief the process wide profiler, its origin is the first call which
+     * should be at the top of main */
+    static StartupProfiler& instance()
+    {
+        static StartupProfiler profiler;
+        return profiler;
+    }
+
+    /** @brief start a scoped phase */
+    Phase phase(std::string name)
+    {
+        return Phase(*this, std::move(name));
+    }
+
+    void record(const std::string& name, Clock::time_point start,
+                Clock::time_point end)
+    {
+        auto duration = toUsec(end - start);
+        for (auto& [phaseName, offset, total] : records)
+        {
+            if (phaseName == name)
+            {
+                total += duration;
+                return;
+            }
+        }
+        records.emplace_back(name, toUsec(start - origin), duration);
+    }
+
+    /** @brief mark the daemon ready, the time from the origin is published as
+     * ReadyUsec */
+    void ready()
+    {
+        readyUsec = toUsec(Clock::now() - origin);
+    }
+
+    const std::vector<PhaseRecord>& phases() const
+    {
+        return records;
+    }
+
+    /** @brief one line summary of the phases for the journal */
+    std::string summary(const std::string& daemon) const
+    {
+        std::string line = daemon + " ready in " +
+                           std::to_string(readyUsec / 1000) + "ms:";
+        for (const auto& [name, offset, duration] : records)
+        {
+            line += " " + name + "=" + std::to_string(duration / 1000) + "ms";
+        }
+        return line;
+    }
+
+    /**
+     * @brief Publish the breakdown on the com.Nvidia.StartupProfile interface
+     *
+     * @param[in] bus - D-Bus bus object
+     * @param[in] path - object path to publish on
+     */
+    void publish(sdbusplus::bus::bus& bus, const std::string& path)
+    {
+        iface = std::make_unique<sdbusplus::server::interface::interface>(
+            bus, path.c_str(), profileInterface, vtable, this);
+    }
+
+  private:
+    StartupProfiler() : origin(Clock::now())
+    {}
+
+    static uint64_t toUsec(Clock::duration d)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d)
+            .count();
+    }
+
+    static int getPhases(sd_bus*, const char*, const char*, const char*,
+                         sd_bus_message* reply, void* context, sd_bus_error*)
+    {
+        auto profiler = static_cast<StartupProfiler*>(context);
+        sdbusplus::message::message m(reply);
+        m.append(profiler->records);
+        return 1;
+    }
+
+    static int getOrigin(sd_bus*, const char*, const char*, const char*,
+                         sd_bus_message* reply, void* context, sd_bus_error*)
+    {
+        auto profiler = static_cast<StartupProfiler*>(context);
+        sdbusplus::message::message m(reply);
+        m.append(static_cast<uint64_t>(
+            toUsec(profiler->origin.time_since_epoch())));
+        return 1;
+    }
+
+    static int getReady(sd_bus*, const char*, const char*, const char*,
+                        sd_bus_message* reply, void* context, sd_bus_error*)
+    {
+        auto profiler = static_cast<StartupProfiler*>(context);
+        sdbusplus::message::message m(reply);
+        m.append(profiler->readyUsec);
+        return 1;
+    }
+
+    static constexpr sdbusplus::vtable::vtable_t vtable[] = {
+        sdbusplus::vtable::start(),
+        sdbusplus::vtable::property("Phases", "a(stt)", getPhases,
+                                    sdbusplus::vtable::property_::const_),
+        sdbusplus::vtable::property("OriginMonotonicUsec", "t", getOrigin,
+                                    sdbusplus::vtable::property_::const_),
+        sdbusplus::vtable::property("ReadyUsec", "t", getReady,
+                                    sdbusplus::vtable::property_::const_),
+        sdbusplus::vtable::end()};
+
+    /** @brief CLOCK_MONOTONIC time of the first use of the profiler */
+    Clock::time_point origin;
+    uint64_t readyUsec = 0;
+    std::vector<PhaseRecord> records;
+    std::unique_ptr<sdbusplus::server::interface::interface> iface;
+};
+
+/** @brief shorthand for StartupProfiler::instance() */
+inline StartupProfiler& startupProfiler()
+{
+    return StartupProfiler::instance();
+}
+
+} // namespace nvidia::startup
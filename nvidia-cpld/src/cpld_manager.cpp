@@ -17,6 +17,8 @@
 
 #include "cpld_manager.hpp"
 
+#include "startup_profiler.hpp"
+
 #include <fmt/format.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -27,6 +29,7 @@
 using namespace phosphor::logging;
 using namespace sdbusplus::xyz::openbmc_project::Common::Device::Error;
 using namespace nvidia::cpld::common;
+using nvidia::startup::startupProfiler;
 
 namespace nvidia::cpld::manager
 {
@@ -36,7 +39,9 @@ CPLDManager::CPLDManager(sdbusplus::bus::bus& bus, std::string basePath) :
 {
     using namespace sdeventplus;
 
+    auto jsonPhase = startupProfiler().phase("json-parse");
     nlohmann::json fruJson = loadJSONFile(CPLD_JSON_PATH);
+    jsonPhase.stop();
     if (fruJson == nullptr)
     {
         log<level::ERR>("InternalFailure when parsing the JSON file");
@@ -79,9 +84,13 @@ CPLDManager::CPLDManager(sdbusplus::bus::bus& bus, std::string basePath) :
             {
                 continue;
             }
+            // the inventory properties are read by running the command
+            // utility, this dominates the start up time
+            auto popenPhase = startupProfiler().phase("popen");
             auto inv =
                 std::make_unique<Cpld>(bus, invpath, busId, devAddr, id, model,
                                        manufacturer, assoc, locType);
+            popenPhase.stop();
             cpldInvs.emplace_back(std::move(inv));
         }
         catch (const std::exception& e)
@@ -16,6 +16,7 @@
  */
 
 #include "cpld_manager.hpp"
+#include "startup_profiler.hpp"
 
 #include <filesystem>
 #include <phosphor-logging/log.hpp>
@@ -23,6 +24,7 @@
 #include <sdeventplus/event.hpp>
 
 using namespace nvidia::cpld;
+using nvidia::startup::startupProfiler;
 
 int main(void)
 {
@@ -30,17 +32,26 @@ int main(void)
     {
         using namespace phosphor::logging;
 
+        auto connectPhase = startupProfiler().phase("connect");
         auto bus = sdbusplus::bus::new_default();
         auto event = sdeventplus::Event::get_default();
+        connectPhase.stop();
 
         sdbusplus::server::manager::manager objManager(bus, BASE_INV_PATH);
 
+        auto namePhase = startupProfiler().phase("request-name");
         bus.request_name(BUSNAME);
+        namePhase.stop();
 
         bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
 
         manager::CPLDManager manager(bus, BASE_INV_PATH);
 
+        startupProfiler().ready();
+        startupProfiler().publish(bus, MANAGER_OBJ_PATH);
+        log<level::INFO>(
+            startupProfiler().summary("nvidia-cpld-monitor").c_str());
+
         return event.loop();
     }
     catch (const std::exception& e)
@@ -0,0 +1,152 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "fault_monitor.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/message.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/vtable.hpp>
+
+#include <string>
+#include <vector>
+
+namespace nvidia::power::psu
+{
+
+static constexpr auto faultsIface = "com.Nvidia.PowerSupply.Faults";
+
+/**
+ * @class FaultInterface
+ *
+ * PMBus status of a PSU on its inventory object, the raw registers and
+ * the names of the conditions they hold.
+ */
+class FaultInterface
+{
+  public:
+    FaultInterface(sdbusplus::bus::bus& bus, const std::string& path) :
+        iface(bus, path.c_str(), faultsIface, vtable, this)
+    {
+        iface.emit_added();
+    }
+
+    /**
+     * @brief publish a new report
+     *
+     * @param newReport - status registers read
+     */
+    void update(const pmbus::StatusReport& newReport)
+    {
+        auto old = report;
+        auto oldFaults = faults;
+        report = newReport;
+        faults = pmbus::faultNames(report);
+        if (old.word != report.word)
+        {
+            iface.property_changed("StatusWord");
+        }
+        if (old.vout != report.vout)
+        {
+            iface.property_changed("StatusVout");
+        }
+        if (old.iout != report.iout)
+        {
+            iface.property_changed("StatusIout");
+        }
+        if (old.input != report.input)
+        {
+            iface.property_changed("StatusInput");
+        }
+        if (old.temperature != report.temperature)
+        {
+            iface.property_changed("StatusTemperature");
+        }
+        if (old.cml != report.cml)
+        {
+            iface.property_changed("StatusCml");
+        }
+        if (oldFaults != faults)
+        {
+            iface.property_changed("Faults");
+        }
+    }
+
+    const std::vector<std::string>& names() const
+    {
+        return faults;
+    }
+
+  private:
+    template <typename T, T pmbus::StatusReport::*member>
+    static int getRegister(sd_bus*, const char*, const char*, const char*,
+                           sd_bus_message* reply, void* context,
+                           sd_bus_error*)
+    {
+        auto self = static_cast<FaultInterface*>(context);
+        sdbusplus::message::message(reply).append(self->report.*member);
+        return 1;
+    }
+
+    static int getFaults(sd_bus*, const char*, const char*, const char*,
+                         sd_bus_message* reply, void* context, sd_bus_error*)
+    {
+        auto self = static_cast<FaultInterface*>(context);
+        sdbusplus::message::message(reply).append(self->faults);
+        return 1;
+    }
+
+    static const sdbusplus::vtable::vtable_t vtable[];
+
+    pmbus::StatusReport report;
+    std::vector<std::string> faults;
+    sdbusplus::server::interface::interface iface;
+};
+
+inline const sdbusplus::vtable::vtable_t FaultInterface::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::property(
+        "StatusWord", "q",
+        getRegister<uint16_t, &pmbus::StatusReport::word>,
+        sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::property(
+        "StatusVout", "y",
+        getRegister<uint8_t, &pmbus::StatusReport::vout>,
+        sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::property(
+        "StatusIout", "y",
+        getRegister<uint8_t, &pmbus::StatusReport::iout>,
+        sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::property(
+        "StatusInput", "y",
+        getRegister<uint8_t, &pmbus::StatusReport::input>,
+        sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::property(
+        "StatusTemperature", "y",
+        getRegister<uint8_t, &pmbus::StatusReport::temperature>,
+        sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::property(
+        "StatusCml", "y",
+        getRegister<uint8_t, &pmbus::StatusReport::cml>,
+        sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::property("Faults", "as", getFaults,
+                                sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::end()};
+
+} // namespace nvidia::power::psu
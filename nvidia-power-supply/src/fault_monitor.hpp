@@ -0,0 +1,459 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * PMBus fault status of the PSUs.
+ *
+ * Nothing is read while no alert is raised. On an alert the devices
+ * asserting SMBALERT# on the bus are found with the Alert Response Address
+ * and only their STATUS_WORD is read, followed by the STATUS_VOUT,
+ * STATUS_IOUT, STATUS_INPUT, STATUS_TEMPERATURE and STATUS_CML bytes the
+ * word flags. The status bits are latched by the devices: once the report
+ * of an alert is captured, CLEAR_FAULTS is sent and the status read again to
+ * keep only the conditions still present. Once the alert is gone the PSUs
+ * left with conditions are cleared and read again the same way.
+ */
+
+#pragma once
+
+#include "pmbus.hpp"
+#include "telemetry_sampler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nvidia::power::pmbus
+{
+
+/** @brief status registers of a PSU, the bytes are 0 when not flagged */
+struct StatusReport
+{
+    uint16_t word = 0;
+    uint8_t vout = 0;
+    uint8_t iout = 0;
+    uint8_t input = 0;
+    uint8_t temperature = 0;
+    uint8_t cml = 0;
+
+    bool operator==(const StatusReport&) const = default;
+};
+
+namespace status
+{
+/** @brief bits of STATUS_WORD, the low byte is STATUS_BYTE */
+static constexpr uint16_t none = 1 << 0;
+static constexpr uint16_t cml = 1 << 1;
+static constexpr uint16_t temperature = 1 << 2;
+static constexpr uint16_t vinUvFault = 1 << 3;
+static constexpr uint16_t ioutOcFault = 1 << 4;
+static constexpr uint16_t voutOvFault = 1 << 5;
+static constexpr uint16_t off = 1 << 6;
+static constexpr uint16_t busy = 1 << 7;
+static constexpr uint16_t unknown = 1 << 8;
+static constexpr uint16_t other = 1 << 9;
+static constexpr uint16_t fans = 1 << 10;
+static constexpr uint16_t powerGoodNegated = 1 << 11;
+static constexpr uint16_t mfrSpecific = 1 << 12;
+static constexpr uint16_t input = 1 << 13;
+static constexpr uint16_t ioutPout = 1 << 14;
+static constexpr uint16_t vout = 1 << 15;
+} // namespace status
+
+/** @brief names of the bits of a status register, from bit 7 to bit 0,
+ * empty for a reserved bit */
+using BitNames = std::array<const char*, 8>;
+
+static constexpr BitNames statusWordHighNames = {
+    "VOUT",
+    "IOUT_POUT",
+    "INPUT",
+    "MFR_SPECIFIC",
+    "POWER_GOOD_NEGATED",
+    "FANS",
+    "OTHER",
+    "UNKNOWN",
+};
+static constexpr BitNames statusByteNames = {
+    "BUSY",
+    "OFF",
+    "VOUT_OV_FAULT",
+    "IOUT_OC_FAULT",
+    "VIN_UV_FAULT",
+    "TEMPERATURE",
+    "CML",
+    "",
+};
+static constexpr BitNames statusVoutNames = {
+    "VOUT_OV_FAULT",
+    "VOUT_OV_WARNING",
+    "VOUT_UV_WARNING",
+    "VOUT_UV_FAULT",
+    "VOUT_MAX_WARNING",
+    "TON_MAX_FAULT",
+    "TOFF_MAX_WARNING",
+    "VOUT_TRACKING_ERROR",
+};
+static constexpr BitNames statusIoutNames = {
+    "IOUT_OC_FAULT",
+    "IOUT_OC_LV_FAULT",
+    "IOUT_OC_WARNING",
+    "IOUT_UC_FAULT",
+    "CURRENT_SHARE_FAULT",
+    "POWER_LIMITING",
+    "POUT_OP_FAULT",
+    "POUT_OP_WARNING",
+};
+static constexpr BitNames statusInputNames = {
+    "VIN_OV_FAULT",
+    "VIN_OV_WARNING",
+    "VIN_UV_WARNING",
+    "VIN_UV_FAULT",
+    "UNIT_OFF_LOW_INPUT",
+    "IIN_OC_FAULT",
+    "IIN_OC_WARNING",
+    "PIN_OP_WARNING",
+};
+static constexpr BitNames statusTemperatureNames = {
+    "OT_FAULT",
+    "OT_WARNING",
+    "UT_WARNING",
+    "UT_FAULT",
+    "",
+    "",
+    "",
+    "",
+};
+static constexpr BitNames statusCmlNames = {
+    "INVALID_COMMAND",
+    "INVALID_DATA",
+    "PEC_FAILED",
+    "MEMORY_FAULT",
+    "PROCESSOR_FAULT",
+    "",
+    "OTHER_COMMUNICATION_FAULT",
+    "OTHER_MEMORY_LOGIC_FAULT",
+};
+
+/**
+ * @brief names of the conditions of a report, the summary bits of the word
+ * are omitted when the byte they summarize was read
+ */
+inline std::vector<std::string> faultNames(const StatusReport& report)
+{
+    std::vector<std::string> names;
+    auto add = [&names](uint8_t bits, const BitNames& bitNames) {
+        for (int bit = 7; bit >= 0; bit--)
+        {
+            const char* name = bitNames[7 - bit];
+            if (bits & (1 << bit) && *name)
+            {
+                names.emplace_back(name);
+            }
+        }
+    };
+    add(report.vout, statusVoutNames);
+    add(report.iout, statusIoutNames);
+    add(report.input, statusInputNames);
+    add(report.temperature, statusTemperatureNames);
+    add(report.cml, statusCmlNames);
+
+    uint16_t word = report.word;
+    // detailed by the bytes above
+    word &= ~((report.vout ? status::vout | status::voutOvFault : 0) |
+              (report.iout ? status::ioutPout | status::ioutOcFault : 0) |
+              (report.input ? status::input | status::vinUvFault : 0) |
+              (report.temperature ? status::temperature : 0) |
+              (report.cml ? status::cml : 0));
+    add(static_cast<uint8_t>(word >> 8), statusWordHighNames);
+    add(static_cast<uint8_t>(word), statusByteNames);
+    return names;
+}
+
+/** @brief the report holds a fault rather than warnings only */
+inline bool hasFault(const StatusReport& report)
+{
+    for (const auto& name : faultNames(report))
+    {
+        if (name.find("FAULT") != std::string::npos || name == "OFF" ||
+            name == "POWER_GOOD_NEGATED")
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Read the status of a device
+ *
+ * @param[in] bus - bus of the device
+ * @param[in] address - 7 bit address of the device
+ * @param[in] pec - read and check the packet error code
+ * @param[out] report - STATUS_WORD and the bytes it flags
+ * @param[out] transactions - incremented by the transactions done
+ * @return false if STATUS_WORD could not be read
+ */
+inline bool readStatus(PmbusBus& bus, uint8_t address, bool pec,
+                       StatusReport& report, uint64_t& transactions)
+{
+    report = StatusReport{};
+    transactions++;
+    if (readWord(bus, address, command::statusWord, pec, report.word) !=
+        ReadStatus::Ok)
+    {
+        return false;
+    }
+    auto detail = [&](uint16_t mask, uint8_t code, uint8_t& value) {
+        if (report.word & mask)
+        {
+            transactions++;
+            // a byte which cannot be read leaves the summary bit
+            readByte(bus, address, code, pec, value);
+        }
+    };
+    detail(status::vout | status::voutOvFault, command::statusVout,
+           report.vout);
+    detail(status::ioutPout | status::ioutOcFault, command::statusIout,
+           report.iout);
+    detail(status::input | status::vinUvFault, command::statusInput,
+           report.input);
+    detail(status::temperature, command::statusTemperature,
+           report.temperature);
+    detail(status::cml, command::statusCml, report.cml);
+    return true;
+}
+
+/**
+ * @class FaultMonitor
+ *
+ * Last status report of each PSU, read on alerts only.
+ */
+class FaultMonitor
+{
+  public:
+    /** @brief devices answering the alert response address in one alert,
+     * more is a device which does not release SMBALERT# */
+    static constexpr int maxAlertResponses = 16;
+
+    FaultMonitor(const std::vector<TelemetryConfig>& configs,
+                 TelemetrySampler::BusFactory openBus) :
+        configs(configs),
+        openBus(std::move(openBus)), reports(configs.size())
+    {}
+
+    /**
+     * @brief Read the status of the PSUs asserting SMBALERT# on a bus
+     *
+     * @param[in] busNumber - bus of the alert
+     * @param[in] suspect - PSU the alert is known to come from, read if no
+     * device answers the alert response address
+     * @return PSUs whose report changed
+     */
+    std::vector<size_t> alert(int busNumber,
+                              std::optional<size_t> suspect = std::nullopt)
+    {
+        std::vector<size_t> changed;
+        auto bus = getBus(busNumber);
+        if (!bus)
+        {
+            return changed;
+        }
+
+        std::vector<size_t> asserting;
+        uint8_t address = 0;
+        for (int i = 0; i < maxAlertResponses; i++)
+        {
+            transactionCount++;
+            if (!alertResponse(*bus, address))
+            {
+                break;
+            }
+            auto psu = findPsu(busNumber, address);
+            if (!psu)
+            {
+                std::cerr << "SMBALERT# from unknown device 0x" << std::hex
+                          << static_cast<int>(address) << std::dec
+                          << " on bus " << busNumber << "\n";
+                continue;
+            }
+            if (std::find(asserting.begin(), asserting.end(), *psu) ==
+                asserting.end())
+            {
+                asserting.push_back(*psu);
+            }
+        }
+        if (asserting.empty() && suspect)
+        {
+            // SMBALERT# not wired or already released
+            asserting.push_back(*suspect);
+        }
+
+        for (auto psu : asserting)
+        {
+            if (update(*bus, psu))
+            {
+                changed.push_back(psu);
+            }
+        }
+        return changed;
+    }
+
+    /**
+     * @brief Clear the latched status of the PSUs of a bus left with
+     * conditions and read it again, called once the reports of an alert
+     * were captured
+     *
+     * @param[in] busNumber - bus of the alert
+     * @return PSUs whose report changed, their conditions which went away
+     */
+    std::vector<size_t> clear(int busNumber)
+    {
+        std::vector<size_t> changed;
+        auto bus = getBus(busNumber);
+        if (!bus)
+        {
+            return changed;
+        }
+        for (size_t psu = 0; psu < configs.size(); psu++)
+        {
+            if (configs[psu].bus == busNumber &&
+                reports[psu] != StatusReport{} && clearFaults(*bus, psu))
+            {
+                changed.push_back(psu);
+            }
+        }
+        return changed;
+    }
+
+    /**
+     * @brief Clear and read again a PSU left with conditions, once its
+     * alert is gone
+     *
+     * @param[in] psu - PSU index
+     * @return true if its report changed
+     */
+    bool recheck(size_t psu)
+    {
+        if (reports[psu] == StatusReport{})
+        {
+            return false;
+        }
+        auto bus = getBus(configs[psu].bus);
+        return bus && clearFaults(*bus, psu);
+    }
+
+    const StatusReport& report(size_t psu) const
+    {
+        return reports[psu];
+    }
+
+    size_t size() const
+    {
+        return configs.size();
+    }
+
+    const TelemetryConfig& config(size_t psu) const
+    {
+        return configs[psu];
+    }
+
+    /** @brief transactions since the start, none without alerts */
+    uint64_t transactions() const
+    {
+        return transactionCount;
+    }
+
+  private:
+    PmbusBus* getBus(int busNumber)
+    {
+        auto& bus = buses[busNumber];
+        if (!bus)
+        {
+            try
+            {
+                bus = openBus(busNumber);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Error: PMBus bus " << busNumber << ": "
+                          << e.what() << "\n";
+            }
+        }
+        return bus.get();
+    }
+
+    std::optional<size_t> findPsu(int busNumber, uint8_t address) const
+    {
+        for (size_t i = 0; i < configs.size(); i++)
+        {
+            if (configs[i].bus == busNumber && configs[i].address == address)
+            {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /** @brief send CLEAR_FAULTS to a PSU and read the conditions still
+     * present, the report is kept if either fails */
+    bool clearFaults(PmbusBus& bus, size_t psu)
+    {
+        transactionCount++;
+        if (!sendByte(bus, configs[psu].address, command::clearFaults,
+                      configs[psu].pec))
+        {
+            std::cerr << "Error: CLEAR_FAULTS of " << configs[psu].name
+                      << " failed\n";
+            return false;
+        }
+        return update(bus, psu);
+    }
+
+    /** @brief read the status of a PSU, the report is kept if it fails */
+    bool update(PmbusBus& bus, size_t psu)
+    {
+        StatusReport report;
+        if (!readStatus(bus, configs[psu].address, configs[psu].pec, report,
+                        transactionCount))
+        {
+            std::cerr << "Error: STATUS_WORD of " << configs[psu].name
+                      << " failed\n";
+            return false;
+        }
+        if (report == reports[psu])
+        {
+            return false;
+        }
+        reports[psu] = report;
+        return true;
+    }
+
+    std::vector<TelemetryConfig> configs;
+    TelemetrySampler::BusFactory openBus;
+    std::map<int, std::unique_ptr<PmbusBus>> buses;
+    std::vector<StatusReport> reports;
+    uint64_t transactionCount = 0;
+};
+
+} // namespace nvidia::power::pmbus
@@ -16,6 +16,7 @@
  */
 
 #include "psu_manager.hpp"
+#include "startup_profiler.hpp"
 
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/bus.hpp>
@@ -24,6 +25,7 @@
 #include <filesystem>
 
 using namespace nvidia::power;
+using nvidia::startup::startupProfiler;
 
 int main(void)
 {
@@ -31,16 +33,25 @@ int main(void)
     {
         using namespace phosphor::logging;
 
+        auto connectPhase = startupProfiler().phase("connect");
         auto bus = sdbusplus::bus::new_default();
         auto event = sdeventplus::Event::get_default();
+        connectPhase.stop();
 
         sdbusplus::server::manager::manager objManager(bus, OBJ_MANAGER_PATH);
 
+        auto namePhase = startupProfiler().phase("request-name");
         bus.request_name(BUSNAME);
+        namePhase.stop();
         bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
 
         manager::PSUManager manager(bus, BASE_INV_PATH);
 
+        startupProfiler().ready();
+        startupProfiler().publish(bus, MANAGER_OBJ_PATH);
+        log<level::INFO>(
+            startupProfiler().summary("nvidia-power-supply-monitor").c_str());
+
         return event.loop();
     }
     catch (const std::exception& e)
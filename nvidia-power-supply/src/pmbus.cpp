@@ -0,0 +1,169 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmbus.hpp"
+
+#include "i2c.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace nvidia::power::pmbus
+{
+
+/** @brief bytes of the longest transaction with its pec, a block read of
+ * 32 bytes */
+static constexpr size_t maxTransaction = 40;
+
+double decodeLinear11(uint16_t raw)
+{
+    // sign extend both fields
+    int exponent = static_cast<int16_t>(raw) >> 11;
+    int mantissa = static_cast<int16_t>(raw << 5) >> 5;
+    return std::ldexp(mantissa, exponent);
+}
+
+uint8_t packetErrorCode(const uint8_t* bytes, size_t count)
+{
+    static I2c i2c;
+    if (count == 0 || count >= maxTransaction)
+    {
+        return 0;
+    }
+    // calculate_PEC prepends the first byte and appends the code
+    uint8_t data[maxTransaction] = {};
+    std::copy(bytes + 1, bytes + count, data);
+    i2c.calculate_PEC(data, bytes[0], static_cast<int>(count - 1));
+    return data[count - 1];
+}
+
+ReadStatus readWord(PmbusBus& bus, uint8_t address, uint8_t code, bool pec,
+                    uint16_t& value)
+{
+    uint8_t read[3] = {};
+    if (bus.transfer(address, &code, 1, read, pec ? 3 : 2) < 0)
+    {
+        return ReadStatus::IoError;
+    }
+    if (pec)
+    {
+        const uint8_t transaction[] = {static_cast<uint8_t>(address << 1),
+                                       code,
+                                       static_cast<uint8_t>(address << 1 | 1),
+                                       read[0], read[1]};
+        if (packetErrorCode(transaction, sizeof(transaction)) != read[2])
+        {
+            return ReadStatus::PecMismatch;
+        }
+    }
+    value = static_cast<uint16_t>(read[1] << 8 | read[0]);
+    return ReadStatus::Ok;
+}
+
+ReadStatus readByte(PmbusBus& bus, uint8_t address, uint8_t code, bool pec,
+                    uint8_t& value)
+{
+    uint8_t read[2] = {};
+    if (bus.transfer(address, &code, 1, read, pec ? 2 : 1) < 0)
+    {
+        return ReadStatus::IoError;
+    }
+    if (pec)
+    {
+        const uint8_t transaction[] = {static_cast<uint8_t>(address << 1),
+                                       code,
+                                       static_cast<uint8_t>(address << 1 | 1),
+                                       read[0]};
+        if (packetErrorCode(transaction, sizeof(transaction)) != read[1])
+        {
+            return ReadStatus::PecMismatch;
+        }
+    }
+    value = read[0];
+    return ReadStatus::Ok;
+}
+
+bool sendByte(PmbusBus& bus, uint8_t address, uint8_t code, bool pec)
+{
+    const uint8_t transaction[] = {static_cast<uint8_t>(address << 1), code};
+    const uint8_t write[] = {
+        code, packetErrorCode(transaction, sizeof(transaction))};
+    return bus.transfer(address, write, pec ? 2 : 1, nullptr, 0) >= 0;
+}
+
+bool alertResponse(PmbusBus& bus, uint8_t& address)
+{
+    uint8_t read = 0;
+    if (bus.transfer(alertResponseAddress, nullptr, 0, &read, 1) < 0)
+    {
+        return false;
+    }
+    // the address comes in the upper 7 bits
+    address = read >> 1;
+    return true;
+}
+
+I2cPmbusBus::I2cPmbusBus(int bus)
+{
+    auto path = "/dev/i2c-" + std::to_string(bus);
+    fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::runtime_error("open " + path + ": " + strerror(errno));
+    }
+}
+
+I2cPmbusBus::~I2cPmbusBus()
+{
+    close(fd);
+}
+
+int I2cPmbusBus::transfer(uint8_t address, const uint8_t* write,
+                          size_t writeCount, uint8_t* read, size_t readCount)
+{
+    struct i2c_msg msg[2] = {};
+    size_t count = 0;
+    if (writeCount)
+    {
+        msg[count].addr = address;
+        msg[count].flags = 0;
+        msg[count].len = static_cast<uint16_t>(writeCount);
+        msg[count].buf = const_cast<uint8_t*>(write);
+        count++;
+    }
+    if (readCount)
+    {
+        msg[count].addr = address;
+        msg[count].flags = I2C_M_RD;
+        msg[count].len = static_cast<uint16_t>(readCount);
+        msg[count].buf = read;
+        count++;
+    }
+
+    struct i2c_rdwr_ioctl_data msgset = {};
+    msgset.msgs = msg;
+    msgset.nmsgs = static_cast<uint32_t>(count);
+    if (ioctl(fd, I2C_RDWR, &msgset) < 0)
+    {
+        return -errno;
+    }
+    return 0;
+}
+
+} // namespace nvidia::power::pmbus
@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nvidia::power::pmbus
+{
+
+/** @brief PMBus command codes */
+namespace command
+{
+static constexpr uint8_t clearFaults = 0x03;
+static constexpr uint8_t statusWord = 0x79;
+static constexpr uint8_t statusVout = 0x7a;
+static constexpr uint8_t statusIout = 0x7b;
+static constexpr uint8_t statusInput = 0x7c;
+static constexpr uint8_t statusTemperature = 0x7d;
+static constexpr uint8_t statusCml = 0x7e;
+static constexpr uint8_t readVin = 0x88;
+static constexpr uint8_t readIin = 0x89;
+static constexpr uint8_t readTemperature1 = 0x8d;
+static constexpr uint8_t readPout = 0x96;
+static constexpr uint8_t readPin = 0x97;
+} // namespace command
+
+/** @brief SMBus Alert Response Address, answered by the devices asserting
+ * SMBALERT# */
+static constexpr uint8_t alertResponseAddress = 0x0c;
+
+/**
+ * @brief Decode a PMBus LINEAR11 word
+ *
+ * @param[in] raw - 5 bit two's complement exponent over an 11 bit two's
+ * complement mantissa
+ * @return mantissa * 2^exponent
+ */
+double decodeLinear11(uint16_t raw);
+
+/**
+ * @brief SMBus packet error code, CRC-8 of all the bytes of a transaction
+ *
+ * @param[in] bytes - address and data bytes, the address bytes with their
+ * read/write bit
+ * @param[in] count - number of bytes
+ */
+uint8_t packetErrorCode(const uint8_t* bytes, size_t count);
+
+/*
+ * @class PmbusBus
+ *
+ * Transactions with the devices of an i2c bus.
+ */
+class PmbusBus
+{
+  public:
+    virtual ~PmbusBus() = default;
+
+    /**
+     * @brief write bytes then read bytes with a repeated start, a plain
+     * read when nothing is written
+     *
+     * @param[in] address - 7 bit address of the device
+     * @param[in] write - bytes written
+     * @param[in] writeCount - number of bytes written
+     * @param[out] read - bytes read
+     * @param[in] readCount - number of bytes read
+     * @return 0 on success, -errno on failure
+     */
+    virtual int transfer(uint8_t address, const uint8_t* write,
+                         size_t writeCount, uint8_t* read,
+                         size_t readCount) = 0;
+};
+
+enum class ReadStatus
+{
+    Ok,
+    /** @brief the device did not answer */
+    IoError,
+    /** @brief the answer was corrupted on the bus */
+    PecMismatch,
+};
+
+/**
+ * @brief Read a PMBus word
+ *
+ * @param[in] bus - bus of the device
+ * @param[in] address - 7 bit address of the device
+ * @param[in] code - command code
+ * @param[in] pec - read and check the packet error code
+ * @param[out] value - word read
+ */
+ReadStatus readWord(PmbusBus& bus, uint8_t address, uint8_t code, bool pec,
+                    uint16_t& value);
+
+/**
+ * @brief Read a PMBus byte
+ *
+ * @param[in] bus - bus of the device
+ * @param[in] address - 7 bit address of the device
+ * @param[in] code - command code
+ * @param[in] pec - read and check the packet error code
+ * @param[out] value - byte read
+ */
+ReadStatus readByte(PmbusBus& bus, uint8_t address, uint8_t code, bool pec,
+                    uint8_t& value);
+
+/**
+ * @brief Send a PMBus command without data, e.g. CLEAR_FAULTS
+ *
+ * @param[in] bus - bus of the device
+ * @param[in] address - 7 bit address of the device
+ * @param[in] code - command code
+ * @param[in] pec - append the packet error code
+ * @return false if the device did not accept the command
+ */
+bool sendByte(PmbusBus& bus, uint8_t address, uint8_t code, bool pec);
+
+/**
+ * @brief Read the Alert Response Address
+ *
+ * The device with the lowest address among those asserting SMBALERT#
+ * answers with its address and releases SMBALERT#.
+ *
+ * @param[in] bus - bus of the devices
+ * @param[out] address - 7 bit address of the device which answered
+ * @return false if no device asserts SMBALERT#
+ */
+bool alertResponse(PmbusBus& bus, uint8_t& address);
+
+/*
+ * @class I2cPmbusBus
+ *
+ * i2c bus device kept open, one I2C_RDWR ioctl per transaction. A failed
+ * transaction is not retried, the next sample reads the device again.
+ */
+class I2cPmbusBus : public PmbusBus
+{
+  public:
+    /**
+     * @param bus - i2c bus number
+     * @throw std::runtime_error if the bus cannot be opened
+     */
+    explicit I2cPmbusBus(int bus);
+    ~I2cPmbusBus() override;
+
+    I2cPmbusBus(const I2cPmbusBus&) = delete;
+    I2cPmbusBus& operator=(const I2cPmbusBus&) = delete;
+
+    int transfer(uint8_t address, const uint8_t* write, size_t writeCount,
+                 uint8_t* read, size_t readCount) override;
+
+  private:
+    int fd;
+};
+
+} // namespace nvidia::power::pmbus
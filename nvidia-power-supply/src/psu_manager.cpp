@@ -17,19 +17,65 @@
 
 #include "psu_manager.hpp"
 
+#include "startup_profiler.hpp"
+
 #include <fmt/format.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <xyz/openbmc_project/Common/Device/error.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <regex>
+#include <variant>
 
 using namespace phosphor::logging;
 using namespace sdbusplus::xyz::openbmc_project::Common::Device::Error;
 using namespace nvidia::power::common;
+using nvidia::startup::startupProfiler;
+
+namespace
+{
+
+using Level = sdbusplus::xyz::openbmc_project::Logging::server::Entry::Level;
+
+/** @brief create a log entry of a redfish message */
+void createLog(sdbusplus::bus::bus& bus, const std::string& messageId,
+               Level level, std::map<std::string, std::string>& addData)
+{
+    try
+    {
+        addData["REDFISH_MESSAGE_ID"] = messageId;
+        auto method = bus.new_method_call(
+            "xyz.openbmc_project.Logging", "/xyz/openbmc_project/logging",
+            "xyz.openbmc_project.Logging.Create", "Create");
+        method.append(messageId,
+                      sdbusplus::xyz::openbmc_project::Logging::server::
+                          convertForMessage(level),
+                      addData);
+        bus.call_noreply(method);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Failed to create log " << messageId << ": " << e.what()
+                  << "\n";
+    }
+}
+
+std::string join(const std::vector<std::string>& names)
+{
+    std::string joined;
+    for (const auto& name : names)
+    {
+        joined += (joined.empty() ? "" : " ") + name;
+    }
+    return joined;
+}
+
+} // namespace
 
 namespace nvidia::power::manager
 {
@@ -40,7 +86,9 @@ PSUManager::PSUManager(sdbusplus::bus::bus& bus, std::string baseInvPath) :
 
     using namespace sdeventplus;
 
+    auto jsonPhase = startupProfiler().phase("json-parse");
     nlohmann::json fruJson = loadJSONFile(PSU_JSON_PATH);
+    jsonPhase.stop();
     if (fruJson == nullptr)
     {
         log<level::ERR>("InternalFailure when parsing the JSON file");
@@ -56,6 +104,8 @@ PSUManager::PSUManager(sdbusplus::bus::bus& bus, std::string baseInvPath) :
         std::cerr << e.what() << std::endl;
     }
 
+    std::vector<pmbus::TelemetryConfig> telemetryConfigs;
+    std::vector<std::string> telemetryPaths;
     for (const auto& fru : fruJson.at("PowerSupplies"))
     {
         try
@@ -72,15 +122,223 @@ PSUManager::PSUManager(sdbusplus::bus::bus& bus, std::string baseInvPath) :
                 continue;
             }
 
+            // the inventory properties are read by running the command
+            // utility, this dominates the start up time
+            auto popenPhase = startupProfiler().phase("popen");
             auto psu = std::make_unique<PowerSupply>(bus, invpath,
                                                      cmdUtilityName, id, assoc);
+            popenPhase.stop();
             psus.emplace_back(std::move(psu));
+
+            if (fru.contains("Telemetry"))
+            {
+                const auto& pmbusJson = fru["Telemetry"];
+                telemetryConfigs.push_back(pmbus::TelemetryConfig{
+                    "PSU" + id, pmbusJson.at("Bus").get<int>(),
+                    pmbusJson.at("Address").get<uint8_t>(),
+                    pmbusJson.value("Pec", true)});
+                telemetryPaths.push_back(invpath);
+            }
         }
         catch (const std::exception& e)
         {
             std::cerr << e.what() << std::endl;
         }
     }
+
+    if (!telemetryConfigs.empty())
+    {
+        startTelemetry(telemetryConfigs,
+                       fruJson.value("TelemetryPeriodMs", 1000u));
+        startFaultMonitor(telemetryConfigs, telemetryPaths);
+    }
+}
+
+void PSUManager::startTelemetry(
+    const std::vector<pmbus::TelemetryConfig>& configs, uint64_t periodMs)
+{
+    using Unit = sdbusplus::xyz::openbmc_project::Sensor::server::Value::Unit;
+    struct SensorType
+    {
+        const char* type;
+        const char* suffix;
+        Unit unit;
+    };
+    // indexed like pmbus::Reading
+    static const std::array<SensorType, pmbus::readingCount> sensorTypes = {{
+        {"power", "Input_Power", Unit::Watts},
+        {"power", "Output_Power", Unit::Watts},
+        {"voltage", "Input_Voltage", Unit::Volts},
+        {"current", "Input_Current", Unit::Amperes},
+        {"temperature", "Temperature", Unit::DegreesC},
+    }};
+
+    telemetry = std::make_unique<pmbus::TelemetrySampler>(
+        configs, [](int busNumber) -> std::unique_ptr<pmbus::PmbusBus> {
+            return std::make_unique<pmbus::I2cPmbusBus>(busNumber);
+        });
+    for (const auto& config : configs)
+    {
+        auto& sensors = telemetrySensors.emplace_back();
+        for (size_t i = 0; i < pmbus::readingCount; i++)
+        {
+            std::string path = std::string("/xyz/openbmc_project/sensors/") +
+                               sensorTypes[i].type + "/" + config.name + "_" +
+                               sensorTypes[i].suffix;
+            sensors[i] = std::make_unique<SensorValueObject>(
+                bus, path.c_str(), SensorValueObject::action::defer_emit);
+            sensors[i]->unit(sensorTypes[i].unit);
+            sensors[i]->value(NAN);
+            sensors[i]->emit_object_added();
+        }
+    }
+
+    auto pmbusPhase = startupProfiler().phase("pmbus-initial-read");
+    sampleTelemetry();
+    pmbusPhase.stop();
+
+    telemetryTimer = std::make_unique<
+        sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>>(
+        sdeventplus::Event::get_default(),
+        [this](auto&) { sampleTelemetry(); },
+        std::chrono::milliseconds(periodMs));
+}
+
+void PSUManager::sampleTelemetry()
+{
+    telemetry->sample();
+    for (size_t psu = 0; psu < telemetrySensors.size(); psu++)
+    {
+        for (size_t i = 0; i < pmbus::readingCount; i++)
+        {
+            auto& sensor = telemetrySensors[psu][i];
+            auto value = telemetry->value(psu, static_cast<pmbus::Reading>(i));
+            // PropertiesChanged is only emitted for a changed value, NaN
+            // never compares equal
+            if (std::isnan(value) && std::isnan(sensor->value()))
+            {
+                continue;
+            }
+            sensor->value(value);
+        }
+    }
+}
+
+void PSUManager::startFaultMonitor(
+    const std::vector<pmbus::TelemetryConfig>& configs,
+    const std::vector<std::string>& paths)
+{
+    faultMonitor = std::make_unique<pmbus::FaultMonitor>(
+        configs, [](int busNumber) -> std::unique_ptr<pmbus::PmbusBus> {
+            return std::make_unique<pmbus::I2cPmbusBus>(busNumber);
+        });
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        faultInterfaces.push_back(
+            std::make_unique<FaultInterface>(bus, paths[i]));
+        pmbusPsus[paths[i]] = i;
+    }
+
+    // nvidia-psu-monitor turns the PowerState of a PSU off while the cpld
+    // alert bit of the PSU is set
+    alertMatch = std::make_unique<sdbusplus::bus::match::match>(
+        bus,
+        sdbusplus::bus::match::rules::propertiesChangedNamespace(
+            baseInventoryPath,
+            "xyz.openbmc_project.State.Decorator.PowerState"),
+        [this](sdbusplus::message::message& msg) { onPowerState(msg); });
+}
+
+void PSUManager::onPowerState(sdbusplus::message::message& msg)
+{
+    auto psu = pmbusPsus.find(msg.get_path());
+    if (psu == pmbusPsus.end())
+    {
+        return;
+    }
+    std::string iface;
+    std::map<std::string, std::variant<std::string>> changed;
+    try
+    {
+        msg.read(iface, changed);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return;
+    }
+    auto state = changed.find("PowerState");
+    if (state == changed.end())
+    {
+        return;
+    }
+    const auto& value = std::get<std::string>(state->second);
+    if (value.ends_with(".Off"))
+    {
+        const auto& config = faultMonitor->config(psu->second);
+        for (auto alerted : faultMonitor->alert(config.bus, psu->second))
+        {
+            publishFaults(alerted);
+        }
+        // the latched conditions are logged, clear them to publish the ones
+        // still present
+        for (auto cleared : faultMonitor->clear(config.bus))
+        {
+            publishFaults(cleared);
+        }
+    }
+    else if (faultMonitor->recheck(psu->second))
+    {
+        publishFaults(psu->second);
+    }
+}
+
+void PSUManager::publishFaults(size_t psu)
+{
+    const auto& report = faultMonitor->report(psu);
+    const auto& config = faultMonitor->config(psu);
+    auto& faultInterface = faultInterfaces[psu];
+    auto oldNames = faultInterface->names();
+    faultInterface->update(report);
+
+    std::vector<std::string> added;
+    for (const auto& name : faultInterface->names())
+    {
+        if (std::find(oldNames.begin(), oldNames.end(), name) ==
+            oldNames.end())
+        {
+            added.push_back(name);
+        }
+    }
+
+    std::map<std::string, std::string> addData;
+    addData["STATUS_WORD"] = fmt::format("0x{:04x}", report.word);
+    if (!added.empty())
+    {
+        addData["FAULTS"] = join(faultInterface->names());
+        addData["REDFISH_MESSAGE_ARGS"] = config.name;
+        log<level::ERR>(fmt::format("{} PMBus status {}", config.name,
+                                    addData["FAULTS"])
+                            .c_str());
+        if (pmbus::hasFault(report))
+        {
+            createLog(bus, "OpenBMC.0.1.PowerSupplyFailed", Level::Critical,
+                      addData);
+        }
+        else
+        {
+            createLog(bus, "OpenBMC.0.1.PowerSupplyFailurePredicted",
+                      Level::Warning, addData);
+        }
+    }
+    else if (faultInterface->names().empty() && !oldNames.empty())
+    {
+        addData["REDFISH_MESSAGE_ARGS"] = config.name + "," + join(oldNames);
+        log<level::INFO>(
+            fmt::format("{} PMBus status cleared", config.name).c_str());
+        createLog(bus, "ResourceEvent.1.0.ResourceErrorsCorrected",
+                  Level::Informational, addData);
+    }
 }
 
 } // namespace nvidia::power::manager
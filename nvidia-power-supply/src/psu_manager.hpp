@@ -19,13 +19,21 @@
 
 #include "config.h"
 
+#include "fault_interface.hpp"
+#include "fault_monitor.hpp"
 #include "power_supply.hpp"
+#include "telemetry_sampler.hpp"
 
 #include <nlohmann/json.hpp>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/bus/match.hpp>
 #include <sdeventplus/event.hpp>
 #include <sdeventplus/utility/timer.hpp>
+#include <xyz/openbmc_project/Logging/Entry/server.hpp>
+#include <xyz/openbmc_project/Sensor/Value/server.hpp>
+
+#include <array>
+#include <map>
 
 using namespace nvidia::power::psu;
 using namespace phosphor::logging;
@@ -34,6 +42,9 @@ using json = nlohmann::json;
 namespace nvidia::power::manager
 {
 
+using SensorValueObject = sdbusplus::server::object::object<
+    sdbusplus::xyz::openbmc_project::Sensor::server::Value>;
+
 /**
  * @brief Power supply manager is collection of Power supplies
  *        manages the power supplies
@@ -75,6 +86,69 @@ class PSUManager
      *
      */
     std::string baseInventoryPath;
+
+    /** @brief PMBus readings of the PSUs with a Telemetry object */
+    std::unique_ptr<pmbus::TelemetrySampler> telemetry;
+
+    /** @brief sensor of each reading of each sampled PSU */
+    std::vector<std::array<std::unique_ptr<SensorValueObject>,
+                           pmbus::readingCount>>
+        telemetrySensors;
+
+    std::unique_ptr<
+        sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>>
+        telemetryTimer;
+
+    /**
+     * @brief create the sensors of the sampled PSUs and start sampling
+     *
+     * @param configs - PMBus device of each sampled PSU
+     * @param periodMs - sampling period
+     */
+    void startTelemetry(const std::vector<pmbus::TelemetryConfig>& configs,
+                        uint64_t periodMs);
+
+    /**
+     * @brief sample all buses and update the sensors
+     */
+    void sampleTelemetry();
+
+    /** @brief PMBus status of the sampled PSUs, read on alerts */
+    std::unique_ptr<pmbus::FaultMonitor> faultMonitor;
+
+    /** @brief fault properties of each sampled PSU */
+    std::vector<std::unique_ptr<FaultInterface>> faultInterfaces;
+
+    /** @brief sampled PSU of each inventory path */
+    std::map<std::string, size_t> pmbusPsus;
+
+    /** @brief PowerState of the inventory, driven by the cpld alert bit */
+    std::unique_ptr<sdbusplus::bus::match::match> alertMatch;
+
+    /**
+     * @brief publish the faults of the sampled PSUs and watch their alerts
+     *
+     * @param configs - PMBus device of each sampled PSU
+     * @param paths - inventory path of each sampled PSU
+     */
+    void startFaultMonitor(const std::vector<pmbus::TelemetryConfig>& configs,
+                           const std::vector<std::string>& paths);
+
+    /**
+     * @brief read the status of the PSUs on an alert, then clear their
+     * latched conditions, and clear a PSU left with conditions once its
+     * alert is gone
+     *
+     * @param msg - PropertiesChanged of a PowerState
+     */
+    void onPowerState(sdbusplus::message::message& msg);
+
+    /**
+     * @brief publish the report of a PSU and log its new conditions
+     *
+     * @param psu - sampled PSU index
+     */
+    void publishFaults(size_t psu);
 };
 
 } // namespace nvidia::power::manager
@@ -0,0 +1,213 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Sampling of the PSU telemetry over PMBus.
+ *
+ * The PSUs are grouped by bus. Each bus is opened once and kept open, and a
+ * pass reads all PSUs of a bus back to back, one word per reading. A PSU
+ * not answering a reading is skipped for the rest of the pass, so an absent
+ * PSU costs one transaction per pass.
+ */
+
+#pragma once
+
+#include "pmbus.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nvidia::power::pmbus
+{
+
+/** @brief readings of a PSU, in the order they are read */
+enum class Reading
+{
+    InputPower,
+    OutputPower,
+    InputVoltage,
+    InputCurrent,
+    Temperature,
+};
+
+static constexpr size_t readingCount = 5;
+
+/** @brief command code of each reading */
+static constexpr std::array<uint8_t, readingCount> readingCommands = {
+    command::readPin, command::readPout, command::readVin, command::readIin,
+    command::readTemperature1};
+
+struct TelemetryConfig
+{
+    /** @brief name of the PSU in the sensor names */
+    std::string name;
+    int bus;
+    /** @brief 7 bit PMBus address */
+    uint8_t address;
+    bool pec = true;
+};
+
+/**
+ * @class TelemetrySampler
+ *
+ * Last readings of each PSU, NaN when a reading failed.
+ */
+class TelemetrySampler
+{
+  public:
+    /** @brief opens a bus, throws if the bus cannot be opened */
+    using BusFactory = std::function<std::unique_ptr<PmbusBus>(int bus)>;
+
+    TelemetrySampler(const std::vector<TelemetryConfig>& configs,
+                     BusFactory openBus) :
+        configs(configs),
+        openBus(std::move(openBus))
+    {
+        std::map<int, std::vector<size_t>> psusOfBus;
+        for (size_t i = 0; i < configs.size(); i++)
+        {
+            psusOfBus[configs[i].bus].push_back(i);
+        }
+        for (auto& [number, psus] : psusOfBus)
+        {
+            buses.push_back(BusState{number, nullptr, std::move(psus), false});
+        }
+        readings.resize(configs.size());
+        for (auto& values : readings)
+        {
+            values.fill(NAN);
+        }
+    }
+
+    /** @brief read every reading of every PSU, one bus after the other */
+    void sample()
+    {
+        for (auto& bus : buses)
+        {
+            samplePass(bus);
+        }
+    }
+
+    double value(size_t psu, Reading reading) const
+    {
+        return readings[psu][static_cast<size_t>(reading)];
+    }
+
+    size_t size() const
+    {
+        return configs.size();
+    }
+
+    const TelemetryConfig& config(size_t psu) const
+    {
+        return configs[psu];
+    }
+
+    /** @brief transactions since the start */
+    uint64_t transactions() const
+    {
+        return transactionCount;
+    }
+
+    /** @brief readings without an answer */
+    uint64_t readErrors() const
+    {
+        return readErrorCount;
+    }
+
+    /** @brief readings corrupted on the bus */
+    uint64_t pecErrors() const
+    {
+        return pecErrorCount;
+    }
+
+  private:
+    struct BusState
+    {
+        int number;
+        std::unique_ptr<PmbusBus> bus;
+        std::vector<size_t> psus;
+        bool openFailed = false;
+    };
+
+    void samplePass(BusState& state)
+    {
+        if (!state.bus)
+        {
+            try
+            {
+                state.bus = openBus(state.number);
+            }
+            catch (const std::exception& e)
+            {
+                // tried again on each pass, logged once
+                if (!state.openFailed)
+                {
+                    std::cerr << "Error: PMBus bus " << state.number << ": "
+                              << e.what() << "\n";
+                }
+                state.openFailed = true;
+            }
+        }
+        for (auto psu : state.psus)
+        {
+            auto& values = readings[psu];
+            values.fill(NAN);
+            if (!state.bus)
+            {
+                continue;
+            }
+            const auto& config = configs[psu];
+            for (size_t i = 0; i < readingCount; i++)
+            {
+                uint16_t raw = 0;
+                transactionCount++;
+                auto status = readWord(*state.bus, config.address,
+                                       readingCommands[i], config.pec, raw);
+                if (status == ReadStatus::PecMismatch)
+                {
+                    pecErrorCount++;
+                    continue;
+                }
+                if (status != ReadStatus::Ok)
+                {
+                    // absent or hung, the other readings would fail too
+                    readErrorCount++;
+                    break;
+                }
+                values[i] = decodeLinear11(raw);
+            }
+        }
+    }
+
+    std::vector<TelemetryConfig> configs;
+    BusFactory openBus;
+    std::vector<BusState> buses;
+    std::vector<std::array<double, readingCount>> readings;
+    uint64_t transactionCount = 0;
+    uint64_t readErrorCount = 0;
+    uint64_t pecErrorCount = 0;
+};
+
+} // namespace nvidia::power::pmbus
@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Cost of a telemetry pass of the PSUs of a bus against the PMBus
+ * simulator:
+ *
+ *   bench_pmbus_pass [psus] [passes]
+ *
+ * The simulator answers at once, the time measured is the cpu time of the
+ * sampler and the pec check. The bus time is modeled from the bits of the
+ * transactions, each read word with pec being a start, the address and
+ * command bytes, a repeated start, the address and 3 data bytes and a stop,
+ * all bytes with their ack.
+ */
+
+#include "pmbus_simulator.hpp"
+#include "telemetry_sampler.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using namespace nvidia::power::pmbus;
+
+/** @brief bus bits of a read word with pec */
+static constexpr double readWordBits = 1 + 2 * 9 + 1 + 4 * 9 + 1;
+
+int main(int argc, char** argv)
+{
+    int psus = argc > 1 ? std::stoi(argv[1]) : 6;
+    int passes = argc > 2 ? std::stoi(argv[2]) : 100000;
+
+    PmbusSimulator simulator;
+    std::vector<TelemetryConfig> configs;
+    for (int i = 0; i < psus; i++)
+    {
+        auto address = static_cast<uint8_t>(0x58 + i);
+        for (auto code : readingCommands)
+        {
+            simulator.set(address, code, 100.0 + i);
+        }
+        configs.push_back(TelemetryConfig{"PSU" + std::to_string(i), 0,
+                                          address, true});
+    }
+
+    struct Forward : public PmbusBus
+    {
+        explicit Forward(PmbusSimulator& simulator) : simulator(simulator)
+        {}
+
+        int transfer(uint8_t address, const uint8_t* write,
+                     size_t writeCount, uint8_t* read,
+                     size_t readCount) override
+        {
+            return simulator.transfer(address, write, writeCount, read,
+                                      readCount);
+        }
+
+        PmbusSimulator& simulator;
+    };
+    TelemetrySampler sampler(configs, [&simulator](int) {
+        return std::make_unique<Forward>(simulator);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < passes; i++)
+    {
+        sampler.sample();
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    double transactions = static_cast<double>(sampler.transactions()) / passes;
+    std::printf("%d psus: %.0f transactions, %.2f us cpu per pass\n", psus,
+                transactions, elapsed.count() / passes);
+    std::printf("bus time per pass: %.2f ms at 100 kHz, %.2f ms at 400 kHz\n",
+                transactions * readWordBits / 100, transactions *
+                readWordBits / 400);
+    if (sampler.pecErrors() || sampler.readErrors())
+    {
+        std::fprintf(stderr, "unexpected errors\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "pmbus.hpp"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <map>
+
+/**
+ * @brief LINEAR11 word of a value, with the smallest exponent keeping the
+ * mantissa in range
+ */
+inline uint16_t encodeLinear11(double value)
+{
+    for (int exponent = -16; exponent < 16; exponent++)
+    {
+        auto mantissa = std::lround(std::ldexp(value, -exponent));
+        if (mantissa >= -1024 && mantissa <= 1023)
+        {
+            return static_cast<uint16_t>((exponent & 0x1f) << 11 |
+                                         (mantissa & 0x7ff));
+        }
+    }
+    return 0x7bff;
+}
+
+/**
+ * PMBus devices of a simulated i2c bus, answering words, bytes and the
+ * Alert Response Address. The status registers are latched until
+ * CLEAR_FAULTS resets them to the conditions still present. The pec is
+ * computed bit by bit, independently of the Crc helper.
+ */
+class PmbusSimulator : public nvidia::power::pmbus::PmbusBus
+{
+  public:
+    struct Device
+    {
+        std::map<uint8_t, uint16_t> words;
+        std::map<uint8_t, uint8_t> bytes;
+        /** @brief next answers with a corrupted pec */
+        int corruptPec = 0;
+        /** @brief the device does not answer */
+        bool hung = false;
+        /** @brief SMBALERT# asserted, released by the alert response */
+        bool alerting = false;
+        /** @brief SMBALERT# not released by the alert response */
+        bool stuck = false;
+        /** @brief status conditions still present, the status registers
+         * are reset to them by CLEAR_FAULTS, 0 when not listed */
+        std::map<uint8_t, uint16_t> liveWords;
+        std::map<uint8_t, uint8_t> liveBytes;
+        /** @brief CLEAR_FAULTS received */
+        int clears = 0;
+    };
+
+    int transfer(uint8_t address, const uint8_t* write, size_t writeCount,
+                 uint8_t* read, size_t readCount) override
+    {
+        transactions++;
+        if (address == nvidia::power::pmbus::alertResponseAddress)
+        {
+            return alertResponse(writeCount, read, readCount);
+        }
+        auto device = devices.find(address);
+        if (device == devices.end() || device->second.hung)
+        {
+            return -ENXIO;
+        }
+        if (readCount == 0)
+        {
+            return sendByte(address, device->second, write, writeCount);
+        }
+        if (writeCount != 1 || readCount < 1 || readCount > 3)
+        {
+            return -EINVAL;
+        }
+        // a word, or a byte, with its pec
+        size_t dataCount = 0;
+        if (auto word = device->second.words.find(write[0]);
+            word != device->second.words.end() && readCount >= 2)
+        {
+            read[0] = static_cast<uint8_t>(word->second);
+            read[1] = static_cast<uint8_t>(word->second >> 8);
+            dataCount = 2;
+        }
+        else if (auto byte = device->second.bytes.find(write[0]);
+                 byte != device->second.bytes.end() && readCount <= 2)
+        {
+            read[0] = byte->second;
+            dataCount = 1;
+        }
+        else
+        {
+            return -EIO;
+        }
+        if (readCount > dataCount)
+        {
+            const uint8_t header[] = {static_cast<uint8_t>(address << 1),
+                                      write[0],
+                                      static_cast<uint8_t>(address << 1 | 1)};
+            uint8_t crc = pec(read, dataCount, pec(header, sizeof(header)));
+            if (device->second.corruptPec > 0)
+            {
+                device->second.corruptPec--;
+                crc ^= 0x01;
+            }
+            read[dataCount] = crc;
+        }
+        return 0;
+    }
+
+    /** @brief set a reading of a device */
+    void set(uint8_t address, uint8_t code, double value)
+    {
+        devices[address].words[code] = encodeLinear11(value);
+    }
+
+    /** @brief set a status byte of a device */
+    void setByte(uint8_t address, uint8_t code, uint8_t value)
+    {
+        devices[address].bytes[code] = value;
+    }
+
+    std::map<uint8_t, Device> devices;
+    uint64_t transactions = 0;
+
+  private:
+    static uint8_t pec(const uint8_t* bytes, size_t count, uint8_t crc = 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            crc ^= bytes[i];
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = static_cast<uint8_t>(crc & 0x80 ? crc << 1 ^ 0x07
+                                                      : crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    /** @brief a command without data, only CLEAR_FAULTS is supported */
+    static int sendByte(uint8_t address, Device& device, const uint8_t* write,
+                        size_t writeCount)
+    {
+        using namespace nvidia::power::pmbus;
+        if (writeCount < 1 || writeCount > 2 ||
+            write[0] != command::clearFaults)
+        {
+            return -EIO;
+        }
+        const uint8_t transaction[] = {static_cast<uint8_t>(address << 1),
+                                       write[0]};
+        if (writeCount == 2 &&
+            pec(transaction, sizeof(transaction)) != write[1])
+        {
+            return -EIO;
+        }
+        device.clears++;
+        if (device.words.contains(command::statusWord))
+        {
+            device.words[command::statusWord] =
+                device.liveWords[command::statusWord];
+        }
+        for (uint8_t code = command::statusVout; code <= command::statusCml;
+             code++)
+        {
+            if (device.bytes.contains(code))
+            {
+                device.bytes[code] = device.liveBytes[code];
+            }
+        }
+        return 0;
+    }
+
+    /** @brief the lowest alerting address wins the arbitration */
+    int alertResponse(size_t writeCount, uint8_t* read, size_t readCount)
+    {
+        if (writeCount != 0 || readCount != 1)
+        {
+            return -EINVAL;
+        }
+        for (auto& [address, device] : devices)
+        {
+            if (device.alerting && !device.hung)
+            {
+                device.alerting = device.stuck;
+                // bit 0 is don't care
+                read[0] = static_cast<uint8_t>(address << 1 | 1);
+                return 0;
+            }
+        }
+        return -ENXIO;
+    }
+};
@@ -0,0 +1,264 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fault_monitor.hpp"
+#include "pmbus_simulator.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::power::pmbus;
+
+using Names = std::vector<std::string>;
+
+TEST(FaultNames, Healthy)
+{
+    EXPECT_TRUE(faultNames(StatusReport{}).empty());
+    EXPECT_FALSE(hasFault(StatusReport{}));
+}
+
+TEST(FaultNames, SummaryBitsWithoutDetail)
+{
+    StatusReport report;
+    report.word = status::off | status::powerGoodNegated | status::fans;
+    EXPECT_EQ(faultNames(report),
+              (Names{"POWER_GOOD_NEGATED", "FANS", "OFF"}));
+    EXPECT_TRUE(hasFault(report));
+}
+
+TEST(FaultNames, DetailReplacesSummary)
+{
+    StatusReport report;
+    report.word = status::input | status::vinUvFault | status::off |
+                  status::temperature;
+    report.input = 0x18;
+    report.temperature = 0x40;
+    EXPECT_EQ(faultNames(report), (Names{"VIN_UV_FAULT", "UNIT_OFF_LOW_INPUT",
+                                         "OT_WARNING", "OFF"}));
+}
+
+TEST(FaultNames, WarningsOnly)
+{
+    StatusReport report;
+    report.word = status::temperature | status::ioutPout;
+    report.temperature = 0x40;
+    report.iout = 0x21;
+    EXPECT_EQ(faultNames(report),
+              (Names{"IOUT_OC_WARNING", "POUT_OP_WARNING", "OT_WARNING"}));
+    EXPECT_FALSE(hasFault(report));
+}
+
+class FaultMonitorTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        for (uint8_t address : {0x58, 0x59, 0x5a})
+        {
+            simulator.set(address, command::readPin, 1000.0);
+            simulator.devices[address].words[command::statusWord] = 0;
+        }
+    }
+
+    FaultMonitor monitor()
+    {
+        return FaultMonitor(configs, [this](int) {
+            return std::make_unique<Forward>(simulator);
+        });
+    }
+
+    /** @brief a psu raises an input under voltage fault */
+    void raiseInputFault(uint8_t address)
+    {
+        auto& device = simulator.devices[address];
+        device.words[command::statusWord] =
+            status::input | status::vinUvFault | status::off;
+        device.bytes[command::statusInput] = 0x18;
+        device.liveWords = device.words;
+        device.liveBytes = device.bytes;
+        device.alerting = true;
+    }
+
+    /** @brief the input of a psu recovers, its status stays latched */
+    void endInputFault(uint8_t address)
+    {
+        auto& device = simulator.devices[address];
+        device.liveWords.clear();
+        device.liveBytes.clear();
+    }
+
+    struct Forward : public PmbusBus
+    {
+        explicit Forward(PmbusSimulator& simulator) : simulator(simulator)
+        {}
+
+        int transfer(uint8_t address, const uint8_t* write,
+                     size_t writeCount, uint8_t* read,
+                     size_t readCount) override
+        {
+            return simulator.transfer(address, write, writeCount, read,
+                                      readCount);
+        }
+
+        PmbusSimulator& simulator;
+    };
+
+    std::vector<TelemetryConfig> configs{
+        {"PSU0", 3, 0x58}, {"PSU1", 3, 0x59}, {"PSU2", 3, 0x5a}};
+    PmbusSimulator simulator;
+};
+
+TEST_F(FaultMonitorTest, NoAlertNoBusTime)
+{
+    auto faults = monitor();
+    EXPECT_EQ(faults.transactions(), 0u);
+    EXPECT_EQ(simulator.transactions, 0u);
+}
+
+TEST_F(FaultMonitorTest, AlertReadsOnlyTheAssertingPsu)
+{
+    auto faults = monitor();
+    raiseInputFault(0x59);
+    EXPECT_EQ(faults.alert(3), (std::vector<size_t>{1}));
+    EXPECT_EQ(faults.report(1).input, 0x18);
+    EXPECT_EQ(faultNames(faults.report(1)),
+              (Names{"VIN_UV_FAULT", "UNIT_OFF_LOW_INPUT", "OFF"}));
+    EXPECT_EQ(faults.report(0), StatusReport{});
+    // two alert responses, STATUS_WORD and STATUS_INPUT
+    EXPECT_EQ(simulator.transactions, 4u);
+    EXPECT_EQ(faults.transactions(), 4u);
+}
+
+TEST_F(FaultMonitorTest, SeveralPsusAlerting)
+{
+    auto faults = monitor();
+    raiseInputFault(0x5a);
+    raiseInputFault(0x58);
+    EXPECT_EQ(faults.alert(3), (std::vector<size_t>{0, 2}));
+    EXPECT_FALSE(simulator.devices[0x58].alerting);
+    EXPECT_FALSE(simulator.devices[0x5a].alerting);
+
+    // the same status again is not a change
+    simulator.devices[0x58].alerting = true;
+    EXPECT_TRUE(faults.alert(3).empty());
+}
+
+TEST_F(FaultMonitorTest, SuspectReadWithoutAlertResponse)
+{
+    auto faults = monitor();
+    raiseInputFault(0x59);
+    simulator.devices[0x59].alerting = false;
+    EXPECT_TRUE(faults.alert(3).empty());
+    EXPECT_EQ(faults.alert(3, 1), (std::vector<size_t>{1}));
+}
+
+TEST_F(FaultMonitorTest, RecheckClearsTheFault)
+{
+    auto faults = monitor();
+    // a healthy psu is not read
+    EXPECT_FALSE(faults.recheck(0));
+    EXPECT_EQ(simulator.transactions, 0u);
+
+    raiseInputFault(0x58);
+    faults.alert(3);
+    EXPECT_TRUE(hasFault(faults.report(0)));
+
+    // CLEAR_FAULTS keeps the condition while it is present
+    EXPECT_FALSE(faults.recheck(0));
+    EXPECT_TRUE(hasFault(faults.report(0)));
+    EXPECT_EQ(simulator.devices[0x58].clears, 1);
+
+    endInputFault(0x58);
+    EXPECT_TRUE(faults.recheck(0));
+    EXPECT_EQ(faults.report(0), StatusReport{});
+    EXPECT_EQ(simulator.devices[0x58].clears, 2);
+}
+
+TEST_F(FaultMonitorTest, StatusLatchedUntilCleared)
+{
+    auto faults = monitor();
+    raiseInputFault(0x58);
+    EXPECT_EQ(faults.alert(3), (std::vector<size_t>{0}));
+    endInputFault(0x58);
+
+    // reading the status again does not clear it
+    simulator.devices[0x58].alerting = true;
+    EXPECT_TRUE(faults.alert(3).empty());
+    EXPECT_TRUE(hasFault(faults.report(0)));
+
+    // the captured report is cleared once CLEAR_FAULTS is sent, healthy
+    // psus are left alone
+    auto transactions = simulator.transactions;
+    EXPECT_EQ(faults.clear(3), (std::vector<size_t>{0}));
+    EXPECT_EQ(faults.report(0), StatusReport{});
+    EXPECT_EQ(simulator.devices[0x58].clears, 1);
+    EXPECT_EQ(simulator.devices[0x59].clears, 0);
+    // CLEAR_FAULTS and STATUS_WORD
+    EXPECT_EQ(simulator.transactions, transactions + 2);
+    EXPECT_TRUE(faults.clear(3).empty());
+}
+
+TEST_F(FaultMonitorTest, ClearKeepsTheLiveConditions)
+{
+    auto faults = monitor();
+    raiseInputFault(0x59);
+    // an over temperature warning which went away before the alert
+    auto& device = simulator.devices[0x59];
+    device.words[command::statusWord] |= status::temperature;
+    device.bytes[command::statusTemperature] = 0x40;
+    EXPECT_EQ(faults.alert(3), (std::vector<size_t>{1}));
+    EXPECT_EQ(faultNames(faults.report(1)),
+              (Names{"VIN_UV_FAULT", "UNIT_OFF_LOW_INPUT", "OT_WARNING",
+                     "OFF"}));
+
+    EXPECT_EQ(faults.clear(3), (std::vector<size_t>{1}));
+    EXPECT_EQ(faultNames(faults.report(1)),
+              (Names{"VIN_UV_FAULT", "UNIT_OFF_LOW_INPUT", "OFF"}));
+}
+
+TEST_F(FaultMonitorTest, FailedClearKeepsTheReport)
+{
+    auto faults = monitor();
+    raiseInputFault(0x58);
+    faults.alert(3);
+    endInputFault(0x58);
+    simulator.devices[0x58].hung = true;
+    EXPECT_TRUE(faults.clear(3).empty());
+    EXPECT_TRUE(hasFault(faults.report(0)));
+}
+
+TEST_F(FaultMonitorTest, CorruptedStatusKeepsTheReport)
+{
+    auto faults = monitor();
+    raiseInputFault(0x58);
+    simulator.devices[0x58].corruptPec = 1;
+    EXPECT_TRUE(faults.alert(3).empty());
+    EXPECT_EQ(faults.report(0), StatusReport{});
+
+    simulator.devices[0x58].alerting = true;
+    EXPECT_EQ(faults.alert(3), (std::vector<size_t>{0}));
+}
+
+TEST_F(FaultMonitorTest, StuckAlertIsBounded)
+{
+    auto faults = monitor();
+    raiseInputFault(0x58);
+    simulator.devices[0x58].stuck = true;
+    EXPECT_EQ(faults.alert(3), (std::vector<size_t>{0}));
+    // the psu is read once however many times it answers
+    EXPECT_EQ(simulator.transactions,
+              FaultMonitor::maxAlertResponses + 2u);
+}
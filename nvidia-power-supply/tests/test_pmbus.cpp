@@ -0,0 +1,219 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmbus.hpp"
+#include "pmbus_simulator.hpp"
+#include "telemetry_sampler.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::power::pmbus;
+
+TEST(Linear11, Decode)
+{
+    EXPECT_EQ(decodeLinear11(0x0000), 0.0);
+    // exponent -2, mantissa 100
+    EXPECT_EQ(decodeLinear11(0xf064), 25.0);
+    // exponent 0, mantissa -1
+    EXPECT_EQ(decodeLinear11(0x07ff), -1.0);
+    // exponent 1, mantissa 1023
+    EXPECT_EQ(decodeLinear11(0x0bff), 2046.0);
+    // exponent -16, mantissa -1024
+    EXPECT_EQ(decodeLinear11(0x8400), -1024.0 / 65536);
+}
+
+TEST(Linear11, SimulatorRoundTrip)
+{
+    for (double value : {0.0, 12.25, 54.5, -3.0, 230.0, 1450.0, 3000.0})
+    {
+        EXPECT_NEAR(decodeLinear11(encodeLinear11(value)), value,
+                    std::abs(value) / 1000);
+    }
+}
+
+TEST(PacketErrorCode, KnownValues)
+{
+    // CRC-8 check value
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    EXPECT_EQ(packetErrorCode(check, sizeof(check)), 0xf4);
+    // READ_PIN of 0x58 answering 0x1234
+    const uint8_t readPin[] = {0xb0, 0x97, 0xb1, 0x34, 0x12};
+    EXPECT_EQ(packetErrorCode(readPin, sizeof(readPin)), 0xa7);
+}
+
+TEST(ReadWord, Pec)
+{
+    PmbusSimulator simulator;
+    simulator.set(0x58, command::readVin, 230.0);
+    uint16_t raw = 0;
+    ASSERT_EQ(readWord(simulator, 0x58, command::readVin, true, raw),
+              ReadStatus::Ok);
+    EXPECT_EQ(decodeLinear11(raw), 230.0);
+
+    simulator.devices[0x58].corruptPec = 1;
+    EXPECT_EQ(readWord(simulator, 0x58, command::readVin, true, raw),
+              ReadStatus::PecMismatch);
+    // without pec the corruption goes unnoticed
+    simulator.devices[0x58].corruptPec = 1;
+    EXPECT_EQ(readWord(simulator, 0x58, command::readVin, false, raw),
+              ReadStatus::Ok);
+
+    EXPECT_EQ(readWord(simulator, 0x59, command::readVin, true, raw),
+              ReadStatus::IoError);
+}
+
+class TelemetrySamplerTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        for (uint8_t address : {0x58, 0x59})
+        {
+            auto& simulator = simulators[3];
+            simulator.set(address, command::readPin, 1450.0);
+            simulator.set(address, command::readPout, 1300.0);
+            simulator.set(address, command::readVin, 230.0);
+            simulator.set(address, command::readIin, 6.25);
+            simulator.set(address, command::readTemperature1, 41.5);
+        }
+        simulators[4].set(0x58, command::readPin, 900.0);
+        simulators[4].set(0x58, command::readPout, 850.0);
+        simulators[4].set(0x58, command::readVin, 231.0);
+        simulators[4].set(0x58, command::readIin, 4.0);
+        simulators[4].set(0x58, command::readTemperature1, 38.0);
+    }
+
+    TelemetrySampler::BusFactory factory()
+    {
+        return [this](int bus) -> std::unique_ptr<PmbusBus> {
+            opens++;
+            if (busMissing)
+            {
+                throw std::runtime_error("no such bus");
+            }
+            // the sampler owns its bus, forward to the simulator
+            return std::make_unique<Forward>(simulators.at(bus));
+        };
+    }
+
+    struct Forward : public PmbusBus
+    {
+        explicit Forward(PmbusSimulator& simulator) : simulator(simulator)
+        {}
+
+        int transfer(uint8_t address, const uint8_t* write,
+                     size_t writeCount, uint8_t* read,
+                     size_t readCount) override
+        {
+            return simulator.transfer(address, write, writeCount, read,
+                                      readCount);
+        }
+
+        PmbusSimulator& simulator;
+    };
+
+    std::vector<TelemetryConfig> configs{{"PSU0", 3, 0x58},
+                                         {"PSU1", 4, 0x58},
+                                         {"PSU2", 3, 0x59},
+                                         {"PSU3", 3, 0x5a}};
+    std::map<int, PmbusSimulator> simulators;
+    int opens = 0;
+    bool busMissing = false;
+};
+
+TEST_F(TelemetrySamplerTest, ReadsEveryPsu)
+{
+    TelemetrySampler sampler(configs, factory());
+    sampler.sample();
+    EXPECT_EQ(sampler.value(0, Reading::InputPower), 1450.0);
+    EXPECT_EQ(sampler.value(0, Reading::OutputPower), 1300.0);
+    EXPECT_EQ(sampler.value(0, Reading::InputVoltage), 230.0);
+    EXPECT_EQ(sampler.value(0, Reading::InputCurrent), 6.25);
+    EXPECT_EQ(sampler.value(0, Reading::Temperature), 41.5);
+    EXPECT_EQ(sampler.value(1, Reading::InputPower), 900.0);
+    EXPECT_EQ(sampler.value(2, Reading::InputPower), 1450.0);
+}
+
+TEST_F(TelemetrySamplerTest, AbsentPsuCostsOneTransaction)
+{
+    TelemetrySampler sampler(configs, factory());
+    sampler.sample();
+    EXPECT_TRUE(std::isnan(sampler.value(3, Reading::InputPower)));
+    EXPECT_TRUE(std::isnan(sampler.value(3, Reading::Temperature)));
+    // 3 present psus with 5 readings, 1 failed read of the absent one
+    EXPECT_EQ(sampler.transactions(), 16u);
+    EXPECT_EQ(simulators[3].transactions, 11u);
+    EXPECT_EQ(simulators[4].transactions, 5u);
+    EXPECT_EQ(sampler.readErrors(), 1u);
+}
+
+TEST_F(TelemetrySamplerTest, BusesStayOpen)
+{
+    TelemetrySampler sampler(configs, factory());
+    for (int pass = 0; pass < 10; pass++)
+    {
+        sampler.sample();
+    }
+    EXPECT_EQ(opens, 2);
+    EXPECT_EQ(sampler.transactions(), 160u);
+}
+
+TEST_F(TelemetrySamplerTest, CorruptedReadingIsNaN)
+{
+    TelemetrySampler sampler(configs, factory());
+    simulators[4].devices[0x58].corruptPec = 1;
+    sampler.sample();
+    // only the first reading of the psu is lost
+    EXPECT_TRUE(std::isnan(sampler.value(1, Reading::InputPower)));
+    EXPECT_EQ(sampler.value(1, Reading::OutputPower), 850.0);
+    EXPECT_EQ(sampler.pecErrors(), 1u);
+
+    sampler.sample();
+    EXPECT_EQ(sampler.value(1, Reading::InputPower), 900.0);
+}
+
+TEST_F(TelemetrySamplerTest, HungPsuRecovers)
+{
+    TelemetrySampler sampler(configs, factory());
+    sampler.sample();
+    simulators[3].devices[0x59].hung = true;
+    sampler.sample();
+    EXPECT_TRUE(std::isnan(sampler.value(2, Reading::InputPower)));
+    EXPECT_EQ(sampler.value(0, Reading::InputPower), 1450.0);
+
+    simulators[3].devices[0x59].hung = false;
+    simulators[3].set(0x59, command::readPin, 1500.0);
+    sampler.sample();
+    EXPECT_EQ(sampler.value(2, Reading::InputPower), 1500.0);
+}
+
+TEST_F(TelemetrySamplerTest, MissingBusIsRetried)
+{
+    busMissing = true;
+    TelemetrySampler sampler(configs, factory());
+    sampler.sample();
+    EXPECT_TRUE(std::isnan(sampler.value(0, Reading::InputPower)));
+    EXPECT_EQ(sampler.transactions(), 0u);
+
+    busMissing = false;
+    sampler.sample();
+    EXPECT_EQ(sampler.value(0, Reading::InputPower), 1450.0);
+    EXPECT_EQ(opens, 4);
+}
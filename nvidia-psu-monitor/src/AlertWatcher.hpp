@@ -0,0 +1,138 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+namespace nvidia::psumonitor
+{
+
+/*
+ * @class AlertLine
+ *
+ * Input line raising edge events, such as the PSU alert line of the cpld.
+ */
+class AlertLine
+{
+  public:
+    virtual ~AlertLine() = default;
+
+    /** @brief descriptor readable while edge events are pending, owned by
+     * the line */
+    virtual int eventFd() const = 0;
+
+    /**
+     * @brief consume the pending edge events
+     * @return number of events consumed, -1 on failure
+     */
+    virtual int readEvents() = 0;
+};
+
+/*
+ * @class AlertWatcher
+ *
+ * Waits for the edge events of an alert line on the io service and calls
+ * back once per batch of events.
+ */
+class AlertWatcher
+{
+  public:
+    AlertWatcher(boost::asio::io_service& io, std::unique_ptr<AlertLine> line,
+                 std::function<void()> onAlert) :
+        line(std::move(line)),
+        descriptor(io), onAlert(std::move(onAlert))
+    {}
+
+    ~AlertWatcher()
+    {
+        stop();
+    }
+
+    AlertWatcher(const AlertWatcher&) = delete;
+    AlertWatcher& operator=(const AlertWatcher&) = delete;
+
+    void start()
+    {
+        if (!descriptor.is_open())
+        {
+            descriptor.assign(line->eventFd());
+        }
+        wait();
+    }
+
+    void stop()
+    {
+        if (descriptor.is_open())
+        {
+            boost::system::error_code ec;
+            descriptor.cancel(ec);
+            // the descriptor belongs to the line
+            descriptor.release();
+        }
+    }
+
+    /** @brief the line is watched */
+    bool watching() const
+    {
+        return descriptor.is_open();
+    }
+
+    /** @brief edge events consumed */
+    uint64_t events() const
+    {
+        return eventCount;
+    }
+
+  private:
+    void wait()
+    {
+        descriptor.async_wait(
+            boost::asio::posix::stream_descriptor::wait_read,
+            [this](const boost::system::error_code& ec) {
+                if (ec == boost::asio::error::operation_aborted)
+                {
+                    return;
+                }
+                int count = ec ? -1 : line->readEvents();
+                if (count < 0)
+                {
+                    // polling still covers the registers
+                    std::cerr << "Error: PSU alert line failed, "
+                              << "falling back to polling\n";
+                    stop();
+                    return;
+                }
+                eventCount += count;
+                onAlert();
+                wait();
+            });
+    }
+
+    std::unique_ptr<AlertLine> line;
+    boost::asio::posix::stream_descriptor descriptor;
+    std::function<void()> onAlert;
+    uint64_t eventCount = 0;
+};
+
+} // namespace nvidia::psumonitor
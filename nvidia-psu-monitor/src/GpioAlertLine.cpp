@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GpioAlertLine.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace nvidia::psumonitor
+{
+
+GpioAlertLine::GpioAlertLine(const std::string& name, const std::string& edge,
+                             bool activeLow)
+{
+    int type = gpiod::line_request::EVENT_FALLING_EDGE;
+    if (edge == "Rising")
+    {
+        type = gpiod::line_request::EVENT_RISING_EDGE;
+    }
+    else if (edge == "Both")
+    {
+        type = gpiod::line_request::EVENT_BOTH_EDGES;
+    }
+    else if (edge != "Falling")
+    {
+        throw std::runtime_error("invalid PSU alert edge " + edge);
+    }
+
+    line = gpiod::find_line(name);
+    if (!line)
+    {
+        throw std::runtime_error("PSU alert gpio " + name + " not found");
+    }
+
+    gpiod::line_request request{"nvidia-psu-monitor", type, 0};
+    if (activeLow)
+    {
+        request.flags = gpiod::line_request::FLAG_ACTIVE_LOW;
+    }
+    line.request(request);
+}
+
+int GpioAlertLine::eventFd() const
+{
+    return line.event_get_fd();
+}
+
+int GpioAlertLine::readEvents()
+{
+    try
+    {
+        return static_cast<int>(line.event_read_multiple().size());
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+}
+
+} // namespace nvidia::psumonitor
@@ -0,0 +1,54 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "AlertWatcher.hpp"
+
+#include <gpiod.hpp>
+
+#include <string>
+
+namespace nvidia::psumonitor
+{
+
+/*
+ * @class GpioAlertLine
+ *
+ * Alert line read through libgpiod edge events.
+ */
+class GpioAlertLine : public AlertLine
+{
+  public:
+    /**
+     * @param name - gpio line name
+     * @param edge - "Falling", "Rising" or "Both"
+     * @param activeLow - the line is active low
+     * @throw std::runtime_error if the line cannot be requested
+     */
+    GpioAlertLine(const std::string& name, const std::string& edge,
+                  bool activeLow);
+
+    int eventFd() const override;
+
+    int readEvents() override;
+
+  private:
+    gpiod::line line;
+};
+
+} // namespace nvidia::psumonitor
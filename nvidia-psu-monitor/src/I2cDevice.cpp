@@ -0,0 +1,156 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "I2cDevice.hpp"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+extern "C"
+{
+#include <i2c/smbus.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+}
+
+namespace nvidia::psumonitor
+{
+
+I2cDevice::I2cDevice(int bus, int address, bool blockRead) :
+    bus(bus), address(address), blockRead(blockRead)
+{}
+
+I2cDevice::~I2cDevice()
+{
+    closeDevice();
+}
+
+int I2cDevice::openDevice()
+{
+    std::string i2cBus = "/dev/i2c-" + std::to_string(bus);
+
+    fd = open(i2cBus.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        std::cerr << "unable to open i2c device " << i2cBus << "\n";
+        return -1;
+    }
+    opens++;
+
+    // the address is only used by the SMBus fallback
+    if (ioctl(fd, I2C_SLAVE_FORCE, address) < 0)
+    {
+        std::cerr << "unable to set device address\n";
+        closeDevice();
+        return -1;
+    }
+
+    unsigned long funcs = 0;
+    if (ioctl(fd, I2C_FUNCS, &funcs) < 0)
+    {
+        std::cerr << "not support I2C_FUNCS \n";
+        closeDevice();
+        return -1;
+    }
+    combined = funcs & I2C_FUNC_I2C;
+    if (!combined && !(funcs & I2C_FUNC_SMBUS_READ_BYTE_DATA))
+    {
+        std::cerr << "not support I2C_FUNC_SMBUS_READ_BYTE_DATA \n";
+        closeDevice();
+        return -1;
+    }
+    return 0;
+}
+
+void I2cDevice::closeDevice()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+int I2cDevice::readRegisters(const std::vector<uint8_t>& registers,
+                             std::vector<int32_t>& values)
+{
+    values.assign(registers.size(), -1);
+    if (registers.empty() || (fd < 0 && openDevice() < 0))
+    {
+        return -1;
+    }
+
+    if (combined)
+    {
+        bool contiguous = true;
+        for (size_t i = 1; i < registers.size(); i++)
+        {
+            contiguous = contiguous && registers[i] == registers[0] + i;
+        }
+
+        // a register address write followed by a read with a repeated start
+        // for every register, or once for all of them
+        size_t reads = blockRead && contiguous ? 1 : registers.size();
+        std::vector<uint8_t> addresses(registers);
+        std::vector<uint8_t> data(registers.size());
+        std::vector<i2c_msg> msgs(2 * reads);
+        for (size_t i = 0; i < reads; i++)
+        {
+            msgs[2 * i].addr = static_cast<uint16_t>(address);
+            msgs[2 * i].flags = 0;
+            msgs[2 * i].len = 1;
+            msgs[2 * i].buf = &addresses[i];
+            msgs[2 * i + 1].addr = static_cast<uint16_t>(address);
+            msgs[2 * i + 1].flags = I2C_M_RD;
+            msgs[2 * i + 1].len =
+                static_cast<uint16_t>(reads == 1 ? registers.size() : 1);
+            msgs[2 * i + 1].buf = &data[i];
+        }
+        i2c_rdwr_ioctl_data msgset{msgs.data(),
+                                   static_cast<uint32_t>(msgs.size())};
+        if (ioctl(fd, I2C_RDWR, &msgset) < 0)
+        {
+            std::cerr << "i2c combined read failed: " << strerror(errno)
+                      << "\n";
+            closeDevice();
+            return -1;
+        }
+        values.assign(data.begin(), data.end());
+        return 0;
+    }
+
+    for (size_t i = 0; i < registers.size(); i++)
+    {
+        int32_t value = i2c_smbus_read_byte_data(fd, registers[i]);
+        if (value < 0)
+        {
+            std::cerr << "i2c_smbus_read_byte_data failed \n";
+            values.assign(registers.size(), -1);
+            closeDevice();
+            return -1;
+        }
+        values[i] = value;
+    }
+    return 0;
+}
+
+} // namespace nvidia::psumonitor
@@ -0,0 +1,79 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "PsuTopology.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace nvidia::psumonitor
+{
+
+/*
+ * @class I2cDevice
+ *
+ * Byte registers of an i2c device read over a bus file descriptor which is
+ * kept open between reads and reopened only after an error.
+ */
+class I2cDevice : public RegisterSource
+{
+  public:
+    /**
+     * @param bus - i2c bus number
+     * @param address - 7 bit slave address
+     * @param blockRead - read contiguous registers with a single read, the
+     * device must increment the register address by itself
+     */
+    I2cDevice(int bus, int address, bool blockRead = false);
+
+    ~I2cDevice() override;
+
+    I2cDevice(const I2cDevice&) = delete;
+    I2cDevice& operator=(const I2cDevice&) = delete;
+
+    /**
+     * @brief read byte registers in one combined I2C_RDWR transaction, or
+     * one SMBus read per register if the adapter only supports SMBus
+     * @param registers - register addresses
+     * @param values - register values, -1 for all of them on failure
+     * @return 0 on success, -1 on failure
+     */
+    int readRegisters(const std::vector<uint8_t>& registers,
+                      std::vector<int32_t>& values) override;
+
+    /** @brief number of times the bus was opened */
+    uint64_t openCount() const
+    {
+        return opens;
+    }
+
+  private:
+    int openDevice();
+    void closeDevice();
+
+    int bus;
+    int address;
+    bool blockRead;
+    int fd = -1;
+    /** @brief the adapter supports plain i2c transfers */
+    bool combined = false;
+    uint64_t opens = 0;
+};
+
+} // namespace nvidia::psumonitor
@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace nvidia::psumonitor
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct PollPolicy
+{
+    /** @brief period while something is happening */
+    uint32_t fastMs = 100;
+    /** @brief period once everything is stable */
+    uint32_t idleMs = 5000;
+    /** @brief time polled at the fast period after the last activity */
+    uint32_t fastWindowMs = 10000;
+    /** @brief growth of the period per poll after the window */
+    double decay = 2.0;
+};
+
+/*
+ * @class PollSchedule
+ *
+ * Poll period which drops to the fast period on any register change or i2c
+ * error, stays there for a window and then grows back to the idle period.
+ */
+class PollSchedule
+{
+  public:
+    explicit PollSchedule(const PollPolicy& policy = PollPolicy{}) :
+        policy(policy)
+    {
+        this->policy.fastMs = std::max<uint32_t>(this->policy.fastMs, 1);
+        this->policy.idleMs =
+            std::max(this->policy.idleMs, this->policy.fastMs);
+        this->policy.decay = std::max(this->policy.decay, 1.0);
+        periodMs = this->policy.idleMs;
+    }
+
+    /**
+     * @brief account a poll and get the period until the next one
+     * @param activity - a register changed or the read failed
+     * @param now - time of the poll
+     * @return period in milliseconds
+     */
+    uint32_t next(bool activity, Clock::time_point now)
+    {
+        if (activity)
+        {
+            fastUntil = now + std::chrono::milliseconds(policy.fastWindowMs);
+            periodMs = policy.fastMs;
+        }
+        else if (now >= fastUntil && periodMs < policy.idleMs)
+        {
+            double grown = std::ceil(periodMs * policy.decay);
+            periodMs = grown >= policy.idleMs
+                           ? policy.idleMs
+                           : std::max(static_cast<uint32_t>(grown),
+                                      periodMs + 1);
+        }
+        return periodMs;
+    }
+
+    /** @brief current period in milliseconds */
+    uint32_t period() const
+    {
+        return periodMs;
+    }
+
+    const PollPolicy& bounds() const
+    {
+        return policy;
+    }
+
+  private:
+    PollPolicy policy;
+    uint32_t periodMs;
+    Clock::time_point fastUntil{};
+};
+
+} // namespace nvidia::psumonitor
@@ -17,29 +17,98 @@
 
 #include "PsuMonitor.hpp"
 
-#include "utils.hpp"
+#ifdef PSU_ALERT_GPIO
+#include "GpioAlertLine.hpp"
+#endif
 
-#include <sys/ioctl.h>
-#include <unistd.h>
+#include "I2cDevice.hpp"
+#include "startup_profiler.hpp"
+#include "utils.hpp"
 
+#include <boost/asio/post.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <sdbusplus/asio/connection.hpp>
 #include <sdbusplus/bus.hpp>
 
-#include <bitset>
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 
-extern "C"
+namespace nvidia::psumonitor
 {
-#include <i2c/smbus.h>
-#include <linux/i2c-dev.h>
+
+using nvidia::startup::startupProfiler;
+
+namespace
+{
+
+/**
+ * @brief cpld of the psu_config keys used before the Cplds array, six psus
+ * and three events
+ */
+CpldConfig legacyCpldConfig(const json& psuConfig)
+{
+    CpldConfig config;
+    config.name = "cpld";
+    config.bus = psuConfig["i2c"]["Bus"];
+    config.address = psuConfig["i2c"]["SlaveAddress"];
+    config.blockRead = psuConfig["i2c"].value("BlockRead", false);
+    for (const auto& name :
+         {detectRegister, alertRegister, workRegister, "PSU_EVENT"})
+    {
+        config.registers.push_back(RegisterConfig{
+            name, psuConfig.at(name).at("RegisterAddress").get<uint8_t>()});
+    }
+    for (unsigned i = 0; i < 6; i++)
+    {
+        config.psus.push_back(PsuBitConfig{i, i});
+    }
+    config.events = {{"psu_drop_to_1_event", "PSU_EVENT", 4, false, 0, true},
+                     {"psu_drop_to_2_event", "PSU_EVENT", 5, false, 0, true},
+                     {"MBON_GBOFF_event", "PSU_EVENT", 6}};
+    config.debounce = psuConfig.value("Debounce", 1u);
+    return config;
 }
 
-namespace nvidia::psumonitor
+CpldConfig parseCpldConfig(const json& cpld)
 {
+    CpldConfig config;
+    config.name = cpld.value("Name", "cpld");
+    config.bus = cpld.at("i2c").at("Bus").get<int>();
+    config.address = cpld.at("i2c").at("SlaveAddress").get<int>();
+    config.blockRead = cpld.at("i2c").value("BlockRead", false);
+    config.debounce = cpld.value("Debounce", 1u);
+    for (const auto& [name, address] : cpld.at("Registers").items())
+    {
+        config.registers.push_back(
+            RegisterConfig{name, address.get<uint8_t>()});
+    }
+    // in address order so that contiguous registers can be block read
+    std::sort(config.registers.begin(), config.registers.end(),
+              [](const auto& a, const auto& b) { return a.address < b.address; });
+    for (const auto& psu : cpld.value("Psus", json::array()))
+    {
+        config.psus.push_back(PsuBitConfig{psu.at("Index").get<unsigned>(),
+                                           psu.at("Bit").get<unsigned>(),
+                                           psu.value("Debounce", 0u)});
+    }
+    for (const auto& event : cpld.value("Events", json::array()))
+    {
+        config.events.push_back(
+            EventConfig{event.at("Name").get<std::string>(),
+                        event.at("Register").get<std::string>(),
+                        event.at("Bit").get<unsigned>(),
+                        event.value("ActiveLow", false),
+                        event.value("Debounce", 0u),
+                        event.value("PersistJournal", false)});
+    }
+    return config;
+}
+
+} // namespace
 
 int PsuMonitor::getPsuConfigValues()
 {
@@ -56,17 +125,53 @@ int PsuMonitor::getPsuConfigValues()
         json psuConfigJson; // json object for psu config
         psu_json_file >> psuConfigJson;
 
-        detectRegAddr =
-            psuConfigJson["psu_config"]["PSU_DETECT_N"]["RegisterAddress"];
-        alertRegAddr =
-            psuConfigJson["psu_config"]["PSU_ALERT_N"]["RegisterAddress"];
-        workRegAddr =
-            psuConfigJson["psu_config"]["PSU_WORK_N"]["RegisterAddress"];
-        psuDropRegAddr =
-            psuConfigJson["psu_config"]["PSU_EVENT"]["RegisterAddress"];
+        const auto& psuConfig = psuConfigJson["psu_config"];
+        if (psuConfig.contains("Cplds"))
+        {
+            for (const auto& cpld : psuConfig["Cplds"])
+            {
+                cpldConfigs.push_back(parseCpldConfig(cpld));
+            }
+        }
+        else
+        {
+            cpldConfigs.push_back(legacyCpldConfig(psuConfig));
+        }
+        if (cpldConfigs.empty())
+        {
+            std::cerr << "no cpld in psu_config \n";
+            return -1;
+        }
+
+        if (psuConfig.contains("Polling"))
+        {
+            const auto& polling = psuConfig["Polling"];
+            PollPolicy policy;
+            policy.fastMs = polling.value("FastMs", policy.fastMs);
+            policy.idleMs = polling.value("IdleMs", policy.idleMs);
+            policy.fastWindowMs =
+                polling.value("FastWindowMs", policy.fastWindowMs);
+            policy.decay = polling.value("Decay", policy.decay);
+            pollSchedule = PollSchedule(policy);
+        }
 
-        bus = psuConfigJson["psu_config"]["i2c"]["Bus"];
-        slaveAddress = psuConfigJson["psu_config"]["i2c"]["SlaveAddress"];
+        size_t journalCapacity = 1024;
+        if (psuConfig.contains("Journal"))
+        {
+            const auto& journalConfig = psuConfig["Journal"];
+            journalCapacity =
+                journalConfig.value("Capacity", journalCapacity);
+            journalPath = journalConfig.value("Path", journalPath);
+        }
+        journal = std::make_unique<TransitionJournal>(journalCapacity);
+
+        if (psuConfig.contains("AlertGpio"))
+        {
+            const auto& alert = psuConfig["AlertGpio"];
+            alertLineName = alert.at("LineName");
+            alertEdge = alert.value("Edge", "Falling");
+            alertActiveLow = alert.value("ActiveLow", false);
+        }
     }
     catch (const std::exception& e)
     {
@@ -85,229 +190,430 @@ inline std::string PsuMonitor::getPowerStateEnumeration(bool power)
         return "xyz.openbmc_project.State.Decorator.PowerState.State.Off";
 }
 
-void PsuMonitor::udpateProperty(const std::string& objectPath,
-                                const std::string& iface,
-                                const std::string& propertyName,
-                                const bool value)
+void PsuMonitor::buildPsuPathTable()
 {
-    try
+    psuPaths.clear();
+    for (const auto& psuObjectPath : psuObjectPaths)
     {
-        if (iface == powerStateIface)
+        auto index = psuIndexOfPath(psuObjectPath);
+        if (!index)
         {
-            const std::string currentPowerState =
-                getPowerStateEnumeration(value);
-            PropertyValue state{currentPowerState};
-            dBusHandler.setProperty(objectPath, iface, propertyName, state);
+            continue;
         }
-        else
+        if (*index >= psuPaths.size())
         {
-            PropertyValue bVal{value};
-            dBusHandler.setProperty(objectPath, iface, propertyName, bVal);
+            psuPaths.resize(*index + 1);
         }
+        psuPaths[*index].push_back(psuObjectPath);
     }
-    catch (const std::exception& e)
+}
+
+void PsuMonitor::queueProperty(const std::string& objectPath,
+                               const std::string& iface,
+                               const std::string& propertyName,
+                               const bool value)
+{
+    PropertyValue propertyValue{value};
+    if (iface == powerStateIface)
     {
-        std::cerr << e.what() << std::endl;
+        propertyValue = getPowerStateEnumeration(value);
     }
 
-    return;
+    if (pendingUpdates.add(objectPath, iface, propertyName, propertyValue))
+    {
+        // one flush for all the updates of a poll
+        boost::asio::post(io, [this]() { flushUpdates(); });
+    }
 }
 
-int32_t PsuMonitor::i2cRead(const int& busId, const int& slaveAddr,
-                            const int32_t& statusReg)
+void PsuMonitor::flushUpdates()
 {
-    std::string i2cBus = "/dev/i2c-" + std::to_string(busId);
+    for (auto& [key, value] : pendingUpdates.take())
+    {
+        const auto& [objectPath, iface, propertyName] = key;
+        auto serviceKey = std::make_pair(objectPath, iface);
+        auto service = services.find(serviceKey);
+        if (service == services.end())
+        {
+            try
+            {
+                auto name = dBusHandler.getService(objectPath, iface);
+                if (name.empty())
+                {
+                    continue;
+                }
+                service = services.emplace(serviceKey, name).first;
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << e.what() << std::endl;
+                continue;
+            }
+        }
 
-    int fd = open(i2cBus.c_str(), O_RDWR | O_CLOEXEC);
-    if (fd < 0)
+        conn->async_method_call(
+            [this, serviceKey](const boost::system::error_code& ec) {
+                if (ec)
+                {
+                    std::cerr << "Error: set " << serviceKey.second << " of "
+                              << serviceKey.first << " failed: "
+                              << ec.message() << "\n";
+                    // the service may have moved, look it up again
+                    services.erase(serviceKey);
+                }
+            },
+            service->second, objectPath, DBUS_PROPERTY_IFACE, "Set", iface,
+            propertyName, value);
+    }
+}
+
+void PsuMonitor::publishBit(BitKind kind, unsigned index, bool value)
+{
+    if (kind == BitKind::Event)
     {
-        std::cerr << "unable to open i2c device \n";
-        return -1;
+        if (index < psuEvents.size())
+        {
+            psuEvents[index]->enabledInterface->set_property(enable, value);
+        }
+        // a redundancy loss, the initial state is not journaled
+        if (value && index < persistingEvents.size() &&
+            persistingEvents[index] && journal && journal->recorded() > 0 &&
+            !persistPending)
+        {
+            // once the transitions of the whole poll are recorded
+            persistPending = true;
+            boost::asio::post(io, [this]() {
+                persistPending = false;
+                persistJournal();
+            });
+        }
+        return;
     }
-    if (ioctl(fd, I2C_SLAVE_FORCE, slaveAddr) < 0)
+    if (index >= psuPaths.size())
     {
-        std::cerr << "unable to set device address\n";
-        close(fd);
-        return -1;
+        return;
     }
-
-    unsigned long funcs = 0;
-    if (ioctl(fd, I2C_FUNCS, &funcs) < 0)
+    for (const auto& psuObjectPath : psuPaths[index])
     {
-        std::cerr << "not support I2C_FUNCS \n";
-        close(fd);
-        return -1;
+        switch (kind)
+        {
+            case BitKind::Present:
+                queueProperty(psuObjectPath, INVENTORY_IFACE, present, value);
+                break;
+            case BitKind::PowerState:
+                queueProperty(psuObjectPath, powerStateIface, powerState,
+                              value);
+                break;
+            case BitKind::Functional:
+                queueProperty(psuObjectPath, operationalIface, functional,
+                              value);
+                break;
+            default:
+                break;
+        }
     }
+}
 
-    if (!(funcs & I2C_FUNC_SMBUS_READ_BYTE_DATA))
+void PsuMonitor::createPsuEvents()
+{
+    for (const auto& config : cpldConfigs)
     {
-        std::cerr << "not support I2C_FUNC_SMBUS_READ_BYTE_DATA \n";
-        close(fd);
-        return -1;
+        for (const auto& event : config.events)
+        {
+            psuEvents.emplace_back(
+                std::make_shared<PsuEvent>(event.name, objServer));
+            persistingEvents.push_back(event.persistJournal);
+        }
     }
+}
 
-    int32_t statusValue = i2c_smbus_read_byte_data(fd, statusReg);
-
-    close(fd);
-
-    if (statusValue < 0)
+void PsuMonitor::createCplds()
+{
+    std::map<int, std::vector<CpldMonitor*>> buses;
+    unsigned eventBase = 0;
+    for (const auto& config : cpldConfigs)
     {
-        std::cerr << "i2c_smbus_read_byte_data failed \n";
-        return -1;
+        cplds.emplace_back(std::make_unique<CpldMonitor>(
+            config,
+            std::make_unique<I2cDevice>(config.bus, config.address,
+                                        config.blockRead),
+            eventBase));
+        cplds.back()->setJournal(journal.get(),
+                                 static_cast<uint16_t>(cplds.size() - 1));
+        eventBase += config.events.size();
+        buses[config.bus].push_back(cplds.back().get());
     }
-
-    return statusValue;
+    for (auto& [bus, cpldsOfBus] : buses)
+    {
+        busCplds.push_back(std::move(cpldsOfBus));
+    }
+    busPool = std::make_unique<boost::asio::thread_pool>(busCplds.size());
 }
 
-int PsuMonitor::update_status(const int32_t& detectNewVal,
-                              const int32_t& alertNewVal,
-                              const int32_t& workNewVal,
-                              const int32_t& DropNewVal, int initialize = 0)
+void PsuMonitor::publishBus(const std::vector<CpldMonitor*>& cpldsOfBus)
 {
-    int psus[]{0, 1, 2, 3, 4, 5};
-    int eve[]{0, 1, 2};
-    int rc = 0;
+    for (auto cpld : cpldsOfBus)
+    {
+        if (cpld->apply([this](BitKind kind, unsigned index, bool value) {
+                publishBit(kind, index, value);
+            }))
+        {
+            cycleActivity = true;
+        }
+    }
+}
 
-    try
+void PsuMonitor::pollCplds()
+{
+    if (pendingBuses > 0)
     {
-        std::bitset<6> psuDetectNewArr(detectNewVal);
-        std::bitset<6> psuAlertNewArr(alertNewVal);
-        std::bitset<6> psuWorkNewArr(workNewVal);
-        std::bitset<8> psuDropNewArr(DropNewVal);
+        recheck = true;
+        return;
+    }
 
-        if ((detectNewVal != detectRegValue) || (initialize == 1))
-        {
-            for (const auto& i : psus)
+    cycleActivity = false;
+    pendingBuses = busCplds.size();
+    for (const auto& cpldsOfBus : busCplds)
+    {
+        // i2c reads block, each bus is read by its own thread so that a
+        // cpld does not wait for the cplds of the other buses
+        boost::asio::post(*busPool, [this, &cpldsOfBus]() {
+            for (auto cpld : cpldsOfBus)
             {
-                for (const auto& psuObjectPath : psuObjectPaths)
+                if (!cpld->read())
                 {
-                    if (psuObjectPath.find("powersupply" + std::to_string(i)) !=
-                        std::string::npos)
-                    {
-                        udpateProperty(psuObjectPath, INVENTORY_IFACE, present,
-                                       !psuDetectNewArr[i]);
-                    }
+                    std::cerr << "Error: i2c Read for "
+                              << cpld->config().name << " Failed\n";
                 }
             }
-            detectRegValue = detectNewVal;
-        }
 
-        if ((alertRegValue != alertNewVal) || (initialize == 1))
-        {
-            for (const auto& i : psus)
-            {
-                for (const auto& psuObjectPath : psuObjectPaths)
+            boost::asio::post(io, [this, &cpldsOfBus]() {
+                publishBus(cpldsOfBus);
+                if (--pendingBuses > 0)
                 {
-                    if (psuObjectPath.find("powersupply" + std::to_string(i)) !=
-                        std::string::npos)
-                    {
-                        udpateProperty(psuObjectPath, powerStateIface,
-                                       powerState, !psuAlertNewArr[i]);
-                    }
+                    return;
                 }
-            }
-            alertRegValue = alertNewVal;
-        }
 
-        if ((workRegValue != workNewVal) || (initialize == 1))
-        {
-            for (const auto& i : psus)
-            {
-                for (const auto& psuObjectPath : psuObjectPaths)
+                updatePollPeriod(cycleActivity);
+                updateDebounceCounters();
+                if (recheck)
                 {
-                    if (psuObjectPath.find("powersupply" + std::to_string(i)) !=
-                        std::string::npos)
-                    {
-                        udpateProperty(psuObjectPath, operationalIface,
-                                       functional, !psuWorkNewArr[i]);
-                    }
+                    recheck = false;
+                    pollCplds();
+                    return;
                 }
-            }
-            workRegValue = workNewVal;
-        }
+                pollRegisters();
+            });
+        });
+    }
+}
+
+void PsuMonitor::updatePollPeriod(bool activity)
+{
+    pollSchedule.next(activity, Clock::now());
+    if (pollingInterface)
+    {
+        pollingInterface->set_property("PeriodMs", pollSchedule.period());
+    }
+}
+
+void PsuMonitor::createPollingInterface()
+{
+    const auto& bounds = pollSchedule.bounds();
+    pollingInterface = objServer.add_interface(MANAGER_OBJ_PATH, pollingIface);
+    pollingInterface->register_property(
+        "PeriodMs", pollSchedule.period(),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    pollingInterface->register_property(
+        "FastPeriodMs", bounds.fastMs,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    pollingInterface->register_property(
+        "IdlePeriodMs", bounds.idleMs,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    pollingInterface->register_property(
+        "FastWindowMs", bounds.fastWindowMs,
+        sdbusplus::asio::PropertyPermission::readOnly);
+
+    if (!pollingInterface->initialize())
+    {
+        std::cerr << "error initializing polling interface\n";
+    }
+}
+
+void PsuMonitor::createDebounceInterface()
+{
+    debounceInterface =
+        objServer.add_interface(MANAGER_OBJ_PATH, debounceIface);
+    debounceInterface->register_property(
+        "GlitchCount", static_cast<uint64_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    debounceInterface->register_property(
+        "DiscardedReadCount", static_cast<uint64_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+
+    if (!debounceInterface->initialize())
+    {
+        std::cerr << "error initializing debounce interface\n";
+    }
+    updateDebounceCounters();
+}
+
+void PsuMonitor::updateDebounceCounters()
+{
+    if (!debounceInterface)
+    {
+        return;
+    }
+    uint64_t glitches = 0;
+    uint64_t discarded = 0;
+    for (const auto& cpld : cplds)
+    {
+        glitches += cpld->glitches();
+        discarded += cpld->discarded();
+    }
+    debounceInterface->set_property("GlitchCount", glitches);
+    debounceInterface->set_property("DiscardedReadCount", discarded);
+}
 
-        if ((psuDropRegValue != DropNewVal) || (initialize == 1))
+void PsuMonitor::createJournalInterface()
+{
+    journalInterface = objServer.add_interface(MANAGER_OBJ_PATH, journalIface);
+    journalInterface->register_property(
+        "Capacity", static_cast<uint64_t>(journal->capacity()),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    journalInterface->register_property(
+        "Path", journalPath, sdbusplus::asio::PropertyPermission::readOnly);
+    journalInterface->register_method("Dump",
+                                      [this]() { return dumpJournal(); });
+    journalInterface->register_method("Persist",
+                                      [this]() { return persistJournal(); });
+
+    if (!journalInterface->initialize())
+    {
+        std::cerr << "error initializing journal interface\n";
+    }
+}
+
+std::vector<JournalEntry> PsuMonitor::dumpJournal() const
+{
+    std::vector<JournalEntry> entries;
+    for (const auto& transition : journal->snapshot())
+    {
+        std::string cpldName = "cpld" + std::to_string(transition.cpld);
+        std::string registerName = std::to_string(transition.registerAddress);
+        if (transition.cpld < cpldConfigs.size())
         {
-            for (const auto& i : eve)
+            const auto& config = cpldConfigs[transition.cpld];
+            cpldName = config.name;
+            for (const auto& reg : config.registers)
             {
-                if (psuDropNewArr[i + eveOffset])
+                if (reg.address == transition.registerAddress)
                 {
-                    psuEvents[i]->enabledInterface->set_property("Enabled",
-                                                                 true);
-                }
-                else
-                {
-                    psuEvents[i]->enabledInterface->set_property("Enabled",
-                                                                 false);
+                    registerName = reg.name;
+                    break;
                 }
             }
-            psuDropRegValue = DropNewVal;
         }
+        entries.emplace_back(transition.monotonicUs, transition.realtimeUs,
+                             cpldName, registerName, transition.bit,
+                             transition.value);
+    }
+    return entries;
+}
+
+bool PsuMonitor::persistJournal()
+{
+    json transitions = json::array();
+    for (const auto& [monotonicUs, realtimeUs, cpld, reg, bit, value] :
+         dumpJournal())
+    {
+        transitions.push_back({{"MonotonicUs", monotonicUs},
+                               {"RealtimeUs", realtimeUs},
+                               {"Cpld", cpld},
+                               {"Register", reg},
+                               {"Bit", bit},
+                               {"Value", value}});
+    }
+
+    try
+    {
+        std::filesystem::path path(journalPath);
+        std::filesystem::create_directories(path.parent_path());
+        // the previous journal stays whole if the write is interrupted
+        auto tmpPath = path;
+        tmpPath += ".tmp";
+        std::ofstream ofs(tmpPath, std::ios::out | std::ios::trunc);
+        if (!ofs.good())
+        {
+            std::cerr << "Error: unable to open " << tmpPath << "\n";
+            return false;
+        }
+        ofs << json{{"Transitions", transitions}}.dump(2);
+        ofs.close();
+        if (!ofs)
+        {
+            std::cerr << "Error: unable to write " << tmpPath << "\n";
+            return false;
+        }
+        std::filesystem::rename(tmpPath, path);
     }
     catch (const std::exception& e)
     {
-        std::cerr << e.what() << std::endl;
-        rc = -1;
+        std::cerr << "Error: persist PSU journal: " << e.what() << "\n";
+        return false;
     }
+    std::cerr << "PSU journal of " << transitions.size()
+              << " transitions persisted to " << journalPath << "\n";
+    return true;
+}
 
-    return rc;
+void PsuMonitor::startAlertWatcher()
+{
+    if (alertLineName.empty())
+    {
+        return;
+    }
+#ifdef PSU_ALERT_GPIO
+    try
+    {
+        alertWatcher = std::make_unique<AlertWatcher>(
+            io,
+            std::make_unique<GpioAlertLine>(alertLineName, alertEdge,
+                                            alertActiveLow),
+            [this]() {
+                // the poll timer is rearmed once the read is published
+                pollCplds();
+            });
+        alertWatcher->start();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: PSU alert gpio " << alertLineName << ": "
+                  << e.what() << ", polling only\n";
+        alertWatcher.reset();
+    }
+#else
+    std::cerr << "PSU alert gpio " << alertLineName
+              << " ignored, built without libgpiod, polling only\n";
+#endif
 }
 
 void PsuMonitor::pollRegisters()
 {
     // setting a new experation implicitly cancels any pending async wait
     mPollTimer.expires_from_now(
-        boost::posix_time::seconds(intrusionSensorPollSec));
+        boost::posix_time::milliseconds(pollSchedule.period()));
 
     mPollTimer.async_wait([&](const boost::system::error_code& ec) {
         // case of timer expired
         if (!ec)
         {
-            auto detectRegValueCur = i2cRead(bus, slaveAddress, detectRegAddr);
-            if (detectRegValueCur < 0)
-            {
-                std::cerr << "Error: i2c Read for detect Register Failed\n";
-            }
-
-            auto alertRegValueCur = i2cRead(bus, slaveAddress, alertRegAddr);
-            if (alertRegValueCur < 0)
-            {
-                std::cerr << "Error: i2c Read for Alert Register Failed\n";
-            }
-
-            auto workRegValueCur = i2cRead(bus, slaveAddress, workRegAddr);
-            if (workRegValueCur < 0)
-            {
-                std::cerr << "Error: i2c Read for Work Register Failed\n";
-            }
-
-            auto psuDropRegValueCur = i2cRead(bus, slaveAddress,
-                                              psuDropRegAddr);
-            if (psuDropRegValueCur < 0)
-            {
-                std::cerr << "Error: i2c Read for PSU Drop Register Failed\n";
-            }
-
-            if ((detectRegValueCur != detectRegValue) ||
-                (alertRegValueCur != alertRegValue) ||
-                (workRegValueCur != workRegValue) ||
-                (psuDropRegValueCur != psuDropRegValue))
-            {
-                auto ret = update_status(detectRegValueCur, alertRegValueCur,
-                                         workRegValueCur, psuDropRegValueCur);
-                if (ret < 0)
-                {
-                    std::cerr << " update_status failed \n";
-                }
-            }
-
-            // trigger next polling
-            pollRegisters();
+            // the next polling is triggered once all buses are read
+            pollCplds();
         }
-        // case of being canceled
+        // case of being canceled, or rescheduled after an alert
         else if (ec == boost::asio::error::operation_aborted)
         {
-            std::cerr << "Timer  cancelled. Return \n";
             return;
         }
     });
@@ -319,8 +625,9 @@ void PsuMonitor::pollRegisters()
  */
 void PsuMonitor::start()
 {
-    int initProperties = 1;
+    auto mapperPhase = startupProfiler().phase("mapper");
     psuObjectPaths = dBusHandler.getSubTreePaths("/", powerSupplyIface);
+    mapperPhase.stop();
 
     if (psuObjectPaths.empty())
     {
@@ -329,63 +636,93 @@ void PsuMonitor::start()
     }
 
     std::sort(psuObjectPaths.begin(), psuObjectPaths.end());
-    psuEveObjectPaths = {
-        "/xyz/openbmc_project/sensors/power/psu_drop_to_1_event",
-        "/xyz/openbmc_project/sensors/power/psu_drop_to_2_event",
-        "/xyz/openbmc_project/sensors/power/MBON_GBOFF_event"};
+    buildPsuPathTable();
 
+    auto jsonPhase = startupProfiler().phase("json-parse");
     if (getPsuConfigValues() == -1)
     {
         std::cerr << "Error: Parsing Json Configuration File \n";
         return;
     }
+    jsonPhase.stop();
 
-    detectRegValue = i2cRead(bus, slaveAddress, detectRegAddr);
-    if (detectRegValue < 0)
-    {
-        std::cerr << "Error: i2c Read detect Failed\n";
-    }
-    alertRegValue = i2cRead(bus, slaveAddress, alertRegAddr);
-    if (alertRegValue < 0)
+    try
     {
-        std::cerr << "Error: i2c Read alert Failed\n";
-    }
+        auto eventPhase = startupProfiler().phase("event-objects");
+        createPsuEvents();
+        eventPhase.stop();
 
-    workRegValue = i2cRead(bus, slaveAddress, workRegAddr);
-    if (workRegValue < 0)
+        createCplds();
+    }
+    catch (const std::exception& e)
     {
-        std::cerr << "Error: i2c Read work Failed\n";
+        std::cerr << "Error: PSU configuration: " << e.what() << "\n";
+        return;
     }
 
-    psuDropRegValue = i2cRead(bus, slaveAddress, psuDropRegAddr);
-    if (psuDropRegValue < 0)
+    auto i2cPhase = startupProfiler().phase("i2c-initial-read");
+    bool readFailed = false;
+    for (auto& cpld : cplds)
     {
-        std::cerr << "Error: i2c Read drop Failed\n";
+        if (!cpld->read())
+        {
+            readFailed = true;
+            std::cerr << "Error: i2c Read " << cpld->config().name
+                      << " Failed\n";
+        }
     }
+    i2cPhase.stop();
 
-    auto ret = update_status(detectRegValue, alertRegValue, workRegValue,
-                             psuDropRegValue, initProperties);
-    if (ret < 0)
+    auto publishPhase = startupProfiler().phase("initial-publish");
+    for (auto& cpld : cplds)
     {
-        std::cerr << " init update_status failed \n";
-        return;
+        // the first successful read publishes every bit
+        cpld->apply([this](BitKind kind, unsigned index, bool value) {
+            publishBit(kind, index, value);
+        });
     }
+    publishPhase.stop();
 
+    createPollingInterface();
+    createDebounceInterface();
+    createJournalInterface();
+    updatePollPeriod(readFailed);
+    startAlertWatcher();
     pollRegisters();
     return;
 }
 
 PsuMonitor::PsuMonitor(boost::asio::io_service& io,
-                       std::vector<std::shared_ptr<PsuEvent>>& pEvents) :
-    psuEvents(pEvents),
-    mPollTimer(io), bus(-1), slaveAddress(-1), detectRegAddr(-1),
-    alertRegAddr(-1), workRegAddr(-1), psuDropRegAddr(-1), detectRegValue(-1),
-    alertRegValue(-1), workRegValue(-1), psuDropRegValue(-1)
+                       sdbusplus::asio::object_server& objectServer,
+                       std::shared_ptr<sdbusplus::asio::connection> conn) :
+    conn(std::move(conn)),
+    io(io), objServer(objectServer), mPollTimer(io),
+    journalPath("/var/lib/nvidia-psu-monitor/psu-journal.json"),
+    persistPending(false), alertActiveLow(false),
+    pendingBuses(0), cycleActivity(false), recheck(false)
 {}
 
 PsuMonitor::~PsuMonitor()
 {
+    alertWatcher.reset();
     mPollTimer.cancel();
+    if (busPool)
+    {
+        busPool->stop();
+        busPool->join();
+    }
+    if (pollingInterface)
+    {
+        objServer.remove_interface(pollingInterface);
+    }
+    if (debounceInterface)
+    {
+        objServer.remove_interface(debounceInterface);
+    }
+    if (journalInterface)
+    {
+        objServer.remove_interface(journalInterface);
+    }
 }
 
 } // namespace nvidia::psumonitor
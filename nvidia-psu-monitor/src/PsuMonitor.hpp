@@ -19,17 +19,27 @@
 
 #include "config.h"
 
+#include "AlertWatcher.hpp"
+#include "PollSchedule.hpp"
 #include "PsuEvent.hpp"
+#include "PsuTopology.hpp"
+#include "StatusDiff.hpp"
+#include "TransitionJournal.hpp"
 #include "utils.hpp"
 
 #include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/io_service.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <nlohmann/json.hpp>
 #include <sdbusplus/asio/object_server.hpp>
 #include <xyz/openbmc_project/State/Decorator/PowerState/server.hpp>
 
+#include <map>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 using json = nlohmann::json;
 
@@ -37,6 +47,10 @@ using GetSubTreeType = std::vector<
     std::pair<std::string,
               std::vector<std::pair<std::string, std::vector<std::string>>>>>;
 
+/** @brief monotonic and realtime us, cpld, register, bit and value */
+using JournalEntry =
+    std::tuple<uint64_t, uint64_t, std::string, std::string, uint8_t, bool>;
+
 using PowerState = sdbusplus::xyz::openbmc_project::State::Decorator::server::
     PowerState::State;
 
@@ -46,9 +60,6 @@ using namespace nvidia::psumonitor::event;
 namespace nvidia::psumonitor
 {
 
-static constexpr unsigned int intrusionSensorPollSec = 5;
-static constexpr unsigned int eveOffset = 4;
-
 // dbus properties
 static constexpr auto present = "Present";
 static constexpr auto functional = "Functional";
@@ -62,6 +73,9 @@ static constexpr auto operationalIface =
 static constexpr auto enableIface = "xyz.openbmc_project.Object.Enable";
 static constexpr auto powerSupplyIface =
     "xyz.openbmc_project.Inventory.Item.PowerSupply";
+static constexpr auto pollingIface = "com.Nvidia.PsuMonitor.Polling";
+static constexpr auto debounceIface = "com.Nvidia.PsuMonitor.Debounce";
+static constexpr auto journalIface = "com.Nvidia.PsuMonitor.Journal";
 
 /*
  * @class PowerMonitorSensor
@@ -73,11 +87,12 @@ class PsuMonitor
      * @brief Construct a new Power Supply object
      *
      * @param bus
-     * @param dbud service
-     * @param psuevents container object
+     * @param dbus object server
+     * @param dbus connection the property updates are sent on
      */
     PsuMonitor(boost::asio::io_service& io,
-               std::vector<std::shared_ptr<PsuEvent>>& pEvents);
+               sdbusplus::asio::object_server& objectServer,
+               std::shared_ptr<sdbusplus::asio::connection> conn);
 
     ~PsuMonitor();
 
@@ -85,29 +100,69 @@ class PsuMonitor
 
   private:
     std::vector<std::string> psuObjectPaths;
-    std::vector<std::string> psuEveObjectPaths;
 
-    /** @brief psu events vector*/
+    /** @brief object paths of each psu index, resolved at startup */
+    std::vector<std::vector<std::string>> psuPaths;
+
+    /** @brief service of each object path and interface updated */
+    std::map<std::pair<std::string, std::string>, std::string> services;
+
+    /** @brief property updates waiting for the next flush */
+    UpdateBatch<PropertyValue> pendingUpdates;
+
+    std::shared_ptr<sdbusplus::asio::connection> conn;
+
+    /** @brief psu events of all cplds, in the order of the json */
     std::vector<std::shared_ptr<PsuEvent>> psuEvents;
+    /** @brief events whose enabling persists the journal, same order */
+    std::vector<bool> persistingEvents;
+
+    boost::asio::io_service& io;
+
+    sdbusplus::asio::object_server& objServer;
 
     /** @brief timer  */
     boost::asio::deadline_timer mPollTimer;
 
-    /** @brief psu i2c details */
-    int bus;
-    int slaveAddress;
+    /** @brief period of the polling, fast after a change or an error */
+    PollSchedule pollSchedule;
+    std::shared_ptr<sdbusplus::asio::dbus_interface> pollingInterface;
+
+    /** @brief glitches and failed reads of all cplds */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> debounceInterface;
+
+    /** @brief bit transitions of all cplds, recorded on the io thread */
+    std::unique_ptr<TransitionJournal> journal;
+    /** @brief file the journal is persisted to */
+    std::string journalPath;
+    /** @brief a persist is posted and not done yet */
+    bool persistPending;
+    std::shared_ptr<sdbusplus::asio::dbus_interface> journalInterface;
+
+    /** @brief psu alert gpio from the json, empty if there is none */
+    std::string alertLineName;
+    std::string alertEdge;
+    bool alertActiveLow;
+
+    /** @brief reads the registers on each alert edge, polling remains as a
+     * safety net */
+    std::unique_ptr<AlertWatcher> alertWatcher;
+
+    /** @brief cplds from the json */
+    std::vector<CpldConfig> cpldConfigs;
+    std::vector<std::unique_ptr<CpldMonitor>> cplds;
 
-    /** @brief i2c register address */
-    int detectRegAddr;
-    int alertRegAddr;
-    int workRegAddr;
-    int psuDropRegAddr;
+    /** @brief cplds of each bus, read one after the other by the thread of
+     * their bus */
+    std::vector<std::vector<CpldMonitor*>> busCplds;
+    std::unique_ptr<boost::asio::thread_pool> busPool;
 
-    /** @brief i2c register values*/
-    int32_t detectRegValue;
-    int32_t alertRegValue;
-    int32_t workRegValue;
-    int32_t psuDropRegValue;
+    /** @brief buses whose read of the current cycle is not published yet */
+    size_t pendingBuses;
+    /** @brief a bit changed or a read started failing during the cycle */
+    bool cycleActivity;
+    /** @brief an alert came during the cycle, read again after it */
+    bool recheck;
 
     /** DBusHandler class handles the D-Bus operations */
     DBusHandler dBusHandler;
@@ -121,37 +176,102 @@ class PsuMonitor
     std::string getPowerStateEnumeration(bool value);
 
     /**
-     * @brief update dbus property
+     * @brief map each psu index to its object paths
+     */
+    void buildPsuPathTable();
+
+    /**
+     * @brief queue a dbus property update, sent with the next flush
      * @param dbus object path
      * @param dbus interface
      * @param dbus property name
      * @param proeprty value
      */
-    void udpateProperty(const std::string& objectPath, const std::string& iface,
-                        const std::string& propertyName, bool value);
+    void queueProperty(const std::string& objectPath, const std::string& iface,
+                       const std::string& propertyName, bool value);
+
+    /**
+     * @brief publish a changed bit
+     * @param what the bit drives
+     * @param psu or event index
+     * @param value of the property
+     */
+    void publishBit(BitKind kind, unsigned index, bool value);
+
+    /**
+     * @brief send the queued property updates asynchronously
+     */
+    void flushUpdates();
+
+    /**
+     * @brief create the event objects of all cplds
+     */
+    void createPsuEvents();
+
+    /**
+     * @brief open the cplds and group them by bus
+     */
+    void createCplds();
+
+    /**
+     * @brief read all buses concurrently and publish what changed, the next
+     * poll is scheduled once all buses are done
+     */
+    void pollCplds();
+
+    /**
+     * @brief publish the read of the cplds of a bus
+     * @param cplds of the bus
+     */
+    void publishBus(const std::vector<CpldMonitor*>& cpldsOfBus);
+
+    /**
+     * @brief account a poll in the poll schedule and publish the period
+     * @param activity - a register changed or the read started failing
+     */
+    void updatePollPeriod(bool activity);
+
+    /**
+     * @brief publish the poll periods
+     */
+    void createPollingInterface();
+
+    /**
+     * @brief publish the debounce counters
+     */
+    void createDebounceInterface();
+
+    /**
+     * @brief update the debounce counters from the cplds
+     */
+    void updateDebounceCounters();
+
+    /**
+     * @brief publish the transition journal and its dump
+     */
+    void createJournalInterface();
+
+    /**
+     * @brief journal transitions with the cpld and register names
+     * @return transitions, oldest first
+     */
+    std::vector<JournalEntry> dumpJournal() const;
 
     /**
-     * @brief read i2c regsiter value
-     * @param i2c bus number
-     * @param slave address
-     * @param register address
-     * @return register value
+     * @brief write the journal to journalPath
+     * @return true on success
      */
-    int32_t i2cRead(const int& busId, const int& slaveAddr,
-                    const int32_t& statusReg);
+    bool persistJournal();
 
     /**
-     * @brief update status based on cpld registers
-     * @param regsiter values
+     * @brief watch the psu alert gpio, if configured
      */
-    int update_status(const int32_t& detectNewVal, const int32_t& alertNewVal,
-                      const int32_t& workNewVal, const int32_t& dropNewVal,
-                      int initialize);
+    void startAlertWatcher();
 
     /**
      * @brief polling cpld regsiters
      * It will monitor the register changes
-     * with an interval of 10 seconds.
+     * at the period of the poll schedule.
      *
      */
     void pollRegisters();
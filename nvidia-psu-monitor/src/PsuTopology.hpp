@@ -0,0 +1,414 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "StatusDiff.hpp"
+#include "TransitionJournal.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nvidia::psumonitor
+{
+
+/** @brief names of the psu status registers of a cpld */
+static constexpr auto detectRegister = "PSU_DETECT_N";
+static constexpr auto alertRegister = "PSU_ALERT_N";
+static constexpr auto workRegister = "PSU_WORK_N";
+
+/*
+ * @class RegisterSource
+ *
+ * Byte registers of a cpld.
+ */
+class RegisterSource
+{
+  public:
+    virtual ~RegisterSource() = default;
+
+    /**
+     * @brief read byte registers
+     * @param registers - register addresses
+     * @param values - register values, -1 for all of them on failure
+     * @return 0 on success, -1 on failure
+     */
+    virtual int readRegisters(const std::vector<uint8_t>& registers,
+                              std::vector<int32_t>& values) = 0;
+};
+
+/** @brief what a register bit drives */
+enum class BitKind
+{
+    /** @brief Present of the psu inventory item */
+    Present,
+    /** @brief PowerState of the psu */
+    PowerState,
+    /** @brief Functional of the psu */
+    Functional,
+    /** @brief Enabled of a psu event */
+    Event,
+};
+
+struct RegisterConfig
+{
+    std::string name;
+    uint8_t address;
+};
+
+/** @brief bit of a psu in each of the status registers of its cpld */
+struct PsuBitConfig
+{
+    /** @brief N of the powersupplyN inventory object */
+    unsigned index;
+    unsigned bit;
+    /** @brief consistent samples to accept a change, 0 for the cpld's */
+    unsigned debounce = 0;
+};
+
+struct EventConfig
+{
+    /** @brief name of the event object */
+    std::string name;
+    std::string registerName;
+    unsigned bit;
+    /** @brief the event is enabled while the bit is clear */
+    bool activeLow = false;
+    /** @brief consistent samples to accept a change, 0 for the cpld's */
+    unsigned debounce = 0;
+    /** @brief the event enabling is a redundancy loss, the transition
+     * journal is persisted */
+    bool persistJournal = false;
+};
+
+struct CpldConfig
+{
+    std::string name;
+    int bus;
+    int address;
+    bool blockRead = false;
+    std::vector<RegisterConfig> registers;
+    std::vector<PsuBitConfig> psus;
+    std::vector<EventConfig> events;
+    /** @brief consistent samples to accept a change of a bit */
+    unsigned debounce = 1;
+};
+
+/**
+ * @brief psu index of an inventory object path
+ * @param path - object path ending with powersupplyN
+ * @return N, nullopt if the path does not end with powersupplyN
+ */
+inline std::optional<unsigned> psuIndexOfPath(const std::string& path)
+{
+    static constexpr std::string_view prefix = "powersupply";
+    auto pos = path.rfind(prefix);
+    if (pos == std::string::npos)
+    {
+        return std::nullopt;
+    }
+    auto digits = path.substr(pos + prefix.size());
+    if (digits.empty() || digits.size() > 4)
+    {
+        return std::nullopt;
+    }
+    for (auto c : digits)
+    {
+        if (!std::isdigit(static_cast<unsigned char>(c)))
+        {
+            return std::nullopt;
+        }
+    }
+    return static_cast<unsigned>(std::stoul(digits));
+}
+
+/*
+ * @class CpldMonitor
+ *
+ * Registers of a cpld and the psu and event bits they hold. Reading the
+ * registers and publishing their changes are separate steps so that the
+ * read can run on the thread of its bus.
+ *
+ * A bit change is accepted once the bit kept its new value for the number
+ * of consecutive samples configured for the bit; a bit returning to its
+ * accepted value before is a glitch. Failed reads are discarded.
+ * Accepted changes are recorded in the transition journal, if any.
+ */
+class CpldMonitor
+{
+  public:
+    /** @brief what a bit drives */
+    struct Target
+    {
+        BitKind kind;
+        /** @brief psu index, or event index for events */
+        unsigned index;
+        bool activeLow;
+    };
+
+    /**
+     * @param config - registers and bits of the cpld
+     * @param source - register reader
+     * @param eventBase - index of the first event of the cpld
+     * @throw std::invalid_argument on a bit beyond the register width or an
+     * event of an unknown register
+     */
+    CpldMonitor(const CpldConfig& config,
+                std::unique_ptr<RegisterSource> source,
+                unsigned eventBase = 0) :
+        cpldConfig(config),
+        source(std::move(source)), masks(config.registers.size(), 0),
+        targets(config.registers.size()),
+        samplesNeeded(config.registers.size()),
+        samples(config.registers.size()),
+        pendingMasks(config.registers.size(), 0),
+        current(config.registers.size(), -1),
+        latest(config.registers.size(), -1)
+    {
+        for (const auto& reg : config.registers)
+        {
+            addresses.push_back(reg.address);
+        }
+
+        auto addTarget = [this](const std::string& registerName, unsigned bit,
+                                Target target, unsigned debounce) {
+            auto reg = findRegister(registerName);
+            if (!reg)
+            {
+                return false;
+            }
+            if (bit >= registerBits)
+            {
+                throw std::invalid_argument(
+                    cpldConfig.name + ": bit " + std::to_string(bit) +
+                    " beyond the register width");
+            }
+            masks[*reg] |= 1u << bit;
+            targets[*reg][bit].push_back(target);
+            // a bit shared by several targets is debounced for the slowest
+            auto needed = std::clamp(debounce ? debounce : cpldConfig.debounce,
+                                     1u, 255u);
+            samplesNeeded[*reg][bit] = std::max<uint8_t>(
+                samplesNeeded[*reg][bit], static_cast<uint8_t>(needed));
+            return true;
+        };
+
+        for (const auto& psu : config.psus)
+        {
+            addTarget(detectRegister, psu.bit,
+                      Target{BitKind::Present, psu.index, true}, psu.debounce);
+            addTarget(alertRegister, psu.bit,
+                      Target{BitKind::PowerState, psu.index, true},
+                      psu.debounce);
+            addTarget(workRegister, psu.bit,
+                      Target{BitKind::Functional, psu.index, true},
+                      psu.debounce);
+        }
+
+        for (size_t i = 0; i < config.events.size(); i++)
+        {
+            const auto& event = config.events[i];
+            if (!addTarget(event.registerName, event.bit,
+                           Target{BitKind::Event,
+                                  eventBase + static_cast<unsigned>(i),
+                                  event.activeLow},
+                           event.debounce))
+            {
+                throw std::invalid_argument(cpldConfig.name + ": event " +
+                                            event.name + " of unknown register " +
+                                            event.registerName);
+            }
+        }
+    }
+
+    /**
+     * @brief read the registers, kept until the next apply
+     * @return true on success
+     */
+    bool read()
+    {
+        latestFailed = source->readRegisters(addresses, latest) < 0;
+        if (latestFailed)
+        {
+            latest.assign(addresses.size(), -1);
+        }
+        return !latestFailed;
+    }
+
+    /**
+     * @brief publish the bit changes accepted with the last read
+     * @param publish - called with the kind, index and value of each
+     * accepted change, and of every bit on the first successful read
+     * @return true if a bit changed or is being debounced, or if the read
+     * started failing, to sample again soon
+     */
+    template <typename Publish>
+    bool apply(Publish&& publish)
+    {
+        // a cpld which keeps failing is not polled fast forever
+        bool activity = latestFailed && !lastFailed;
+        lastFailed = latestFailed;
+        if (latestFailed)
+        {
+            // a failed read says nothing about the bits
+            discardedReads++;
+            return activity;
+        }
+
+        auto publishBits = [&](size_t reg, uint32_t bits) {
+            forEachBit(bits, [&](unsigned bit) {
+                bool value = bitValue(current[reg], bit);
+                for (const auto& target : targets[reg][bit])
+                {
+                    publish(target.kind, target.index,
+                            target.activeLow ? !value : value);
+                }
+            });
+        };
+
+        if (!initialized)
+        {
+            initialized = true;
+            current = latest;
+            for (size_t i = 0; i < addresses.size(); i++)
+            {
+                publishBits(i, masks[i]);
+            }
+            return true;
+        }
+
+        for (size_t i = 0; i < addresses.size(); i++)
+        {
+            uint32_t changed = changedBits(current[i], latest[i], masks[i]);
+
+            // back to the accepted value before enough samples
+            forEachBit(pendingMasks[i] & ~changed, [&](unsigned bit) {
+                samples[i][bit] = 0;
+                glitchCount++;
+            });
+
+            uint32_t accepted = 0;
+            forEachBit(changed, [&](unsigned bit) {
+                if (++samples[i][bit] >= samplesNeeded[i][bit])
+                {
+                    samples[i][bit] = 0;
+                    accepted |= 1u << bit;
+                }
+            });
+            pendingMasks[i] = changed & ~accepted;
+            activity = activity || changed;
+
+            // bits outside the mask follow the register as read
+            auto kept = masks[i] & ~accepted;
+            current[i] = static_cast<int32_t>(
+                (static_cast<uint32_t>(current[i]) & kept) |
+                (static_cast<uint32_t>(latest[i]) & ~kept));
+            if (journal)
+            {
+                forEachBit(accepted, [&](unsigned bit) {
+                    journal->record(journalId, addresses[i],
+                                    static_cast<uint8_t>(bit),
+                                    bitValue(current[i], bit));
+                });
+            }
+            publishBits(i, accepted);
+        }
+        return activity;
+    }
+
+    /**
+     * @brief record the accepted changes of the following applies
+     * @param transitionJournal - journal, outliving the cpld
+     * @param cpldId - id of the cpld in the journal
+     */
+    void setJournal(TransitionJournal* transitionJournal, uint16_t cpldId)
+    {
+        journal = transitionJournal;
+        journalId = cpldId;
+    }
+
+    /** @brief bit changes rejected before being accepted */
+    uint64_t glitches() const
+    {
+        return glitchCount;
+    }
+
+    /** @brief failed reads, not accounted in the debounce */
+    uint64_t discarded() const
+    {
+        return discardedReads;
+    }
+
+    const CpldConfig& config() const
+    {
+        return cpldConfig;
+    }
+
+    /** @brief register values with the accepted bits */
+    const std::vector<int32_t>& values() const
+    {
+        return current;
+    }
+
+  private:
+    static constexpr unsigned registerBits = 8;
+
+    std::optional<size_t> findRegister(const std::string& name) const
+    {
+        for (size_t i = 0; i < cpldConfig.registers.size(); i++)
+        {
+            if (cpldConfig.registers[i].name == name)
+            {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    CpldConfig cpldConfig;
+    std::unique_ptr<RegisterSource> source;
+    std::vector<uint8_t> addresses;
+    /** @brief bits of each register driving something */
+    std::vector<uint32_t> masks;
+    /** @brief targets of each bit of each register */
+    std::vector<std::array<std::vector<Target>, registerBits>> targets;
+    /** @brief consecutive samples to accept a change of each bit */
+    std::vector<std::array<uint8_t, registerBits>> samplesNeeded;
+    /** @brief consecutive samples of each bit differing from current */
+    std::vector<std::array<uint8_t, registerBits>> samples;
+    /** @brief bits of each register being debounced */
+    std::vector<uint32_t> pendingMasks;
+    std::vector<int32_t> current;
+    std::vector<int32_t> latest;
+    bool initialized = false;
+    bool latestFailed = false;
+    bool lastFailed = false;
+    uint64_t glitchCount = 0;
+    uint64_t discardedReads = 0;
+    TransitionJournal* journal = nullptr;
+    uint16_t journalId = 0;
+};
+
+} // namespace nvidia::psumonitor
@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace nvidia::psumonitor
+{
+
+/**
+ * @brief bits of a register which changed
+ * @param oldValue - previous register value, -1 if the read failed
+ * @param newValue - current register value, -1 if the read failed
+ * @param mask - bits of interest
+ * @param all - report every bit of the mask, to publish an initial state
+ */
+inline uint32_t changedBits(int32_t oldValue, int32_t newValue, uint32_t mask,
+                            bool all = false)
+{
+    if (all)
+    {
+        return mask;
+    }
+    return (static_cast<uint32_t>(oldValue) ^ static_cast<uint32_t>(newValue)) &
+           mask;
+}
+
+/** @brief call visit with the index of each set bit, lowest first */
+template <typename Visitor>
+inline void forEachBit(uint32_t bits, Visitor&& visit)
+{
+    while (bits)
+    {
+        visit(static_cast<unsigned>(std::countr_zero(bits)));
+        bits &= bits - 1;
+    }
+}
+
+/** @brief value of a bit of a register */
+inline bool bitValue(int32_t value, unsigned bit)
+{
+    return (static_cast<uint32_t>(value) >> bit) & 1;
+}
+
+/*
+ * @class UpdateBatch
+ *
+ * Property updates waiting to be sent. A property updated again before the
+ * batch is sent is sent once, with its last value.
+ */
+template <typename Value>
+class UpdateBatch
+{
+  public:
+    /** @brief object path, interface and property name */
+    using Key = std::tuple<std::string, std::string, std::string>;
+
+    /**
+     * @brief queue an update
+     * @return true if the batch was empty, the caller schedules the send
+     */
+    bool add(const std::string& path, const std::string& iface,
+             const std::string& property, const Value& value)
+    {
+        bool first = updates.empty();
+        updates.insert_or_assign(Key{path, iface, property}, value);
+        return first;
+    }
+
+    /** @brief take the queued updates, the batch is empty afterwards */
+    std::map<Key, Value> take()
+    {
+        return std::exchange(updates, {});
+    }
+
+    size_t size() const
+    {
+        return updates.size();
+    }
+
+  private:
+    std::map<Key, Value> updates;
+};
+
+} // namespace nvidia::psumonitor
@@ -0,0 +1,164 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace nvidia::psumonitor
+{
+
+/** @brief transition of a cpld register bit */
+struct Transition
+{
+    /** @brief steady clock time, to order the transitions */
+    uint64_t monotonicUs;
+    /** @brief wall clock time, to match the transitions with other logs */
+    uint64_t realtimeUs;
+    /** @brief index of the cpld in the configuration */
+    uint16_t cpld;
+    uint8_t registerAddress;
+    uint8_t bit;
+    /** @brief value of the bit after the transition */
+    bool value;
+
+    bool operator==(const Transition&) const = default;
+};
+
+/*
+ * @class TransitionJournal
+ *
+ * Ring of the last transitions, overwriting the oldest ones once full.
+ * Written by a single thread without locks; snapshots may be taken from
+ * any thread and skip the entries overwritten while copying, each entry
+ * carries its sequence number like a seqlock.
+ */
+class TransitionJournal
+{
+  public:
+    /** @param capacity - entries kept, rounded up to a power of two */
+    explicit TransitionJournal(size_t capacity = 1024) :
+        mask(std::bit_ceil(std::max<size_t>(capacity, 1)) - 1),
+        words(std::make_unique<std::atomic<uint64_t>[]>(
+            (mask + 1) * wordsPerEntry))
+    {}
+
+    /** @brief record a transition, from the writer thread only */
+    void record(const Transition& transition)
+    {
+        uint64_t position = head.load(std::memory_order_relaxed);
+        auto slot = &words[(position & mask) * wordsPerEntry];
+        // the slot is marked busy before any of its words changes
+        slot[3].store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot[0].store(transition.monotonicUs, std::memory_order_relaxed);
+        slot[1].store(transition.realtimeUs, std::memory_order_relaxed);
+        slot[2].store(pack(transition), std::memory_order_relaxed);
+        slot[3].store(position + 1, std::memory_order_release);
+        head.store(position + 1, std::memory_order_release);
+    }
+
+    /** @brief record a transition stamped with the current time */
+    void record(uint16_t cpld, uint8_t registerAddress, uint8_t bit,
+                bool value)
+    {
+        record(Transition{now<std::chrono::steady_clock>(),
+                          now<std::chrono::system_clock>(), cpld,
+                          registerAddress, bit, value});
+    }
+
+    /** @brief transitions in the ring, oldest first */
+    std::vector<Transition> snapshot() const
+    {
+        uint64_t end = head.load(std::memory_order_acquire);
+        uint64_t begin = end > capacity() ? end - capacity() : 0;
+        std::vector<Transition> transitions;
+        transitions.reserve(end - begin);
+        for (uint64_t position = begin; position < end; position++)
+        {
+            auto slot = &words[(position & mask) * wordsPerEntry];
+            auto sequence = slot[3].load(std::memory_order_acquire);
+            auto transition =
+                unpack(slot[0].load(std::memory_order_relaxed),
+                       slot[1].load(std::memory_order_relaxed),
+                       slot[2].load(std::memory_order_relaxed));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // overwritten by a newer transition while copying
+            if (sequence != position + 1 ||
+                slot[3].load(std::memory_order_relaxed) != sequence)
+            {
+                continue;
+            }
+            transitions.push_back(transition);
+        }
+        return transitions;
+    }
+
+    size_t capacity() const
+    {
+        return mask + 1;
+    }
+
+    /** @brief transitions recorded since the start */
+    uint64_t recorded() const
+    {
+        return head.load(std::memory_order_acquire);
+    }
+
+  private:
+    /** @brief monotonic and realtime stamps, cpld bit and sequence */
+    static constexpr size_t wordsPerEntry = 4;
+
+    template <typename Clock>
+    static uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   Clock::now().time_since_epoch())
+            .count();
+    }
+
+    static uint64_t pack(const Transition& transition)
+    {
+        return static_cast<uint64_t>(transition.cpld) << 32 |
+               static_cast<uint64_t>(transition.registerAddress) << 16 |
+               static_cast<uint64_t>(transition.bit) << 8 |
+               static_cast<uint64_t>(transition.value);
+    }
+
+    static Transition unpack(uint64_t monotonicUs, uint64_t realtimeUs,
+                             uint64_t meta)
+    {
+        return Transition{monotonicUs,
+                          realtimeUs,
+                          static_cast<uint16_t>(meta >> 32),
+                          static_cast<uint8_t>(meta >> 16),
+                          static_cast<uint8_t>(meta >> 8),
+                          static_cast<bool>(meta & 1)};
+    }
+
+    size_t mask;
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+    std::atomic<uint64_t> head{0};
+};
+
+} // namespace nvidia::psumonitor
@@ -15,47 +15,41 @@
  * limitations under the License.
  */
 
-#include "PsuEvent.hpp"
 #include "PsuMonitor.hpp"
+#include "startup_profiler.hpp"
 
 #include <boost/asio/io_service.hpp>
 #include <sdbusplus/asio/connection.hpp>
 #include <sdbusplus/asio/object_server.hpp>
 
 #include <iostream>
-#include <string>
-#include <vector>
 
 using namespace nvidia::psumonitor;
-using namespace nvidia::psumonitor::event;
+using nvidia::startup::startupProfiler;
 
 int main(void)
 {
-    int psuEve[3]{1, 2, 3};
-    std::vector<std::shared_ptr<PsuEvent>> psuEvents;
-
-    std::string eventRegisters[3] = {"psu_drop_to_1_event",
-                                     "psu_drop_to_2_event", "MBON_GBOFF_event"};
-
     try
     {
+        auto connectPhase = startupProfiler().phase("connect");
         boost::asio::io_service io;
         auto systemBus = std::make_shared<sdbusplus::asio::connection>(io);
+        connectPhase.stop();
 
+        auto namePhase = startupProfiler().phase("request-name");
         systemBus->request_name("com.Nvidia.PsuEvent");
+        namePhase.stop();
         sdbusplus::asio::object_server objectServer(systemBus);
 
-        for (const auto& i : psuEve)
-        {
-            auto psuEvent = std::make_unique<PsuEvent>(eventRegisters[i - 1],
-                                                       objectServer);
-
-            psuEvents.emplace_back(std::move(psuEvent));
-        }
-
-        PsuMonitor psuMonitor(io, psuEvents);
+        // the psu events are created from the json by the monitor
+        PsuMonitor psuMonitor(io, objectServer, systemBus);
         psuMonitor.start();
 
+        startupProfiler().ready();
+        startupProfiler().publish(*systemBus, MANAGER_OBJ_PATH);
+        std::cout << startupProfiler().summary("nvidia-psu-monitor")
+                  << std::endl;
+
         io.run();
     }
 
@@ -0,0 +1,118 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Cost of a poll of the PSU cpld registers, reading them with a bus opened
+ * per register against reading them with the persistent I2cDevice.
+ *
+ * Runs against i2c-stub, which emulates SMBus devices but no plain i2c
+ * transfers, so the I2cDevice reads go through its SMBus fallback:
+ *
+ *   modprobe i2c-stub chip_addr=0x3c
+ *   bench_i2c_read <bus of the stub adapter> [polls]
+ *
+ * On a real adapter the four registers are read with a single I2C_RDWR.
+ * Exits with 77, the skip code of meson, if the bus cannot be opened.
+ */
+
+#include "I2cDevice.hpp"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include <i2c/smbus.h>
+#include <linux/i2c-dev.h>
+}
+
+using nvidia::psumonitor::I2cDevice;
+
+static constexpr int stubAddress = 0x3c;
+
+/** @brief register read as PsuMonitor did before I2cDevice, 5 syscalls */
+static int32_t readOnce(int bus, int reg)
+{
+    std::string i2cBus = "/dev/i2c-" + std::to_string(bus);
+    int fd = open(i2cBus.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    unsigned long funcs = 0;
+    if (ioctl(fd, I2C_SLAVE_FORCE, stubAddress) < 0 ||
+        ioctl(fd, I2C_FUNCS, &funcs) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    int32_t value = i2c_smbus_read_byte_data(fd, reg);
+    close(fd);
+    return value;
+}
+
+int main(int argc, char** argv)
+{
+    int bus = argc > 1 ? std::stoi(argv[1]) : 0;
+    int polls = argc > 2 ? std::stoi(argv[2]) : 10000;
+    const std::vector<uint8_t> registers{37, 38, 39, 40};
+
+    if (readOnce(bus, registers[0]) < 0)
+    {
+        std::fprintf(stderr, "no i2c-stub device at 0x%x on bus %d\n",
+                     stubAddress, bus);
+        return 77;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < polls; i++)
+    {
+        for (auto reg : registers)
+        {
+            readOnce(bus, reg);
+        }
+    }
+    std::chrono::duration<double, std::micro> perRegister =
+        std::chrono::steady_clock::now() - start;
+
+    I2cDevice device(bus, stubAddress);
+    std::vector<int32_t> values;
+    device.readRegisters(registers, values);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < polls; i++)
+    {
+        device.readRegisters(registers, values);
+    }
+    std::chrono::duration<double, std::micro> persistent =
+        std::chrono::steady_clock::now() - start;
+
+    // syscalls counted from the code paths, strace -c confirms them
+    std::printf("open per register: %zu syscalls, %.2f us per poll\n",
+                5 * registers.size(), perRegister.count() / polls);
+    std::printf("persistent smbus:  %zu syscalls, %.2f us per poll\n",
+                registers.size(), persistent.count() / polls);
+    std::printf("persistent i2c:    1 syscall on adapters with I2C_FUNC_I2C\n");
+    std::printf("bus opened %llu times\n",
+                static_cast<unsigned long long>(device.openCount()));
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AlertWatcher.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::psumonitor;
+
+/** @brief line whose edges are bytes written to a pipe */
+class MockLine : public AlertLine
+{
+  public:
+    MockLine()
+    {
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0)
+        {
+            throw std::runtime_error("pipe2 failed");
+        }
+    }
+
+    ~MockLine() override
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    int eventFd() const override
+    {
+        return fds[0];
+    }
+
+    int readEvents() override
+    {
+        if (fail)
+        {
+            return -1;
+        }
+        char buf[64];
+        int count = 0;
+        ssize_t n;
+        while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+        {
+            count += n;
+        }
+        return count;
+    }
+
+    void edge(int count = 1)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            ASSERT_EQ(write(fds[1], "e", 1), 1);
+        }
+    }
+
+    int fds[2];
+    bool fail = false;
+};
+
+class AlertWatcherTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        auto mock = std::make_unique<MockLine>();
+        line = mock.get();
+        watcher = std::make_unique<AlertWatcher>(io, std::move(mock),
+                                                 [this]() {
+            alerts++;
+            alertTime = std::chrono::steady_clock::now();
+        });
+    }
+
+    /** @brief run the handlers ready now */
+    void settle()
+    {
+        io.restart();
+        io.poll();
+    }
+
+    boost::asio::io_service io;
+    MockLine* line;
+    std::unique_ptr<AlertWatcher> watcher;
+    int alerts = 0;
+    std::chrono::steady_clock::time_point alertTime;
+};
+
+TEST_F(AlertWatcherTest, NoEdgeNoAlert)
+{
+    watcher->start();
+    settle();
+    EXPECT_EQ(alerts, 0);
+    EXPECT_TRUE(watcher->watching());
+}
+
+TEST_F(AlertWatcherTest, EdgeTriggersRead)
+{
+    watcher->start();
+    line->edge();
+    settle();
+    EXPECT_EQ(alerts, 1);
+    EXPECT_EQ(watcher->events(), 1u);
+
+    // still watching after the first edge
+    line->edge();
+    settle();
+    EXPECT_EQ(alerts, 2);
+}
+
+TEST_F(AlertWatcherTest, BurstIsOneRead)
+{
+    watcher->start();
+    line->edge(5);
+    settle();
+    EXPECT_EQ(alerts, 1);
+    EXPECT_EQ(watcher->events(), 5u);
+}
+
+TEST_F(AlertWatcherTest, LatencyIsMilliseconds)
+{
+    watcher->start();
+    auto edgeTime = std::chrono::steady_clock::now();
+    line->edge();
+    io.restart();
+    io.run_one_for(std::chrono::seconds(1));
+    ASSERT_EQ(alerts, 1);
+    EXPECT_LT(alertTime - edgeTime, std::chrono::milliseconds(50));
+}
+
+TEST_F(AlertWatcherTest, LineFailureStopsWatching)
+{
+    watcher->start();
+    line->fail = true;
+    line->edge();
+    settle();
+    EXPECT_EQ(alerts, 0);
+    EXPECT_FALSE(watcher->watching());
+}
+
+TEST_F(AlertWatcherTest, StopCancelsWait)
+{
+    watcher->start();
+    watcher->stop();
+    line->edge();
+    settle();
+    EXPECT_EQ(alerts, 0);
+    EXPECT_FALSE(watcher->watching());
+}
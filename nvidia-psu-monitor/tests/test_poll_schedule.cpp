@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PollSchedule.hpp"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::psumonitor;
+using namespace std::chrono_literals;
+
+TEST(PollSchedule, IdleWhenStable)
+{
+    PollSchedule schedule;
+    Clock::time_point now{};
+    EXPECT_EQ(schedule.period(), 5000u);
+    for (int i = 0; i < 10; i++)
+    {
+        now += 5s;
+        EXPECT_EQ(schedule.next(false, now), 5000u);
+    }
+}
+
+TEST(PollSchedule, FastDuringWindowThenDecays)
+{
+    PollSchedule schedule(PollPolicy{100, 5000, 1000, 2.0});
+    Clock::time_point now{};
+    EXPECT_EQ(schedule.next(true, now), 100u);
+
+    // the whole window at the fast period
+    for (int i = 0; i < 9; i++)
+    {
+        now += 100ms;
+        EXPECT_EQ(schedule.next(false, now), 100u);
+    }
+
+    std::vector<uint32_t> periods;
+    for (int i = 0; i < 8; i++)
+    {
+        now += 1s;
+        periods.push_back(schedule.next(false, now));
+    }
+    EXPECT_EQ(periods, (std::vector<uint32_t>{200, 400, 800, 1600, 3200, 5000,
+                                              5000, 5000}));
+}
+
+TEST(PollSchedule, ActivityRestartsWindow)
+{
+    PollSchedule schedule(PollPolicy{100, 5000, 1000, 2.0});
+    Clock::time_point now{};
+    schedule.next(true, now);
+    now += 2s;
+    EXPECT_EQ(schedule.next(false, now), 200u);
+    now += 200ms;
+    EXPECT_EQ(schedule.next(false, now), 400u);
+
+    // an error during the decay goes back to fast
+    now += 400ms;
+    EXPECT_EQ(schedule.next(true, now), 100u);
+    now += 500ms;
+    EXPECT_EQ(schedule.next(false, now), 100u);
+}
+
+TEST(PollSchedule, BoundsAreSane)
+{
+    PollSchedule schedule(PollPolicy{0, 0, 0, 0.5});
+    EXPECT_EQ(schedule.bounds().fastMs, 1u);
+    EXPECT_EQ(schedule.bounds().idleMs, 1u);
+
+    // a decay of one still makes progress
+    PollSchedule slow(PollPolicy{100, 103, 0, 1.0});
+    Clock::time_point now{};
+    slow.next(true, now);
+    EXPECT_EQ(slow.next(false, now), 101u);
+    EXPECT_EQ(slow.next(false, now), 102u);
+    EXPECT_EQ(slow.next(false, now), 103u);
+    EXPECT_EQ(slow.next(false, now), 103u);
+}
+
+TEST(PollSchedule, IdleTrafficAfterIncident)
+{
+    // polls in the first minute after a single change
+    PollSchedule adaptive;
+    Clock::time_point now{};
+    auto period = adaptive.next(true, now);
+    int polls = 0;
+    for (auto end = now + 60s; now < end; polls++)
+    {
+        now += std::chrono::milliseconds(period);
+        period = adaptive.next(false, now);
+    }
+    // 100 in the window, then 200 400 ... 5000 and the idle polls
+    EXPECT_GT(polls, 100);
+    EXPECT_LT(polls, 120);
+}
@@ -0,0 +1,336 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PsuTopology.hpp"
+
+#include <map>
+#include <tuple>
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::psumonitor;
+
+/** @brief registers set by the test */
+class FakeRegisterSource : public RegisterSource
+{
+  public:
+    explicit FakeRegisterSource(std::map<uint8_t, int32_t>& registers) :
+        registers(registers)
+    {}
+
+    int readRegisters(const std::vector<uint8_t>& addresses,
+                      std::vector<int32_t>& values) override
+    {
+        reads++;
+        values.assign(addresses.size(), -1);
+        if (fail)
+        {
+            return -1;
+        }
+        for (size_t i = 0; i < addresses.size(); i++)
+        {
+            values[i] = registers.at(addresses[i]);
+        }
+        return 0;
+    }
+
+    std::map<uint8_t, int32_t>& registers;
+    bool fail = false;
+    int reads = 0;
+};
+
+using Published = std::vector<std::tuple<BitKind, unsigned, bool>>;
+
+class PsuTopologyTest : public ::testing::Test
+{
+  protected:
+    /** @brief second cpld of a 12 psu chassis, psus 6 to 11 */
+    CpldConfig secondCpld()
+    {
+        CpldConfig config{"cpld1", 5, 0x3c, false,
+                          {{detectRegister, 0x25},
+                           {alertRegister, 0x26},
+                           {workRegister, 0x27},
+                           {"PSU_EVENT", 0x28}},
+                          {},
+                          {{"psu_drop_to_7_event", "PSU_EVENT", 0},
+                           {"psu_ok", "PSU_EVENT", 7, true}}};
+        for (unsigned bit = 0; bit < 6; bit++)
+        {
+            config.psus.push_back(PsuBitConfig{6 + bit, bit});
+        }
+        return config;
+    }
+
+    Published apply(CpldMonitor& cpld)
+    {
+        Published published;
+        activity = cpld.apply([&](BitKind kind, unsigned index, bool value) {
+            published.emplace_back(kind, index, value);
+        });
+        return published;
+    }
+
+    /** @brief read and publish a sample */
+    Published sample(CpldMonitor& cpld)
+    {
+        cpld.read();
+        return apply(cpld);
+    }
+
+    std::map<uint8_t, int32_t> registers{
+        {0x25, 0x00}, {0x26, 0x00}, {0x27, 0x00}, {0x28, 0x80}};
+    bool activity = false;
+};
+
+TEST_F(PsuTopologyTest, InitialPublishCoversEveryBit)
+{
+    auto source = std::make_unique<FakeRegisterSource>(registers);
+    CpldMonitor cpld(secondCpld(), std::move(source), 3);
+    ASSERT_TRUE(cpld.read());
+    auto published = apply(cpld);
+
+    // 6 psus with 3 properties each, and 2 events
+    ASSERT_EQ(published.size(), 20u);
+    EXPECT_EQ(published.front(), std::make_tuple(BitKind::Present, 6u, true));
+    EXPECT_EQ(published[5], std::make_tuple(BitKind::Present, 11u, true));
+    EXPECT_EQ(published[18], std::make_tuple(BitKind::Event, 3u, false));
+    EXPECT_EQ(published[19], std::make_tuple(BitKind::Event, 4u, false));
+}
+
+TEST_F(PsuTopologyTest, OnlyChangedPsusArePublished)
+{
+    auto source = std::make_unique<FakeRegisterSource>(registers);
+    CpldMonitor cpld(secondCpld(), std::move(source), 3);
+    cpld.read();
+    apply(cpld);
+
+    cpld.read();
+    EXPECT_TRUE(apply(cpld).empty());
+    EXPECT_FALSE(activity);
+
+    // psu 9 is pulled out and the drop event fires
+    registers[0x25] = 0x08;
+    registers[0x28] = 0x81;
+    cpld.read();
+    EXPECT_EQ(apply(cpld),
+              (Published{{BitKind::Present, 9, false}, {BitKind::Event, 3, true}}));
+    EXPECT_TRUE(activity);
+    EXPECT_EQ(cpld.values()[0], 0x08);
+}
+
+TEST_F(PsuTopologyTest, UnmappedBitsAreIgnored)
+{
+    auto source = std::make_unique<FakeRegisterSource>(registers);
+    CpldMonitor cpld(secondCpld(), std::move(source));
+    cpld.read();
+    apply(cpld);
+
+    registers[0x25] = 0xc0;
+    registers[0x28] = 0x82;
+    cpld.read();
+    EXPECT_TRUE(apply(cpld).empty());
+    EXPECT_FALSE(activity);
+}
+
+TEST_F(PsuTopologyTest, FailedReadIsDiscarded)
+{
+    auto fake = std::make_unique<FakeRegisterSource>(registers);
+    auto source = fake.get();
+    CpldMonitor cpld(secondCpld(), std::move(fake));
+
+    // nothing is known before the first successful read
+    source->fail = true;
+    EXPECT_TRUE(sample(cpld).empty());
+    EXPECT_TRUE(activity);
+    EXPECT_TRUE(sample(cpld).empty());
+    EXPECT_FALSE(activity);
+
+    source->fail = false;
+    EXPECT_EQ(sample(cpld).size(), 20u);
+
+    // a failed read no longer reads as all ones
+    source->fail = true;
+    EXPECT_TRUE(sample(cpld).empty());
+    EXPECT_TRUE(activity);
+    EXPECT_TRUE(sample(cpld).empty());
+    EXPECT_FALSE(activity);
+    EXPECT_EQ(cpld.discarded(), 4u);
+    EXPECT_EQ(cpld.values()[0], 0x00);
+}
+
+TEST_F(PsuTopologyTest, DebounceFiltersSingleSampleGlitches)
+{
+    auto config = secondCpld();
+    config.debounce = 3;
+    auto fake = std::make_unique<FakeRegisterSource>(registers);
+    auto source = fake.get();
+    CpldMonitor cpld(config, std::move(fake));
+    sample(cpld);
+
+    // noise: one sample with a flipped bit, then the value read before,
+    // and failed reads in between which do not break the pattern
+    const std::vector<std::pair<uint8_t, int32_t>> noise{
+        {0x25, 0x01}, {0x26, 0x02}, {0x27, 0x3f}, {0x28, 0x81}, {0x28, 0x00}};
+    for (const auto& [address, value] : noise)
+    {
+        auto previous = registers[address];
+        registers[address] = value;
+        EXPECT_TRUE(sample(cpld).empty());
+        EXPECT_TRUE(activity);
+        source->fail = true;
+        EXPECT_TRUE(sample(cpld).empty());
+        source->fail = false;
+        registers[address] = previous;
+        EXPECT_TRUE(sample(cpld).empty());
+    }
+    // one glitch per flipped bit
+    EXPECT_EQ(cpld.glitches(), 1u + 1u + 6u + 1u + 1u);
+    EXPECT_FALSE(activity);
+}
+
+TEST_F(PsuTopologyTest, DebounceAcceptsSustainedChange)
+{
+    auto config = secondCpld();
+    config.debounce = 3;
+    auto fake = std::make_unique<FakeRegisterSource>(registers);
+    auto source = fake.get();
+    CpldMonitor cpld(config, std::move(fake));
+    sample(cpld);
+
+    registers[0x27] = 0x04;
+    EXPECT_TRUE(sample(cpld).empty());
+    source->fail = true;
+    EXPECT_TRUE(sample(cpld).empty());
+    source->fail = false;
+    EXPECT_TRUE(sample(cpld).empty());
+    EXPECT_EQ(sample(cpld),
+              (Published{{BitKind::Functional, 8, false}}));
+    EXPECT_TRUE(activity);
+    EXPECT_EQ(cpld.glitches(), 0u);
+
+    // stable again, no more fast sampling
+    EXPECT_TRUE(sample(cpld).empty());
+    EXPECT_FALSE(activity);
+}
+
+TEST_F(PsuTopologyTest, DebouncePerBit)
+{
+    auto config = secondCpld();
+    config.debounce = 2;
+    // psu 6 is debounced longer, the drop event is published at once
+    config.psus[0].debounce = 4;
+    config.events[0].debounce = 1;
+    auto fake = std::make_unique<FakeRegisterSource>(registers);
+    CpldMonitor cpld(config, std::move(fake));
+    sample(cpld);
+
+    registers[0x25] = 0x03;
+    registers[0x28] = 0x81;
+    EXPECT_EQ(sample(cpld), (Published{{BitKind::Event, 0, true}}));
+    EXPECT_EQ(sample(cpld), (Published{{BitKind::Present, 7, false}}));
+    EXPECT_TRUE(sample(cpld).empty());
+    EXPECT_EQ(sample(cpld), (Published{{BitKind::Present, 6, false}}));
+}
+
+TEST_F(PsuTopologyTest, RandomNoiseIsNeverPublished)
+{
+    auto config = secondCpld();
+    config.debounce = 2;
+    auto fake = std::make_unique<FakeRegisterSource>(registers);
+    CpldMonitor cpld(config, std::move(fake));
+    sample(cpld);
+
+    // isolated single bit flips of the psu bits of a register
+    const std::map<uint8_t, int32_t> stable = registers;
+    uint32_t lfsr = 0xace1;
+    unsigned flips = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        registers = stable;
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xb400u);
+        if (i % 2 == 0 && lfsr % 3 == 0)
+        {
+            uint8_t address = 0x25 + lfsr % 3;
+            registers[address] ^= 1 << (lfsr % 6);
+            flips++;
+        }
+        EXPECT_TRUE(sample(cpld).empty());
+    }
+    EXPECT_GT(flips, 100u);
+    EXPECT_EQ(cpld.glitches(), flips);
+}
+
+TEST_F(PsuTopologyTest, AcceptedChangesAreJournaled)
+{
+    auto config = secondCpld();
+    config.debounce = 2;
+    auto fake = std::make_unique<FakeRegisterSource>(registers);
+    CpldMonitor cpld(config, std::move(fake));
+    TransitionJournal journal(16);
+    cpld.setJournal(&journal, 1);
+
+    // the initial state is not a transition
+    sample(cpld);
+    EXPECT_EQ(journal.recorded(), 0u);
+
+    // a glitch is not journaled
+    registers[0x26] = 0x01;
+    sample(cpld);
+    registers[0x26] = 0x00;
+    sample(cpld);
+    EXPECT_EQ(journal.recorded(), 0u);
+
+    registers[0x25] = 0x08;
+    registers[0x28] = 0x81;
+    sample(cpld);
+    sample(cpld);
+    auto transitions = journal.snapshot();
+    ASSERT_EQ(transitions.size(), 2u);
+    EXPECT_EQ(transitions[0].cpld, 1u);
+    EXPECT_EQ(transitions[0].registerAddress, 0x25);
+    EXPECT_EQ(transitions[0].bit, 3u);
+    EXPECT_TRUE(transitions[0].value);
+    EXPECT_EQ(transitions[1].registerAddress, 0x28);
+    EXPECT_EQ(transitions[1].bit, 0u);
+    EXPECT_LE(transitions[0].monotonicUs, transitions[1].monotonicUs);
+}
+
+TEST_F(PsuTopologyTest, InvalidConfigThrows)
+{
+    auto config = secondCpld();
+    config.events.push_back(EventConfig{"bad", "PSU_MISSING", 1});
+    EXPECT_THROW(CpldMonitor(config,
+                             std::make_unique<FakeRegisterSource>(registers)),
+                 std::invalid_argument);
+
+    config = secondCpld();
+    config.psus.push_back(PsuBitConfig{12, 8});
+    EXPECT_THROW(CpldMonitor(config,
+                             std::make_unique<FakeRegisterSource>(registers)),
+                 std::invalid_argument);
+}
+
+TEST(PsuIndexOfPath, ExactIndex)
+{
+    const std::string base = "/xyz/openbmc_project/inventory/system/chassis/";
+    EXPECT_EQ(psuIndexOfPath(base + "powersupply0"), 0u);
+    EXPECT_EQ(psuIndexOfPath(base + "powersupply11"), 11u);
+    EXPECT_EQ(psuIndexOfPath(base + "powersupply"), std::nullopt);
+    EXPECT_EQ(psuIndexOfPath(base + "powersupply1_fan"), std::nullopt);
+    EXPECT_EQ(psuIndexOfPath(base + "fan0"), std::nullopt);
+}
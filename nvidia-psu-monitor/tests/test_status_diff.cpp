@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StatusDiff.hpp"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::psumonitor;
+
+static std::vector<unsigned> bits(uint32_t value)
+{
+    std::vector<unsigned> indices;
+    forEachBit(value, [&](unsigned i) { indices.push_back(i); });
+    return indices;
+}
+
+TEST(StatusDiff, OnlyChangedBits)
+{
+    EXPECT_EQ(changedBits(0x15, 0x15, 0x3f), 0u);
+    EXPECT_EQ(bits(changedBits(0x15, 0x17, 0x3f)), (std::vector<unsigned>{1}));
+    EXPECT_EQ(bits(changedBits(0x01, 0x20, 0x3f)),
+              (std::vector<unsigned>{0, 5}));
+    // bits outside the mask are ignored
+    EXPECT_EQ(changedBits(0x00, 0xc0, 0x3f), 0u);
+    EXPECT_EQ(changedBits(0x00, 0x00, 0x3f, true), 0x3fu);
+}
+
+TEST(StatusDiff, FailedReadFlipsZeroBits)
+{
+    // a failed read reads as all ones, as the bitsets did
+    EXPECT_EQ(bits(changedBits(0x3c, -1, 0x3f)), (std::vector<unsigned>{0, 1}));
+    EXPECT_EQ(bits(changedBits(-1, 0x3e, 0x3f)), (std::vector<unsigned>{0}));
+    EXPECT_TRUE(bitValue(-1, 5));
+    EXPECT_FALSE(bitValue(0x10, 5));
+    EXPECT_TRUE(bitValue(0x50, 6));
+}
+
+TEST(StatusDiff, BatchCoalesces)
+{
+    UpdateBatch<bool> batch;
+    EXPECT_TRUE(batch.add("/psu0", "iface", "Present", true));
+    EXPECT_FALSE(batch.add("/psu1", "iface", "Present", true));
+    EXPECT_FALSE(batch.add("/psu0", "iface", "Present", false));
+    EXPECT_EQ(batch.size(), 2u);
+
+    auto updates = batch.take();
+    EXPECT_EQ(batch.size(), 0u);
+    ASSERT_EQ(updates.size(), 2u);
+    EXPECT_FALSE(updates.begin()->second);
+
+    // the next update schedules a new flush
+    EXPECT_TRUE(batch.add("/psu0", "iface", "Present", true));
+}
@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TransitionJournal.hpp"
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::psumonitor;
+
+/** @brief transition whose fields all derive from its sequence number */
+static Transition numbered(uint64_t n)
+{
+    return Transition{n, n * 3, static_cast<uint16_t>(n % 7),
+                      static_cast<uint8_t>(n % 251),
+                      static_cast<uint8_t>(n % 8), n % 2 == 1};
+}
+
+TEST(TransitionJournal, KeepsOrder)
+{
+    TransitionJournal journal(8);
+    EXPECT_TRUE(journal.snapshot().empty());
+    for (uint64_t n = 0; n < 5; n++)
+    {
+        journal.record(numbered(n));
+    }
+    auto transitions = journal.snapshot();
+    ASSERT_EQ(transitions.size(), 5u);
+    for (uint64_t n = 0; n < 5; n++)
+    {
+        EXPECT_EQ(transitions[n], numbered(n));
+    }
+}
+
+TEST(TransitionJournal, OverwritesOldest)
+{
+    TransitionJournal journal(6);
+    EXPECT_EQ(journal.capacity(), 8u);
+    for (uint64_t n = 0; n < 20; n++)
+    {
+        journal.record(numbered(n));
+    }
+    auto transitions = journal.snapshot();
+    ASSERT_EQ(transitions.size(), 8u);
+    EXPECT_EQ(transitions.front(), numbered(12));
+    EXPECT_EQ(transitions.back(), numbered(19));
+    EXPECT_EQ(journal.recorded(), 20u);
+}
+
+TEST(TransitionJournal, Timestamps)
+{
+    TransitionJournal journal;
+    journal.record(1, 0x25, 3, true);
+    journal.record(1, 0x28, 4, false);
+    auto transitions = journal.snapshot();
+    ASSERT_EQ(transitions.size(), 2u);
+    EXPECT_LE(transitions[0].monotonicUs, transitions[1].monotonicUs);
+    EXPECT_GT(transitions[0].realtimeUs, 1600000000000000u);
+    EXPECT_EQ(transitions[1].registerAddress, 0x28);
+    EXPECT_EQ(transitions[1].bit, 4);
+    EXPECT_FALSE(transitions[1].value);
+}
+
+TEST(TransitionJournal, ConcurrentSnapshotsAreNeverTorn)
+{
+    TransitionJournal journal(64);
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+        for (uint64_t n = 0; n < 2000000; n++)
+        {
+            journal.record(numbered(n));
+        }
+        done = true;
+    });
+
+    uint64_t snapshots = 0;
+    while (!done)
+    {
+        auto transitions = journal.snapshot();
+        for (size_t i = 0; i < transitions.size(); i++)
+        {
+            auto n = transitions[i].monotonicUs;
+            ASSERT_EQ(transitions[i], numbered(n));
+            if (i > 0)
+            {
+                ASSERT_EQ(n, transitions[i - 1].monotonicUs + 1);
+            }
+        }
+        snapshots++;
+    }
+    writer.join();
+    EXPECT_GT(snapshots, 0u);
+}
+
+TEST(TransitionJournal, RecordingIsCheap)
+{
+    TransitionJournal journal;
+    constexpr int count = 1000000;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < count; n++)
+    {
+        journal.record(0, 0x25, n % 8, n % 2);
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    // two clock reads and five stores, far below a fast poll period
+    EXPECT_LT(elapsed.count() / count, 1000);
+}
@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Broker of the chassis power cap requests of several clients.
+ *
+ * Every client, identified by an owner id, holds at most one request with a
+ * lease. The most restrictive unexpired request is enforced, so that clients
+ * no longer overwrite each other and the cap only moves when the enforced
+ * value changes.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+namespace nvidia::power::broker
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct CapRequest
+{
+    std::string owner;
+    /** @brief chassis power cap in watts */
+    uint32_t cap;
+    /** @brief higher wins between requests of the same cap */
+    uint8_t priority;
+    Clock::time_point expires;
+};
+
+/**
+ * @class CapBroker
+ *
+ * Unexpired cap requests keyed by owner.
+ */
+class CapBroker
+{
+  public:
+    /**
+     * @brief Add or replace the request of an owner
+     *
+     * @param[in] request - the request, its lease expires at request.expires
+     * @return true if the winning request changed
+     */
+    bool submit(const CapRequest& request)
+    {
+        auto before = winner();
+        requests[request.owner] = request;
+        return changed(before);
+    }
+
+    /**
+     * @brief Drop the request of an owner before its lease expires
+     *
+     * @return true if the winning request changed
+     */
+    bool release(const std::string& owner)
+    {
+        auto before = winner();
+        requests.erase(owner);
+        return changed(before);
+    }
+
+    /**
+     * @brief Drop the requests whose lease expired
+     *
+     * @param[in] now - current time
+     * @return true if the winning request changed
+     */
+    bool expire(Clock::time_point now)
+    {
+        auto before = winner();
+        std::erase_if(requests, [now](const auto& entry) {
+            return entry.second.expires <= now;
+        });
+        return changed(before);
+    }
+
+    /** @brief the enforced request: lowest cap, then highest priority, then
+     * the lease expiring last */
+    std::optional<CapRequest> winner() const
+    {
+        const CapRequest* best = nullptr;
+        for (const auto& [owner, request] : requests)
+        {
+            if (!best || request.cap < best->cap ||
+                (request.cap == best->cap &&
+                 (request.priority > best->priority ||
+                  (request.priority == best->priority &&
+                   request.expires > best->expires))))
+            {
+                best = &request;
+            }
+        }
+        if (!best)
+        {
+            return std::nullopt;
+        }
+        return *best;
+    }
+
+    /** @brief expiry of the next lease, nullopt without requests */
+    std::optional<Clock::time_point> nextExpiry() const
+    {
+        std::optional<Clock::time_point> next;
+        for (const auto& [owner, request] : requests)
+        {
+            if (!next || request.expires < *next)
+            {
+                next = request.expires;
+            }
+        }
+        return next;
+    }
+
+    size_t size() const
+    {
+        return requests.size();
+    }
+
+  private:
+    bool changed(const std::optional<CapRequest>& before) const
+    {
+        auto after = winner();
+        if (!before || !after)
+        {
+            return before.has_value() != after.has_value();
+        }
+        return before->owner != after->owner || before->cap != after->cap ||
+               before->priority != after->priority;
+    }
+
+    std::map<std::string, CapRequest> requests;
+};
+
+} // namespace nvidia::power::broker
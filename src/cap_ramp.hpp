@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Slew rate limited ramping of the module caps.
+ *
+ * When the targets change, all modules move linearly from their current cap
+ * to their target over the same duration. The duration is chosen so that
+ * the chassis power, summed over all devices, is neither lowered nor raised
+ * faster than the configured rates.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace nvidia::power::ramp
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct RampPolicy
+{
+    /** @brief chassis watts per second, 0 to raise at once */
+    uint32_t upWattsPerSecond = 0;
+    /** @brief chassis watts per second, 0 to lower at once */
+    uint32_t downWattsPerSecond = 0;
+};
+
+/**
+ * @class CapRamp
+ *
+ * Ramp of the per device caps of the modules.
+ */
+class CapRamp
+{
+  public:
+    /**
+     * @param[in] policy - ramp rates
+     * @param[in] devices - number of devices of each module
+     */
+    CapRamp(const RampPolicy& policy, std::vector<uint32_t> devices) :
+        policy(policy), devices(std::move(devices))
+    {}
+
+    /**
+     * @brief Start over from the given caps with nothing left to ramp, used
+     * at start up and when the caps were moved outside of the ramp
+     *
+     * @param[in] caps - per device cap of each module
+     * @param[in] now - current time
+     */
+    void restart(const std::vector<uint32_t>& caps, Clock::time_point now)
+    {
+        start = caps;
+        end = caps;
+        startTime = now;
+        duration = Clock::duration::zero();
+    }
+
+    /**
+     * @brief Ramp towards new targets from the caps reached so far
+     *
+     * @param[in] targets - per device cap of each module
+     * @param[in] now - current time
+     * @return true if the targets changed
+     */
+    bool retarget(const std::vector<uint32_t>& targets, Clock::time_point now)
+    {
+        if (targets == end)
+        {
+            return false;
+        }
+        start = start.empty() ? targets : caps(now);
+        end = targets;
+        startTime = now;
+
+        uint64_t down = 0;
+        uint64_t up = 0;
+        for (size_t i = 0; i < end.size(); i++)
+        {
+            if (end[i] < start[i])
+            {
+                down += uint64_t{start[i] - end[i]} * devices[i];
+            }
+            else
+            {
+                up += uint64_t{end[i] - start[i]} * devices[i];
+            }
+        }
+        auto seconds = std::max(
+            policy.downWattsPerSecond
+                ? static_cast<double>(down) / policy.downWattsPerSecond
+                : 0.0,
+            policy.upWattsPerSecond
+                ? static_cast<double>(up) / policy.upWattsPerSecond
+                : 0.0);
+        duration = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(seconds));
+        return true;
+    }
+
+    /**
+     * @brief Caps reached at a given time
+     *
+     * Caps being lowered are rounded down and caps being raised are rounded
+     * up only at the end, so that the chassis budget also holds during the
+     * ramp.
+     */
+    std::vector<uint32_t> caps(Clock::time_point now) const
+    {
+        if (!ramping(now))
+        {
+            return end;
+        }
+        auto progress = std::chrono::duration<double>(now - startTime) /
+                        std::chrono::duration<double>(duration);
+        std::vector<uint32_t> current(end.size());
+        for (size_t i = 0; i < end.size(); i++)
+        {
+            auto delta = (static_cast<double>(end[i]) - start[i]) * progress;
+            current[i] = end[i] < start[i]
+                             ? start[i] - static_cast<uint32_t>(std::ceil(-delta))
+                             : start[i] + static_cast<uint32_t>(delta);
+        }
+        return current;
+    }
+
+    bool ramping(Clock::time_point now) const
+    {
+        return now < startTime + duration;
+    }
+
+    /** @brief time the targets are reached */
+    Clock::time_point eta() const
+    {
+        return startTime + duration;
+    }
+
+    const std::vector<uint32_t>& targets() const
+    {
+        return end;
+    }
+
+  private:
+    RampPolicy policy;
+    std::vector<uint32_t> devices;
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> end;
+    Clock::time_point startTime{};
+    Clock::duration duration{};
+};
+
+} // namespace nvidia::power::ramp
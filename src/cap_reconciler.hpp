@@ -0,0 +1,152 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Reconciliation of the module caps with the caps the targets report.
+ *
+ * Each cycle compares the cap reported by every target with the desired one.
+ * A target still reporting another cap one cycle after the desired cap was
+ * set has drifted and the cap is pushed again. While the mismatch persists
+ * the pushes back off exponentially up to a maximum interval.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace nvidia::power::reconcile
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct ReconcilePolicy
+{
+    /** @brief wait after the first push, doubled by each push that did not
+     * fix the mismatch */
+    Clock::duration backoff = std::chrono::seconds(1);
+    Clock::duration maxBackoff = std::chrono::seconds(60);
+};
+
+enum class Decision
+{
+    /** @brief the target reports the desired cap, or its report is
+     * unknown */
+    InSync,
+    /** @brief the cap is pushed */
+    Push,
+    /** @brief mismatch, waiting for the desired cap to settle or for the
+     * backoff */
+    Wait,
+};
+
+/**
+ * @class CapReconciler
+ *
+ * Drift state of each target.
+ */
+class CapReconciler
+{
+  public:
+    CapReconciler(const ReconcilePolicy& policy, size_t targets) :
+        policy(policy), states(targets)
+    {}
+
+    /**
+     * @brief Account the cap reported by a target
+     *
+     * @param[in] target - target index
+     * @param[in] reported - cap reported, nullopt if unknown
+     * @param[in] desired - cap the target should report
+     * @param[in] now - current time
+     */
+    Decision observe(size_t target, std::optional<uint32_t> reported,
+                     uint32_t desired, Clock::time_point now)
+    {
+        auto& state = states[target];
+        if (state.desired != desired)
+        {
+            // the new cap is on its way, give it a cycle
+            state = TargetState{};
+            state.desired = desired;
+            return reported && *reported != desired ? Decision::Wait
+                                                    : Decision::InSync;
+        }
+        if (!reported || *reported == desired)
+        {
+            state.mismatched = false;
+            state.pushes = 0;
+            return Decision::InSync;
+        }
+        if (!state.mismatched)
+        {
+            state.mismatched = true;
+            driftCount++;
+        }
+        if (state.pushes > 0 && now < state.nextPush)
+        {
+            return Decision::Wait;
+        }
+        auto backoff = policy.backoff;
+        for (uint32_t i = 0; i < state.pushes && backoff < policy.maxBackoff;
+             i++)
+        {
+            backoff *= 2;
+        }
+        state.nextPush = now + std::min(backoff, policy.maxBackoff);
+        state.pushes++;
+        pushCount++;
+        return Decision::Push;
+    }
+
+    /** @brief targets whose mismatch was seen and not fixed yet */
+    uint32_t mismatched() const
+    {
+        return std::count_if(states.begin(), states.end(),
+                             [](const auto& state) { return state.mismatched; });
+    }
+
+    /** @brief mismatches seen with a settled desired cap */
+    uint64_t drifts() const
+    {
+        return driftCount;
+    }
+
+    uint64_t pushes() const
+    {
+        return pushCount;
+    }
+
+  private:
+    struct TargetState
+    {
+        std::optional<uint32_t> desired;
+        bool mismatched = false;
+        uint32_t pushes = 0;
+        Clock::time_point nextPush{};
+    };
+
+    ReconcilePolicy policy;
+    std::vector<TargetState> states;
+    uint64_t driftCount = 0;
+    uint64_t pushCount = 0;
+};
+
+} // namespace nvidia::power::reconcile
@@ -0,0 +1,44 @@
+#!/bin/sh
+
+# Help - nvidia-power-cap-stage.sh [chassis instance]
+# Stage the module power caps ahead of a chassis power on and wait for them
+# to be acknowledged. The instance selects the power manager object of the
+# chassis named after it, instance 0 falls back to the unnamed chassis. The
+# wait is bounded by the timeoutMs of powerOnStaging, a staging which timed
+# out exits 1. The unit is only wanted by the power on target, so the power
+# on is never held back by a failure.
+
+service=com.Nvidia.Powermanager
+base=/com/Nvidia/Powermanager
+iface=com.Nvidia.Powermanager.PowerOnStaging
+instance=${1:-0}
+
+path=$base/$instance
+if ! busctl introspect $service $path $iface > /dev/null 2>&1; then
+    if [ "$instance" != "0" ]; then
+        echo "Power on staging not available for chassis $instance" >&2
+        exit 0
+    fi
+    path=$base
+fi
+
+if ! busctl call $service $path $iface Stage; then
+    echo "Power on staging not available on $path" >&2
+    exit 0
+fi
+
+# upper bound in case the daemon goes away while staging
+for i in $(seq 1 150); do
+    state=$(busctl get-property $service $path $iface State | cut -d '"' -f 2)
+    if [ "$state" = "TimedOut" ]; then
+        echo "Power on caps not acknowledged on $path" >&2
+        exit 1
+    fi
+    if [ "$state" != "Staging" ]; then
+        echo "Power on caps $state"
+        exit 0
+    fi
+    sleep 0.1
+done
+echo "Power on staging still running on $path" >&2
+exit 1
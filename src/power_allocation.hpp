@@ -0,0 +1,154 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Split of the chassis power limit into module caps.
+ *
+ * Used both to apply a chassis limit and to preview the caps a hypothetical
+ * limit would give, so that both always agree. Each module gets its
+ * percentage of the chassis limit, or, when the power of the rest of the
+ * system is known, its share of what the rest of the system leaves.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace nvidia::power::allocation
+{
+
+/** @brief Share of the chassis limit given to a module */
+struct ModuleShare
+{
+    int percentage;
+    int numOfDevices;
+    /** @brief range of the cap of a device */
+    uint32_t min;
+    uint32_t max;
+};
+
+/** @brief Violation of a cap range */
+struct Violation
+{
+    /** @brief index of the module, -1 for the chassis limit */
+    int module;
+    uint32_t value;
+    uint32_t min;
+    uint32_t max;
+};
+
+/**
+ * @brief Cap of a device of a module
+ *
+ * @param[in] chassisLimit - chassis power limit
+ * @param[in] percentage - percentage of the chassis limit for the module
+ * @param[in] numOfDevices - number of devices in the module
+ */
+inline uint32_t moduleCap(uint32_t chassisLimit, int percentage,
+                          int numOfDevices)
+{
+    return (chassisLimit * (static_cast<float>(percentage) / 100)) /
+           numOfDevices;
+}
+
+/**
+ * @brief Cap of a device of a module sharing the power left by the rest of
+ * the system with the other modules in proportion of their percentages
+ *
+ * @param[in] budget - chassis limit minus the rest of system power
+ * @param[in] percentage - percentage of the module
+ * @param[in] totalPercentage - sum of the percentages of all modules
+ * @param[in] numOfDevices - number of devices in the module
+ */
+inline uint32_t moduleBudgetCap(uint32_t budget, int percentage,
+                                int totalPercentage, int numOfDevices)
+{
+    if (totalPercentage <= 0)
+    {
+        return 0;
+    }
+    return (budget * (static_cast<float>(percentage) / totalPercentage)) /
+           numOfDevices;
+}
+
+/**
+ * @brief Module caps of a chassis limit and the ranges they violate
+ *
+ * @param[in] chassisLimit - chassis power limit
+ * @param[in] chassisMin - lowest allowed chassis limit
+ * @param[in] chassisMax - highest allowed chassis limit
+ * @param[in] modules - share of each module
+ * @param[out] caps - cap of a device of each module, indexed like modules
+ * @param[out] violations - ranges violated, empty if the limit is valid
+ * @param[in] restOfSystemPower - power of the rest of the system, nullopt
+ * to split the chassis limit by percentages. The caps computed from it are
+ * bounded by the module maximum.
+ *
+ * The outputs are cleared and refilled so that repeated calls reuse their
+ * storage.
+ */
+inline void allocate(uint32_t chassisLimit, uint32_t chassisMin,
+                     uint32_t chassisMax,
+                     const std::vector<ModuleShare>& modules,
+                     std::vector<uint32_t>& caps,
+                     std::vector<Violation>& violations,
+                     std::optional<uint32_t> restOfSystemPower = std::nullopt)
+{
+    caps.clear();
+    violations.clear();
+    if (chassisLimit < chassisMin || chassisLimit > chassisMax)
+    {
+        violations.push_back(
+            Violation{-1, chassisLimit, chassisMin, chassisMax});
+    }
+    int totalPercentage = 0;
+    for (const auto& module : modules)
+    {
+        totalPercentage += module.percentage;
+    }
+    uint32_t budget = 0;
+    if (restOfSystemPower && *restOfSystemPower < chassisLimit)
+    {
+        budget = chassisLimit - *restOfSystemPower;
+    }
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        const auto& module = modules[i];
+        auto cap = restOfSystemPower
+                       ? moduleBudgetCap(budget, module.percentage,
+                                         totalPercentage, module.numOfDevices)
+                       : moduleCap(chassisLimit, module.percentage,
+                                   module.numOfDevices);
+        if (restOfSystemPower)
+        {
+            // the power left may exceed what the devices can take
+            cap = std::min(cap, module.max);
+        }
+        if (cap < module.min || cap > module.max)
+        {
+            violations.push_back(Violation{static_cast<int>(i), cap,
+                                           module.min, module.max});
+        }
+        caps.push_back(cap);
+    }
+}
+
+} // namespace nvidia::power::allocation
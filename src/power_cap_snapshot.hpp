@@ -0,0 +1,289 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Shared memory snapshot of the power capping state published by
+ * nvidia-power-mgrd.
+ *
+ * The daemon keeps the snapshot file under /run up to date whenever a power
+ * capping property or a module cap changes. Readers map the file read-only and
+ * get a consistent copy without any D-Bus traffic:
+ *
+ *     nvidia::power::snapshot::SnapshotReader reader;
+ *     nvidia::power::snapshot::PowerCapState state;
+ *     if (reader.read(state))
+ *     {
+ *         ...
+ *     }
+ *
+ * The file is protected by a sequence lock, a reader retries while the daemon
+ * is in the middle of an update.
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+namespace nvidia::power::snapshot
+{
+
+constexpr auto defaultSnapshotPath =
+    "/run/nvidia-power-manager/powerCap.snapshot";
+
+constexpr uint32_t snapshotMagic = 0x50434e53; // "SNCP"
+constexpr uint32_t snapshotVersion = 1;
+
+/** @brief upper bound of the module_num build option */
+constexpr size_t maxModules = 4;
+constexpr size_t maxAllocations = 16;
+constexpr size_t moduleNameSize = 32;
+
+/** @brief Module cap computed by the power capping algorithm */
+struct ModuleAllocation
+{
+    char module[moduleNameSize];
+    uint32_t powerCap;
+};
+
+/** @brief Copy of PowerCappingInfo plus the computed allocations */
+struct PowerCapState
+{
+    /** @brief incremented on every update published by the daemon */
+    uint64_t generation;
+    uint8_t mode;
+    uint32_t currentPowerLimit;
+    uint32_t chassisPowerLimit_P;
+    uint32_t chassisPowerLimit_Q;
+    uint32_t chassisPowerLimit_Min;
+    uint32_t chassisPowerLimit_Max;
+    uint32_t restOfSystemPower;
+    uint32_t moduleCount;
+    uint32_t modulePowerLimit[maxModules];
+    uint32_t modulePowerLimit_Min[maxModules];
+    uint32_t modulePowerLimit_Max[maxModules];
+    uint32_t modulePowerLimitPercentage[maxModules];
+    uint32_t allocationCount;
+    ModuleAllocation allocations[maxAllocations];
+};
+
+/** @brief Layout of the snapshot file */
+struct Snapshot
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    /** @brief odd while the daemon is writing the state */
+    std::atomic<uint32_t> sequence;
+    PowerCapState state;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "snapshot sequence must be lock free to be shared");
+
+/**
+ * @class SnapshotReader
+ *
+ * Maps the snapshot file read-only and returns consistent copies of it.
+ */
+class SnapshotReader
+{
+  public:
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    /**
+     * @param[in] path - the absolute path of the snapshot file
+     */
+    explicit SnapshotReader(const char* path = defaultSnapshotPath)
+    {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return;
+        }
+        struct stat st
+        {};
+        if (fstat(fd, &st) == 0 &&
+            static_cast<size_t>(st.st_size) >= sizeof(Snapshot))
+        {
+            void* addr = mmap(nullptr, sizeof(Snapshot), PROT_READ, MAP_SHARED,
+                              fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                snapshot = static_cast<const Snapshot*>(addr);
+            }
+        }
+        close(fd);
+    }
+
+    ~SnapshotReader()
+    {
+        if (snapshot != nullptr)
+        {
+            munmap(const_cast<Snapshot*>(snapshot), sizeof(Snapshot));
+        }
+    }
+
+    /** @brief true if the file is mapped and was written by a compatible
+     * daemon */
+    bool valid() const
+    {
+        return snapshot != nullptr && snapshot->magic == snapshotMagic &&
+               snapshot->version == snapshotVersion &&
+               snapshot->size == sizeof(Snapshot);
+    }
+
+    /**
+     * @brief Copy a consistent power capping state
+     *
+     * @param[out] state - filled in with the current state
+     * @param[in] maxRetries - attempts before giving up on a busy writer
+     *
+     * @return true on success
+     */
+    bool read(PowerCapState& state, unsigned maxRetries = 1000) const
+    {
+        if (!valid())
+        {
+            return false;
+        }
+        for (unsigned i = 0; i < maxRetries; i++)
+        {
+            uint32_t begin = snapshot->sequence.load(std::memory_order_acquire);
+            if (begin & 1)
+            {
+                continue;
+            }
+            std::memcpy(&state, &snapshot->state, sizeof(PowerCapState));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (snapshot->sequence.load(std::memory_order_relaxed) == begin)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    const Snapshot* snapshot = nullptr;
+};
+
+/**
+ * @class SnapshotWriter
+ *
+ * Used by nvidia-power-mgrd to create and update the snapshot file.
+ */
+class SnapshotWriter
+{
+  public:
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    /**
+     * @param[in] path - the absolute path of the snapshot file
+     */
+    explicit SnapshotWriter(const std::string& path)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(
+            std::filesystem::path(path).parent_path(), ec);
+
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return;
+        }
+        if (ftruncate(fd, sizeof(Snapshot)) == 0)
+        {
+            void* addr = mmap(nullptr, sizeof(Snapshot),
+                              PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                snapshot = static_cast<Snapshot*>(addr);
+            }
+        }
+        close(fd);
+        if (snapshot == nullptr)
+        {
+            return;
+        }
+
+        // keep counting from a previous instance so that readers which
+        // already mapped the file never see the sequence going backwards
+        uint32_t sequence = snapshot->sequence.load(std::memory_order_relaxed);
+        if (snapshot->magic != snapshotMagic || (sequence & 1))
+        {
+            // a previous instance died in the middle of an update
+            sequence += sequence & 1;
+            snapshot->sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memset(&snapshot->state, 0, sizeof(PowerCapState));
+            snapshot->magic = snapshotMagic;
+            snapshot->version = snapshotVersion;
+            snapshot->size = sizeof(Snapshot);
+            snapshot->sequence.store(sequence + 2, std::memory_order_release);
+        }
+        generation = snapshot->state.generation;
+    }
+
+    ~SnapshotWriter()
+    {
+        if (snapshot != nullptr)
+        {
+            munmap(snapshot, sizeof(Snapshot));
+        }
+    }
+
+    bool valid() const
+    {
+        return snapshot != nullptr;
+    }
+
+    /**
+     * @brief Publish a new state, the generation counter is assigned here
+     *
+     * @param[in] state - the state to publish
+     */
+    void write(const PowerCapState& state)
+    {
+        if (snapshot == nullptr)
+        {
+            return;
+        }
+        uint32_t sequence = snapshot->sequence.load(std::memory_order_relaxed);
+        snapshot->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&snapshot->state, &state, sizeof(PowerCapState));
+        snapshot->state.generation = ++generation;
+        snapshot->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+  private:
+    Snapshot* snapshot = nullptr;
+    uint64_t generation = 0;
+};
+
+} // namespace nvidia::power::snapshot
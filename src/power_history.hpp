@@ -0,0 +1,511 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Compressed in-memory history of the power telemetry.
+ *
+ * A series holds samples of several values sharing one timestamp, encoded as
+ * in Facebook's Gorilla: timestamps as delta of delta and values as the XOR
+ * with the previous value of the same column. Samples are appended to time
+ * blocks, the oldest blocks are dropped once they fall out of the retention.
+ *
+ * Samples are ordered and integrated on a monotonic clock, each block keeps
+ * the offset of the wall clock so that the queries use wall clock times. A
+ * step of the wall clock starts a new block with the new offset.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <vector>
+
+namespace nvidia::power::history
+{
+
+/** @brief Bit stream, most significant bit first */
+class BitWriter
+{
+  public:
+    void write(uint64_t value, unsigned count)
+    {
+        for (unsigned i = count; i > 0; i--)
+        {
+            if (bits % 8 == 0)
+            {
+                bytes.push_back(0);
+            }
+            if ((value >> (i - 1)) & 1)
+            {
+                bytes.back() |= 0x80 >> (bits % 8);
+            }
+            bits++;
+        }
+    }
+
+    size_t size() const
+    {
+        return bits;
+    }
+
+    size_t capacity() const
+    {
+        return bytes.capacity();
+    }
+
+    void shrink()
+    {
+        bytes.shrink_to_fit();
+    }
+
+    const std::vector<uint8_t>& data() const
+    {
+        return bytes;
+    }
+
+  private:
+    std::vector<uint8_t> bytes;
+    size_t bits = 0;
+};
+
+class BitReader
+{
+  public:
+    explicit BitReader(const BitWriter& writer) :
+        bytes(writer.data()), bits(writer.size())
+    {}
+
+    uint64_t read(unsigned count)
+    {
+        uint64_t value = 0;
+        for (unsigned i = 0; i < count && position < bits; i++, position++)
+        {
+            value = (value << 1) |
+                    ((bytes[position / 8] >> (7 - position % 8)) & 1);
+        }
+        return value;
+    }
+
+    bool done() const
+    {
+        return position >= bits;
+    }
+
+  private:
+    const std::vector<uint8_t>& bytes;
+    size_t bits;
+    size_t position = 0;
+};
+
+struct SeriesPolicy
+{
+    /** @brief span of a block */
+    int64_t blockMs = 3600 * 1000;
+    /** @brief samples older than this are dropped a block at a time */
+    int64_t retentionMs = 24 * 3600 * 1000;
+    /** @brief wall clock moves against the monotonic clock taken as a step */
+    int64_t stepToleranceMs = 1000;
+};
+
+struct Sample
+{
+    int64_t timeMs;
+    std::vector<double> values;
+};
+
+/** @brief Samples of one column within a bucket, NaN samples are skipped */
+struct Bucket
+{
+    int64_t startMs;
+    double min;
+    double max;
+    double avg;
+    uint32_t count;
+};
+
+/**
+ * @class Series
+ *
+ * Gorilla compressed samples of a fixed number of columns.
+ */
+class Series
+{
+  public:
+    Series(size_t columns, const SeriesPolicy& policy = SeriesPolicy{}) :
+        columns(columns), policy(policy), energy(columns, 0.0)
+    {}
+
+    /**
+     * @brief Append a sample, samples not newer than the last one on the
+     * monotonic clock are ignored
+     *
+     * @param[in] monotonicMs - monotonic time of the sample
+     * @param[in] wallMs - wall clock time of the sample, used by the queries
+     * @param[in] values - one value per column, NaN if unknown
+     * @return true if the sample was appended
+     */
+    bool append(int64_t monotonicMs, int64_t wallMs,
+                const std::vector<double>& values)
+    {
+        if (values.size() != columns ||
+            (!blocks.empty() && monotonicMs <= blocks.back().lastTime))
+        {
+            return false;
+        }
+        int64_t offset = wallMs - monotonicMs;
+        if (!blocks.empty())
+        {
+            // energy is kept over the whole uptime, not only the retention
+            double seconds = (monotonicMs - blocks.back().lastTime) / 1000.0;
+            for (size_t i = 0; i < columns; i++)
+            {
+                if (std::isfinite(last[i]) && std::isfinite(values[i]))
+                {
+                    energy[i] += (last[i] + values[i]) / 2 * seconds;
+                }
+            }
+        }
+        last = values;
+
+        if (blocks.empty() ||
+            monotonicMs >= blocks.back().firstTime + policy.blockMs ||
+            std::abs(offset - blocks.back().wallOffset) >
+                policy.stepToleranceMs)
+        {
+            if (!blocks.empty())
+            {
+                blocks.back().bits.shrink();
+            }
+            blocks.emplace_back(monotonicMs, offset, columns);
+            while (blocks.front().lastTime < monotonicMs - policy.retentionMs)
+            {
+                blocks.pop_front();
+            }
+        }
+        blocks.back().append(monotonicMs, values);
+        return true;
+    }
+
+    /** @brief Append a sample of a clock which never steps */
+    bool append(int64_t timeMs, const std::vector<double>& values)
+    {
+        return append(timeMs, timeMs, values);
+    }
+
+    /** @brief Samples within [fromMs, toMs] of the wall clock, in the order
+     * they were taken */
+    std::vector<Sample> range(int64_t fromMs, int64_t toMs) const
+    {
+        std::vector<Sample> samples;
+        for (const auto& block : blocks)
+        {
+            if (block.lastWall() < fromMs || block.firstWall() > toMs)
+            {
+                continue;
+            }
+            block.decode([&](int64_t time, const std::vector<double>& values) {
+                if (time >= fromMs && time <= toMs)
+                {
+                    samples.push_back(Sample{time, values});
+                }
+            });
+        }
+        return samples;
+    }
+
+    /**
+     * @brief Min, max and average of a column within [fromMs, toMs] of the
+     * wall clock
+     *
+     * @param[in] column - column index
+     * @param[in] fromMs - start of the first bucket
+     * @param[in] toMs - end of the range
+     * @param[in] bucketMs - span of a bucket, 0 for one bucket per sample
+     * @return the buckets holding at least one sample
+     */
+    std::vector<Bucket> downsample(size_t column, int64_t fromMs, int64_t toMs,
+                                   int64_t bucketMs) const
+    {
+        std::vector<Bucket> buckets;
+        if (column >= columns)
+        {
+            return buckets;
+        }
+        double sum = 0;
+        for (const auto& block : blocks)
+        {
+            if (block.lastWall() < fromMs || block.firstWall() > toMs)
+            {
+                continue;
+            }
+            block.decode([&](int64_t time, const std::vector<double>& values) {
+                double value = values[column];
+                if (time < fromMs || time > toMs || std::isnan(value))
+                {
+                    return;
+                }
+                int64_t start =
+                    bucketMs ? fromMs + (time - fromMs) / bucketMs * bucketMs
+                             : time;
+                if (buckets.empty() || buckets.back().startMs != start)
+                {
+                    buckets.push_back(Bucket{start, value, value, value, 0});
+                    sum = 0;
+                }
+                auto& bucket = buckets.back();
+                bucket.min = std::min(bucket.min, value);
+                bucket.max = std::max(bucket.max, value);
+                bucket.count++;
+                sum += value;
+                bucket.avg = sum / bucket.count;
+            });
+        }
+        return buckets;
+    }
+
+    /** @brief integral of a column over time, in joules for a column in
+     * watts */
+    double integral(size_t column) const
+    {
+        return column < columns ? energy[column] : 0.0;
+    }
+
+    /** @brief memory held by the samples */
+    size_t bytes() const
+    {
+        size_t total = 0;
+        for (const auto& block : blocks)
+        {
+            total += sizeof(Block) + block.bits.capacity() +
+                     block.previous.size() * (sizeof(uint64_t) + 2);
+        }
+        return total;
+    }
+
+    size_t samples() const
+    {
+        size_t total = 0;
+        for (const auto& block : blocks)
+        {
+            total += block.count;
+        }
+        return total;
+    }
+
+  private:
+    struct Column
+    {
+        uint64_t value = 0;
+        uint8_t leading = 0xff;
+        uint8_t trailing = 0;
+    };
+
+    struct Block
+    {
+        Block(int64_t time, int64_t wallOffset, size_t columns) :
+            firstTime(time), lastTime(time), wallOffset(wallOffset),
+            previous(columns)
+        {}
+
+        /** @brief monotonic times of the first and last samples */
+        int64_t firstTime;
+        int64_t lastTime;
+        /** @brief wall clock minus monotonic time of the block */
+        int64_t wallOffset;
+        int64_t lastDelta = 0;
+        uint32_t count = 0;
+        /** @brief encoder state of each column */
+        std::vector<Column> previous;
+        BitWriter bits;
+
+        void append(int64_t time, const std::vector<double>& values)
+        {
+            if (count > 0)
+            {
+                int64_t delta = time - lastTime;
+                writeTime(delta - lastDelta);
+                lastDelta = delta;
+            }
+            lastTime = time;
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                uint64_t value = std::bit_cast<uint64_t>(values[i]);
+                if (count == 0)
+                {
+                    bits.write(value, 64);
+                }
+                else
+                {
+                    writeValue(previous[i], value);
+                }
+                previous[i].value = value;
+            }
+            count++;
+        }
+
+        int64_t firstWall() const
+        {
+            return firstTime + wallOffset;
+        }
+
+        int64_t lastWall() const
+        {
+            return lastTime + wallOffset;
+        }
+
+        /** @brief visit the samples with their wall clock times */
+        template <typename Visitor>
+        void decode(Visitor&& visit) const
+        {
+            BitReader reader(bits);
+            std::vector<Column> state(previous.size());
+            std::vector<double> values(previous.size());
+            int64_t time = firstTime;
+            int64_t delta = 0;
+            for (uint32_t n = 0; n < count; n++)
+            {
+                if (n > 0)
+                {
+                    delta += readTime(reader);
+                    time += delta;
+                }
+                for (size_t i = 0; i < state.size(); i++)
+                {
+                    state[i].value = n == 0 ? reader.read(64)
+                                            : readValue(reader, state[i]);
+                    values[i] = std::bit_cast<double>(state[i].value);
+                }
+                visit(time + wallOffset, values);
+            }
+        }
+
+        void writeTime(int64_t dod)
+        {
+            if (dod == 0)
+            {
+                bits.write(0b0, 1);
+            }
+            else if (dod >= -63 && dod <= 64)
+            {
+                bits.write(0b10, 2);
+                bits.write(static_cast<uint64_t>(dod + 63), 7);
+            }
+            else if (dod >= -255 && dod <= 256)
+            {
+                bits.write(0b110, 3);
+                bits.write(static_cast<uint64_t>(dod + 255), 9);
+            }
+            else if (dod >= -2047 && dod <= 2048)
+            {
+                bits.write(0b1110, 4);
+                bits.write(static_cast<uint64_t>(dod + 2047), 12);
+            }
+            else
+            {
+                bits.write(0b1111, 4);
+                bits.write(static_cast<uint64_t>(dod), 64);
+            }
+        }
+
+        static int64_t readTime(BitReader& reader)
+        {
+            unsigned prefix = 0;
+            while (prefix < 4 && reader.read(1))
+            {
+                prefix++;
+            }
+            switch (prefix)
+            {
+                case 0:
+                    return 0;
+                case 1:
+                    return static_cast<int64_t>(reader.read(7)) - 63;
+                case 2:
+                    return static_cast<int64_t>(reader.read(9)) - 255;
+                case 3:
+                    return static_cast<int64_t>(reader.read(12)) - 2047;
+                default:
+                    return static_cast<int64_t>(reader.read(64));
+            }
+        }
+
+        void writeValue(Column& column, uint64_t value)
+        {
+            uint64_t xored = value ^ column.value;
+            if (xored == 0)
+            {
+                bits.write(0b0, 1);
+                return;
+            }
+            uint8_t leading =
+                std::min<uint8_t>(std::countl_zero(xored), 31);
+            uint8_t trailing = std::countr_zero(xored);
+            if (column.leading != 0xff && leading >= column.leading &&
+                trailing >= column.trailing)
+            {
+                // fits in the meaningful bits of the previous value
+                bits.write(0b10, 2);
+                bits.write(xored >> column.trailing,
+                           64 - column.leading - column.trailing);
+                return;
+            }
+            unsigned meaningful = 64 - leading - trailing;
+            bits.write(0b11, 2);
+            bits.write(leading, 5);
+            // 64 meaningful bits are written as 0
+            bits.write(meaningful & 0x3f, 6);
+            bits.write(xored >> trailing, meaningful);
+            column.leading = leading;
+            column.trailing = trailing;
+        }
+
+        static uint64_t readValue(BitReader& reader, Column& column)
+        {
+            if (!reader.read(1))
+            {
+                return column.value;
+            }
+            if (reader.read(1))
+            {
+                column.leading = reader.read(5);
+                unsigned meaningful = reader.read(6);
+                if (meaningful == 0)
+                {
+                    meaningful = 64;
+                }
+                column.trailing = 64 - column.leading - meaningful;
+            }
+            unsigned meaningful = 64 - column.leading - column.trailing;
+            return column.value ^ (reader.read(meaningful) << column.trailing);
+        }
+    };
+
+    size_t columns;
+    SeriesPolicy policy;
+    std::deque<Block> blocks;
+    /** @brief last sample, used to integrate the columns */
+    std::vector<double> last;
+    std::vector<double> energy;
+};
+
+} // namespace nvidia::power::history
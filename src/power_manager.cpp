@@ -16,6 +16,11 @@
  */
 
 #include "power_manager.hpp"
+
+#include "startup_profiler.hpp"
+
+#include <cmath>
+#include <limits>
 enum class PowerState
 {
     Off,
@@ -32,6 +37,7 @@ static const std::map<std::string, PowerState> mappingChassisPowerState{
      PowerState::TransitioningToOn}};
 using namespace phosphor::logging;
 using namespace nvidia::power::util;
+using nvidia::startup::startupProfiler;
 
 namespace nvidia::power
 {
@@ -194,21 +200,127 @@ int util::dumpPowerCapIntoFile(const char* path, uint8_t* data, int length)
 namespace manager
 {
 
+std::vector<ChassisConfig> getChassisConfigs(const nlohmann::json& config)
+{
+    std::vector<ChassisConfig> chassisConfigs;
+    if (!config.contains("chassis"))
+    {
+        chassisConfigs.push_back({std::string{}, config});
+        return chassisConfigs;
+    }
+    nlohmann::json defaults = config;
+    defaults.erase("chassis");
+    std::set<std::string> names;
+    std::set<std::string> savePaths;
+    for (const auto& jsonData0 : config["chassis"])
+    {
+        ChassisConfig chassis{jsonData0["name"].get<std::string>(), defaults};
+        chassis.config.update(jsonData0);
+        chassis.config.erase("name");
+
+        // the persisted state must not be shared between chassis
+        std::string savePath = chassis.config["powerCappingSavePath"];
+        if (!names.insert(chassis.name).second ||
+            !savePaths.insert(savePath).second)
+        {
+            throw std::invalid_argument(
+                "Chassis " + chassis.name +
+                " is not unique or shares its powerCappingSavePath");
+        }
+        chassisConfigs.push_back(std::move(chassis));
+    }
+    return chassisConfigs;
+}
+
+void SignalRouter::subscribe(const std::string& path,
+                             const std::string& interface,
+                             const std::string& property, Handler handler,
+                             signal::Priority priority)
+{
+    if (!table.add(path, interface, property, std::move(handler), priority))
+    {
+        return;
+    }
+    if (routing)
+    {
+        // a handler subscribed, the callback may be the one of the match to
+        // replace
+        if (staleMatches.empty())
+        {
+            boost::asio::post(io, [this]() {
+                for (const auto& stale : staleMatches)
+                {
+                    updateMatch(stale);
+                }
+                staleMatches.clear();
+            });
+        }
+        staleMatches.insert(interface);
+        return;
+    }
+    updateMatch(interface);
+}
+
+void SignalRouter::updateMatch(const std::string& interface)
+{
+    // the replacement is registered before the old match is dropped so that
+    // no signal is missed, both are never dispatched as this runs on the
+    // event loop
+    matches[interface] = std::make_unique<sdbusplus::bus::match_t>(
+        bus, signal::matchRule(interface, table.groups().at(interface)),
+        [this](auto& msg) { this->route(msg); });
+}
+
+void SignalRouter::route(sdbusplus::message::message& msg)
+{
+    std::string path = msg.get_path();
+    std::string msgInterface;
+    std::map<std::string, Value> msgData;
+    bool decoded = true;
+    try
+    {
+        msg.read(msgInterface, msgData);
+    }
+    catch (const std::exception& e)
+    {
+        // a type we do not know, the subscribers are told the values are lost
+        decoded = false;
+    }
+
+    routing = true;
+    try
+    {
+        if (!decoded)
+        {
+            table.dispatchUnknown(path, msgInterface);
+        }
+        table.dispatch(path, msgInterface, msgData);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << __func__ << e.what() << std::endl;
+    }
+    routing = false;
+}
+
 PowerManager::PowerManager(sdbusplus::bus::bus& bus,
-                           sdbusplus::asio::object_server& objectServer) :
+                           sdbusplus::asio::object_server& objectServer,
+                           boost::asio::io_service& io,
+                           SharedResources& shared,
+                           const ChassisConfig& chassis) :
     bus(bus),
-    objServer(objectServer)
+    JsonConfigData(chassis.config), objServer(objectServer), io(io),
+    shared(shared), chassisName(chassis.name),
+    managerObjPath(chassis.name.empty()
+                       ? std::string(MANAGER_OBJ_PATH)
+                       : std::string(MANAGER_OBJ_PATH) + "/" + chassis.name)
 {
     using namespace sdeventplus;
 
     try
     {
-        JsonConfigData = loadJSONFromFile(POWERMANAGER_JSON_PATH);
-        if (JsonConfigData == nullptr)
-        {
-            log<level::ERR>("InternalFailure when parsing the JSON file");
-            return;
-        }
+        createObjectManagers();
+        auto capFilePhase = startupProfiler().phase("capping-file-load");
         std::string powerCapBinPath = JsonConfigData["powerCappingSavePath"];
         uint8_t* dataInt = loadPowerCapInfoFromFile(powerCapBinPath.c_str());
         if (dataInt)
@@ -231,6 +343,7 @@ PowerManager::PowerManager(sdbusplus::bus::bus& bus,
         {
             updatePowerCappingStructure(false);
         }
+        capFilePhase.stop();
         int totalPowerConsumptionPercentage = 0;
         for (const auto& jsonData0 : JsonConfigData["powerCappingAlgorithm"])
         {
@@ -246,16 +359,11 @@ PowerManager::PowerManager(sdbusplus::bus::bus& bus,
                 "Total Power consumption percentage configured in powermanager.json "
                 "is greater than 100");
         }
-        for (const auto& jsonData0 : JsonConfigData["PowerRedundancyConfigs"])
+        auto registrationPhase =
+            startupProfiler().phase("interface-registration");
         {
-            std::string objName = jsonData0["objectName"];
-            std::string ifaceName = jsonData0["interfaceName"];
-            auto matchEventObj = std::make_unique<sdbusplus::bus::match_t>(
-                bus,
-                sdbusplus::bus::match::rules::propertiesChanged(objName,
-                                                                ifaceName),
-                [this](auto& msg) { this->EventTriggered(msg); });
-            matchEvent.emplace_back(std::move(matchEventObj));
+            auto mapperPhase = startupProfiler().phase("mapper");
+            chassisObjectPath = getSystemChassisObjectPath();
         }
         for (const auto& jsonData0 : JsonConfigData["powerCappingConfigs"])
         {
@@ -263,7 +371,6 @@ PowerManager::PowerManager(sdbusplus::bus::bus& bus,
                 jsonData0["objectName"], jsonData0["interfaceName"]);
             auto Module = jsonData0["module"];
             std::string objectPath = jsonData0["objectName"];
-            chassisObjectPath = getSystemChassisObjectPath();
             for (const auto& jsonData1 : jsonData0["property"])
             {
                 if (jsonData1["propertyName"] == "Associations")
@@ -332,14 +439,60 @@ PowerManager::PowerManager(sdbusplus::bus::bus& bus,
 
             enabledInterface.emplace_back(std::move(interface));
         }
-        std::string objName = JsonConfigData["powerState"]["objectName"];
-        std::string ifaceName = JsonConfigData["powerState"]["interfaceName"];
-        auto matchEventObj = std::make_unique<sdbusplus::bus::match_t>(
-            bus,
-            sdbusplus::bus::match::rules::propertiesChanged(objName, ifaceName),
-            [this](auto& msg) { this->powerStateTriggered(msg); });
-        matchEvent.emplace_back(std::move(matchEventObj));
+        createModuleCapTargets();
+        createEmergencyCapTable();
+        // the emergency events are urgent so that the PSU loss is clamped
+        // before the redundancy action blocks of any chassis run, some of
+        // them wait on condition blocks for seconds
+        for (const auto& jsonData0 : JsonConfigData["PowerRedundancyConfigs"])
+        {
+            shared.router.subscribe(
+                jsonData0["objectName"].get<std::string>(),
+                jsonData0["interfaceName"].get<std::string>(),
+                jsonData0["propertyName"].get<std::string>(),
+                [this, &jsonData0](const std::string&, const std::string&,
+                                   const Value* value) {
+                this->EventTriggered(jsonData0, value);
+            });
+        }
+        createPowerSharing();
+        createCapRamping();
+        createPowerHistory();
+        createRestOfSystemEstimation();
+        createAllocationPreview();
+        createCapReconciliation();
+        createActionInterface();
+        createCapBroker();
+        createSelAggregation();
+        createPowerOnStaging();
+        registrationPhase.stop();
+
+        std::string snapshotPath = snapshot::defaultSnapshotPath;
+        if (!chassisName.empty())
+        {
+            snapshotPath = std::filesystem::path(snapshotPath)
+                               .replace_filename("powerCap_" + chassisName +
+                                                 ".snapshot")
+                               .string();
+        }
+        snapshotPath =
+            JsonConfigData.value("powerCappingSnapshotPath", snapshotPath);
+        snapshotWriter =
+            std::make_unique<snapshot::SnapshotWriter>(snapshotPath);
+        if (!snapshotWriter->valid())
+        {
+            std::cerr << "Unable to create power capping snapshot "
+                      << snapshotPath << std::endl;
+        }
+        shared.router.subscribe(
+            JsonConfigData["powerState"]["objectName"].get<std::string>(),
+            JsonConfigData["powerState"]["interfaceName"].get<std::string>(),
+            JsonConfigData["powerState"]["propertyName"].get<std::string>(),
+            [this](const std::string&, const std::string&, const Value* value) {
+            this->powerStateTriggered(value);
+        });
         // get the initial power status on boot up
+        auto powerStatePhase = startupProfiler().phase("initial-power-state");
         std::string value;
         const std::string Path = JsonConfigData["powerState"]["objectName"];
         const std::string AddInterface =
@@ -369,7 +522,47 @@ PowerManager::PowerManager(sdbusplus::bus::bus& bus,
     }
 }
 
+void PowerManager::createObjectManagers()
+{
+    std::vector<std::string> roots{POWER_CONTROL_PATH};
+    for (const auto& jsonData0 : JsonConfigData["powerCappingConfigs"])
+    {
+        std::string objectPath = jsonData0["objectName"];
+        bool managed = std::any_of(
+            roots.begin(), roots.end(), [&objectPath](const auto& root) {
+            return objectPath.starts_with(root + "/");
+        });
+        if (!managed)
+        {
+            roots.emplace_back(
+                std::filesystem::path(objectPath).parent_path().string());
+        }
+    }
+    for (const auto& root : roots)
+    {
+        if (!shared.objManagers.contains(root))
+        {
+            shared.objManagers.emplace(
+                root, std::make_unique<sdbusplus::server::manager::manager>(
+                          bus, root.c_str()));
+        }
+    }
+}
+
 std::string PowerManager::getSystemChassisObjectPath()
+{
+    if (JsonConfigData.contains("chassisObjectPath"))
+    {
+        return JsonConfigData["chassisObjectPath"];
+    }
+    if (!shared.systemChassisPath)
+    {
+        shared.systemChassisPath = findSystemChassisObjectPath(bus);
+    }
+    return *shared.systemChassisPath;
+}
+
+std::string PowerManager::findSystemChassisObjectPath(sdbusplus::bus::bus& bus)
 {
     const std::vector<std::string> interface = {
         "xyz.openbmc_project.Inventory.Item.Chassis"};
@@ -420,49 +613,54 @@ void PowerManager::triggerSystemPowerCapSignal()
         }
     }
 }
+uint32_t PowerManager::modeLimit(uint8_t mode, uint32_t oemLimit)
+{
+    switch (mode)
+    {
+        case property::Static:
+            return curentPowerLimit;
+        case property::PowerSaving:
+            return powerCappingInfo.chassisPowerLimit_Q;
+        case property::MaximumPerformance:
+            return powerCappingInfo.chassisPowerLimit_P;
+        case property::OEM:
+            return oemLimit;
+        default:
+            std::cerr << "Invalid mode to calulate GPU Power limit"
+                      << std::endl;
+            return curentPowerLimit;
+    }
+}
+
+void PowerManager::fillModuleShares(std::vector<allocation::ModuleShare>& shares)
+{
+    shares.clear();
+    for (const auto& target : moduleCapTargets)
+    {
+        shares.push_back(allocation::ModuleShare{
+            target.percentage, target.numOfDevices,
+            target.minPropObj ? target.minPropObj->getValue() : 0,
+            target.maxPropObj ? target.maxPropObj->getValue()
+                              : std::numeric_limits<uint32_t>::max()});
+    }
+}
+
 void PowerManager::updatePowerCappingLimit(bool emitsChange)
 {
     try
     {
-        switch (powerCappingInfo.mode)
-        {
-            case property::Static:
-                break;
-            case property::PowerSaving:
-                curentPowerLimit = powerCappingInfo.chassisPowerLimit_Q;
-                break;
-            case property::MaximumPerformance:
-                curentPowerLimit = powerCappingInfo.chassisPowerLimit_P;
-                break;
-            case property::OEM:
-                curentPowerLimit = powerCappingInfo.currentPowerLimit;
-                break;
-            default:
-                std::cerr << "Invalid mode to calulate GPU Power limit"
-                          << std::endl;
-                break;
-        }
+        curentPowerLimit = modeLimit(powerCappingInfo.mode,
+                                     powerCappingInfo.currentPowerLimit);
         updatePowerModePropertyValue(powerCappingInfo.mode);
-        for (const auto& jsonData0 : JsonConfigData["powerCappingAlgorithm"])
+        enforcedPowerLimit = brokerLimit(curentPowerLimit);
+        allocateOperatorCaps();
+        for (auto& target : moduleCapTargets)
         {
-            std::string module = jsonData0["powerModule"];
-            int percentage = jsonData0["powerCapPercentage"];
-            int numberOfdevices = jsonData0["numOfDevices"];
-            uint32_t modulePowerLimit =
-                (curentPowerLimit * (static_cast<float>(percentage) / 100)) /
-                numberOfdevices;
-            // std::vector<std::unique_ptr<property::Property>>::iterator
-            // propObj ;
-            for (const auto& propObj : PowerManager::propertyObjs)
-            {
-                if (propObj->getPowerModuleName() == module &&
-                    propObj->getPropertyName() == "PowerCap")
-                {
-                    propObj->updateValue(modulePowerLimit, emitsChange);
-                    break;
-                }
-            }
+            // the chassis limit changed, restart the sharing from the even
+            // split
+            target.sharedCap = target.operatorCap;
         }
+        applyModuleCaps(emitsChange);
     }
     catch (const std::exception& e)
     {
@@ -470,16 +668,43 @@ void PowerManager::updatePowerCappingLimit(bool emitsChange)
     }
 }
 
-uint8_t PowerManager::caluclateChecksum(uint8_t* data, size_t length)
+void PowerManager::allocateOperatorCaps()
+{
+    fillModuleShares(allocationShares);
+    allocation::allocate(enforcedPowerLimit,
+                         powerCappingInfo.chassisPowerLimit_Min,
+                         powerCappingInfo.chassisPowerLimit_Max,
+                         allocationShares, allocationCaps,
+                         allocationViolations, appliedRestOfSystemPower);
+    for (size_t i = 0; i < moduleCapTargets.size(); i++)
+    {
+        moduleCapTargets[i].operatorCap = allocationCaps[i];
+    }
+}
+
+void PowerManager::updateRestOfSystemPower()
 {
     try
     {
-        uint8_t checksum = 0;
-        for (int i = 0; i < static_cast<int>(length); i++)
+        allocateOperatorCaps();
+        uint64_t budget = 0;
+        uint64_t shared = 0;
+        for (const auto& target : moduleCapTargets)
         {
-            checksum += data[i];
+            budget += uint64_t{target.operatorCap} * target.numOfDevices;
+            shared += uint64_t{target.sharedCap} * target.numOfDevices;
         }
-        return ((~checksum) + 1);
+        if (shared > budget)
+        {
+            // the sharing budget shrank, the caps above the even split give
+            // way at once, the next control period rebalances from there
+            for (auto& target : moduleCapTargets)
+            {
+                target.sharedCap = std::min(target.sharedCap,
+                                            target.operatorCap);
+            }
+        }
+        applyModuleCaps(true);
     }
     catch (const std::exception& e)
     {
@@ -487,135 +712,1138 @@ uint8_t PowerManager::caluclateChecksum(uint8_t* data, size_t length)
     }
 }
 
-bool PowerManager::checkChecksum(uint8_t* data, size_t length)
+std::tuple<uint32_t, std::vector<uint32_t>, std::vector<std::string>>
+    PowerManager::previewAllocation(
+        const std::string& mode, uint32_t oemLimit,
+        const std::map<std::string, int32_t>& percentages)
 {
-    try
+    uint8_t previewMode = powerCappingInfo.mode;
+    if (!mode.empty())
     {
-        uint8_t checksum = 0;
-        for (int i = 0; i < static_cast<int>(length); i++)
+        auto parsed = property::Property::convertStringToPowerMode(mode);
+        if (parsed == property::Invalid)
         {
-            checksum += data[i];
+            throw sdbusplus::xyz::openbmc_project::Common::Error::
+                InvalidArgument();
         }
-        return (checksum) ? false : true;
+        previewMode = parsed;
     }
-    catch (const std::exception& e)
+    uint32_t chassisLimit = brokerLimit(modeLimit(
+        previewMode, oemLimit ? oemLimit : powerCappingInfo.currentPowerLimit));
+
+    fillModuleShares(allocationShares);
+    int total = 0;
+    for (size_t i = 0; i < moduleCapTargets.size(); i++)
     {
-        std::cerr << __func__ << e.what() << std::endl;
+        auto percentage = percentages.find(moduleCapTargets[i].module);
+        if (percentage != percentages.end())
+        {
+            if (percentage->second < 0 || percentage->second > 100)
+            {
+                throw sdbusplus::xyz::openbmc_project::Common::Error::
+                    InvalidArgument();
+            }
+            allocationShares[i].percentage = percentage->second;
+        }
+        total += allocationShares[i].percentage;
+    }
+    for (const auto& [module, percentage] : percentages)
+    {
+        if (std::none_of(moduleCapTargets.begin(), moduleCapTargets.end(),
+                         [&module](const auto& target) {
+            return target.module == module;
+        }))
+        {
+            throw sdbusplus::xyz::openbmc_project::Common::Error::
+                InvalidArgument();
+        }
     }
+
+    // same algorithm and rest of system power as updatePowerCappingLimit,
+    // without applying anything
+    allocation::allocate(chassisLimit, powerCappingInfo.chassisPowerLimit_Min,
+                         powerCappingInfo.chassisPowerLimit_Max,
+                         allocationShares, allocationCaps,
+                         allocationViolations, appliedRestOfSystemPower);
+
+    std::vector<std::string> violations;
+    if (total > 100)
+    {
+        violations.push_back(
+            fmt::format("Total percentage {} above 100", total));
+    }
+    for (const auto& violation : allocationViolations)
+    {
+        violations.push_back(fmt::format(
+            "{} {}W outside {}-{}W",
+            violation.module < 0 ? std::string("Chassis")
+                                 : moduleCapTargets[violation.module].module,
+            violation.value, violation.min, violation.max));
+    }
+    return {chassisLimit, allocationCaps, violations};
 }
 
-void PowerManager::updatePowerCappingStructure(bool fileExist)
+void PowerManager::createAllocationPreview()
 {
-    try
+    std::vector<std::string> modules;
+    for (const auto& target : moduleCapTargets)
     {
-        for (const auto& jsonData0 : JsonConfigData["powerCappingConfigs"])
+        modules.push_back(target.module);
+    }
+    previewInterface = objServer.add_interface(
+        managerObjPath, "com.Nvidia.Powermanager.AllocationPreview");
+    previewInterface->register_property(
+        "Modules", modules, sdbusplus::asio::PropertyPermission::readOnly);
+    previewInterface->register_method(
+        "Preview", [this](const std::string& mode, uint32_t oemLimit,
+                          const std::map<std::string, int32_t>& percentages) {
+        return previewAllocation(mode, oemLimit, percentages);
+    });
+    previewInterface->initialize();
+}
+
+void PowerManager::createModuleCapTargets()
+{
+    for (const auto& jsonData0 : JsonConfigData["powerCappingAlgorithm"])
+    {
+        ModuleCapTarget target{};
+        target.module = jsonData0["powerModule"].get<std::string>();
+        target.percentage = jsonData0["powerCapPercentage"].get<int>();
+        target.numOfDevices = jsonData0["numOfDevices"].get<int>();
+        target.propObj = nullptr;
+        for (const auto& propObj : PowerManager::propertyObjs)
         {
-            for (const auto& jsonData1 : jsonData0["property"])
+            if (target.propObj == nullptr &&
+                propObj->getPowerModuleName() == target.module &&
+                propObj->getPropertyName() == "PowerCap")
             {
-                std::string propertyname = jsonData1["propertyName"];
-
-                std::string path(jsonData0["objectName"]);
-
-                //  get the index of the module or chassis
-                std::size_t found = path.find_last_of("/");
-                int index = -1;
-                std::string file;
-                // the object path starts with ProcessorModule_{instance_id}
-                // so we can get the module index where index is 0 based.
-                if (found != std::string::npos)
-                {
-                    file = path.substr(found + 1);
-                    found = file.find_first_of("_");
-                }
-                if (found != std::string::npos)
-                {
-                    std::string num = file.substr(found + 1, 1);
-                    index = std::stoi(num);
-                }
-
-                if (propertyname == "PowerCap" && index >= 0)
-                {
-                    powerCappingInfo.modulePowerLimit[index] =
-                        jsonData1["value"];
-                }
-                else if (propertyname == "PowerCap")
-                {
-                    powerCappingInfo.currentPowerLimit = jsonData1["value"];
-                }
-                else if (propertyname == "PowerCapPercentage" && index >= 0)
-                {
-                    powerCappingInfo.modulePowerLimitPercentage[index] =
-                        jsonData1["value"];
-                }
-                else if (propertyname == "MinPowerCapValue" && index >= 0)
-                {
-                    powerCappingInfo.modulePowerLimit_Min[index] =
-                        jsonData1["value"];
-                }
-                else if (propertyname == "MinPowerCapValue")
-                {
-                    powerCappingInfo.chassisPowerLimit_Min = jsonData1["value"];
-                }
-                else if (propertyname == "PowerMode")
-                {
-                    powerCappingInfo.mode =
-                        jsonData1["value"].get<property::PowerMode>();
-                }
-                else if (propertyname == "MaxPowerCapValue" &&
-                         file == "CurrentChassisLimit")
-                {
-                    powerCappingInfo.chassisPowerLimit_Max = jsonData1["value"];
-                }
-                else if (propertyname == "MaxPowerCapValue" && index >= 0 &&
-                         file.find(MODULE_OBJ_PATH_PREFIX) != std::string::npos)
-                {
-                    powerCappingInfo.modulePowerLimit_Max[index] =
-                        jsonData1["value"];
-                }
-                else if (propertyname == "MaxPowerCapValue" &&
-                         file == "ChassisLimitQ")
-                {
-                    powerCappingInfo.chassisPowerLimit_Q = jsonData1["value"];
-                }
-                else if (propertyname == "MaxPowerCapValue" &&
-                         file == "ChassisLimitP")
-                {
-                    powerCappingInfo.chassisPowerLimit_P = jsonData1["value"];
-                }
-                else if (propertyname == "Value")
-                {
-                    powerCappingInfo.restOfSystemPower = jsonData1["value"];
-                }
+                target.propObj = propObj.get();
+                // keep the restored cap until the capping limit is updated
+                target.operatorCap = propObj->getValue();
+                target.sharedCap = target.operatorCap;
+            }
+            else if (propObj->getPowerModuleName() == target.module &&
+                     propObj->getPropertyName() == "MinPowerCapValue")
+            {
+                target.minPropObj = propObj.get();
+            }
+            else if (propObj->getPowerModuleName() == target.module &&
+                     propObj->getPropertyName() == "MaxPowerCapValue")
+            {
+                target.maxPropObj = propObj.get();
             }
         }
-        std::string powerCapBinPath = JsonConfigData["powerCappingSavePath"];
-        size_t size = fileExist ? getPowerCapFileLength(powerCapBinPath.c_str())
-                                : sizeof(struct PowerCappingInfo);
-        powerCappingInfo.checksum = 0;
-        powerCappingInfo.checksum = caluclateChecksum(
-            reinterpret_cast<uint8_t*>(&powerCappingInfo), size);
-
-        util::dumpPowerCapIntoFile(
-            powerCapBinPath.c_str(),
-            reinterpret_cast<uint8_t*>(&powerCappingInfo), size);
-    }
-    catch (const std::exception& e)
-    {
-        std::cerr << __func__ << e.what() << std::endl;
+        moduleCapTargets.emplace_back(std::move(target));
     }
 }
 
-void PowerManager::getDataForAppend(nlohmann::json dataJson,
-                                    sdbusplus::message::message& methodObj)
+void PowerManager::createEmergencyCapTable()
 {
-    try
+    if (!JsonConfigData.contains("emergencyCapping"))
     {
-        std::string parameter = dataJson["dataType"];
-        switch (parameter.at(0))
+        return;
+    }
+    for (const auto& jsonData0 : JsonConfigData["emergencyCapping"]["events"])
+    {
+        std::string objName = jsonData0["objectName"];
+        std::string ifaceName = jsonData0.value(
+            "interfaceName", "xyz.openbmc_project.Object.Enable");
+        EmergencyEvent event{jsonData0.value("propertyName", "Enabled"),
+                             jsonData0["healthyPsus"].get<uint32_t>()};
+
+        if (emergencyCapTable.contains(event.healthyPsus) ||
+            emergencyEvents.contains(objName))
         {
-            case DBUSTYPE_SIGNED_INT16:
-                if (dataJson["data"].type() == json::value_t::array)
-                {
+            throw std::invalid_argument(
+                "Emergency capping event " + objName +
+                " is not unique or duplicates the entry for " +
+                std::to_string(event.healthyPsus) + " healthy PSUs");
+        }
+
+        EmergencyCapEntry entry{};
+        entry.healthyPsus = event.healthyPsus;
+        entry.chassisPowerLimit =
+            jsonData0["chassisPowerLimit"].get<uint32_t>();
+        emergencyCapTable[entry.healthyPsus] = std::move(entry);
+
+        shared.router.subscribe(
+            objName, ifaceName, event.propertyName,
+            [this](const std::string& path, const std::string&,
+                   const Value* value) {
+            auto received = std::chrono::steady_clock::now();
+            auto asserted = value ? std::get_if<bool>(value) : nullptr;
+            if (asserted)
+            {
+                handleEmergencyEvent(path, *asserted, received);
+            }
+        }, signal::Priority::Urgent);
+        emergencyEvents[objName] = std::move(event);
+    }
+
+    updateEmergencyCaps();
+
+    emergencyInterface = objServer.add_interface(
+        managerObjPath, "com.Nvidia.Powermanager.EmergencyCapping");
+    emergencyInterface->register_property(
+        "Active", false, sdbusplus::asio::PropertyPermission::readOnly);
+    emergencyInterface->register_property(
+        "HealthyPsus", static_cast<uint32_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    emergencyInterface->register_property(
+        "ClampCount", clampCount,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    emergencyInterface->register_property(
+        "LastClampLatencyUsec", static_cast<uint64_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    emergencyInterface->register_property(
+        "MaxClampLatencyUsec", maxClampLatencyUsec,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    emergencyInterface->initialize();
+
+    readEmergencyEvents();
+}
+
+void PowerManager::readEmergencyEvents()
+{
+    // an event asserted before the daemon started sends no signal
+    for (const auto& jsonData0 : JsonConfigData["emergencyCapping"]["events"])
+    {
+        std::string objName = jsonData0["objectName"];
+        std::string ifaceName = jsonData0.value(
+            "interfaceName", "xyz.openbmc_project.Object.Enable");
+        try
+        {
+            auto service = util::getService(objName, ifaceName, bus, false);
+            if (service.empty())
+            {
+                continue;
+            }
+            bool asserted = false;
+            util::getProperty<bool>(ifaceName,
+                                    emergencyEvents.at(objName).propertyName,
+                                    objName, service, bus, asserted);
+            if (asserted)
+            {
+                handleEmergencyEvent(objName, true,
+                                     std::chrono::steady_clock::now());
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << __func__ << e.what() << std::endl;
+        }
+    }
+}
+
+void PowerManager::updateEmergencyCaps()
+{
+    // same split as the operator caps, with the rest of system estimate the
+    // modules only get what the rest of the system leaves of the emergency
+    // limit, the caps of an entry keep their storage
+    fillModuleShares(allocationShares);
+    for (auto& [healthyPsus, entry] : emergencyCapTable)
+    {
+        allocation::allocate(entry.chassisPowerLimit,
+                             powerCappingInfo.chassisPowerLimit_Min,
+                             powerCappingInfo.chassisPowerLimit_Max,
+                             allocationShares, entry.moduleCaps,
+                             allocationViolations, appliedRestOfSystemPower);
+    }
+}
+
+void PowerManager::applyModuleCaps(bool emitsChange)
+{
+    std::vector<uint32_t> caps;
+    for (size_t i = 0; i < moduleCapTargets.size(); i++)
+    {
+        const auto& target = moduleCapTargets[i];
+        uint32_t cap = sharingPeriod.count() ? target.sharedCap
+                                             : target.operatorCap;
+        if (activeEmergencyCap != nullptr)
+        {
+            cap = std::min(cap, activeEmergencyCap->moduleCaps[i]);
+        }
+        caps.push_back(cap);
+    }
+    if (capRamp)
+    {
+        caps = rampModuleCaps(caps);
+    }
+
+    // lower caps first so that the chassis limit also holds while the caps
+    // are being moved between modules
+    for (bool raise : {false, true})
+    {
+        for (size_t i = 0; i < moduleCapTargets.size(); i++)
+        {
+            const auto& target = moduleCapTargets[i];
+            if (target.propObj == nullptr)
+            {
+                continue;
+            }
+            if ((caps[i] > target.propObj->getValue()) == raise)
+            {
+                target.propObj->updateValue(caps[i], emitsChange);
+            }
+        }
+    }
+    publishSnapshot();
+}
+
+std::vector<uint32_t>
+    PowerManager::rampModuleCaps(const std::vector<uint32_t>& targets)
+{
+    auto now = ramp::Clock::now();
+    if (activeEmergencyCap != nullptr)
+    {
+        // the emergency clamp bypasses the ramp, the caps drop at once and
+        // the ramp resumes from there when the redundancy is recovered
+        auto caps = capRamp->caps(now);
+        bool clamped = false;
+        for (size_t i = 0; i < caps.size(); i++)
+        {
+            if (caps[i] > activeEmergencyCap->moduleCaps[i])
+            {
+                caps[i] = activeEmergencyCap->moduleCaps[i];
+                clamped = true;
+            }
+        }
+        if (clamped)
+        {
+            capRamp->restart(caps, now);
+        }
+    }
+    if (capRamp->retarget(targets, now))
+    {
+        rampInterface->set_property("ModuleTargets", targets);
+    }
+
+    bool ramping = capRamp->ramping(now);
+    uint64_t eta = ramping
+                       ? std::chrono::duration_cast<std::chrono::microseconds>(
+                             capRamp->eta() - now)
+                             .count()
+                       : 0;
+    rampInterface->set_property("Ramping", ramping);
+    rampInterface->set_property("EtaUsec", eta);
+    if (ramping && !rampTimerArmed)
+    {
+        rampTimerArmed = true;
+        rampTimer->expires_after(rampStep);
+        rampTimer->async_wait([this](const boost::system::error_code& ec) {
+            rampTimerArmed = false;
+            if (ec == boost::asio::error::operation_aborted)
+            {
+                return;
+            }
+            applyModuleCaps(true);
+        });
+    }
+    return capRamp->caps(now);
+}
+
+void PowerManager::createCapRamping()
+{
+    if (!JsonConfigData.contains("capRamping") ||
+        !JsonConfigData["capRamping"].value("enabled", false))
+    {
+        return;
+    }
+    const auto& rampJson = JsonConfigData["capRamping"];
+    ramp::RampPolicy policy{};
+    policy.upWattsPerSecond = rampJson.value("upWattsPerSecond", 0U);
+    policy.downWattsPerSecond = rampJson.value("downWattsPerSecond", 0U);
+    rampStep = std::chrono::milliseconds(rampJson.value("stepMs", 100U));
+
+    std::vector<uint32_t> devices;
+    std::vector<uint32_t> caps;
+    for (const auto& target : moduleCapTargets)
+    {
+        devices.push_back(target.numOfDevices);
+        caps.push_back(target.propObj ? target.propObj->getValue()
+                                      : target.operatorCap);
+    }
+    capRamp.emplace(policy, std::move(devices));
+    capRamp->restart(caps, ramp::Clock::now());
+
+    rampInterface = objServer.add_interface(
+        managerObjPath, "com.Nvidia.Powermanager.CapRamp");
+    rampInterface->register_property(
+        "UpWattsPerSecond", policy.upWattsPerSecond,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    rampInterface->register_property(
+        "DownWattsPerSecond", policy.downWattsPerSecond,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    rampInterface->register_property(
+        "Ramping", false, sdbusplus::asio::PropertyPermission::readOnly);
+    rampInterface->register_property(
+        "ModuleTargets", caps, sdbusplus::asio::PropertyPermission::readOnly);
+    rampInterface->register_property(
+        "EtaUsec", static_cast<uint64_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    rampInterface->initialize();
+
+    rampTimer = std::make_unique<boost::asio::steady_timer>(io);
+}
+
+void PowerManager::createPowerSharing()
+{
+    if (!JsonConfigData.contains("dynamicPowerSharing"))
+    {
+        return;
+    }
+    const auto& sharingJson = JsonConfigData["dynamicPowerSharing"];
+    if (!sharingJson.value("enabled", false))
+    {
+        return;
+    }
+    sharingPolicy.headroom = sharingJson.value("headroomWatts", 20U);
+    sharingPolicy.maxStep = sharingJson.value("maxStepWatts", 0U);
+    for (const auto& jsonData0 : sharingJson["modules"])
+    {
+        std::string module = jsonData0["powerModule"];
+        auto target = std::find_if(
+            moduleCapTargets.begin(), moduleCapTargets.end(),
+            [&module](const auto& target) { return target.module == module; });
+        if (target == moduleCapTargets.end())
+        {
+            std::cerr << "Power sharing module " << module
+                      << " not found in powerCappingAlgorithm" << std::endl;
+            continue;
+        }
+        target->powerSensorPath = jsonData0["powerSensorPath"];
+        target->shareFloor = jsonData0["floorWatts"].get<uint32_t>();
+        target->shareCeiling = jsonData0["ceilingWatts"].get<uint32_t>();
+    }
+    sharingPeriod =
+        std::chrono::milliseconds(sharingJson.value("periodMs", 1000U));
+
+    sharingInterface = objServer.add_interface(
+        managerObjPath, "com.Nvidia.Powermanager.PowerSharing");
+    sharingInterface->register_property(
+        "Enabled", true, sdbusplus::asio::PropertyPermission::readOnly);
+    sharingInterface->register_property(
+        "PeriodMs", static_cast<uint64_t>(sharingPeriod.count()),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    sharingInterface->register_property(
+        "RebalanceCount", rebalanceCount,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    sharingInterface->register_property(
+        "SensorReadErrorCount", sensorReadErrors,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    sharingInterface->initialize();
+
+    sharingTimer = std::make_unique<boost::asio::steady_timer>(io);
+    startSharingTimer();
+}
+
+void PowerManager::startSharingTimer()
+{
+    sharingTimer->expires_after(sharingPeriod);
+    sharingTimer->async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        std::vector<std::string> paths;
+        for (const auto& target : moduleCapTargets)
+        {
+            paths.push_back(target.powerSensorPath);
+        }
+        // the next period starts once the sensors answered, a slow sensor
+        // delays the sharing instead of piling up reads
+        readSensors(paths, [this](const std::vector<double>& values) {
+            sharePower(values);
+            startSharingTimer();
+        });
+    });
+}
+
+void PowerManager::readSensors(
+    const std::vector<std::string>& paths,
+    std::function<void(const std::vector<double>&)> done)
+{
+    struct Batch
+    {
+        std::vector<double> values;
+        size_t pending;
+        std::function<void(const std::vector<double>&)> done;
+    };
+    auto batch = std::make_shared<Batch>(
+        Batch{std::vector<double>(paths.size(), NAN), paths.size() + 1,
+              std::move(done)});
+    auto finish = [batch](size_t index, double value) {
+        if (index < batch->values.size())
+        {
+            batch->values[index] = value;
+        }
+        if (--batch->pending == 0)
+        {
+            batch->done(batch->values);
+        }
+    };
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (paths[i].empty())
+        {
+            finish(i, NAN);
+            continue;
+        }
+        readSensor(paths[i], [finish, i](double value) { finish(i, value); });
+    }
+    // all reads are issued, the batch completes with the last answer
+    finish(paths.size(), NAN);
+}
+
+void PowerManager::readSensor(const std::string& path,
+                              std::function<void(double)> done)
+{
+    constexpr auto sensorValueIface = "xyz.openbmc_project.Sensor.Value";
+    auto service = sensorServices.find(path);
+    if (service == sensorServices.end() || service->second.empty())
+    {
+        shared.conn->async_method_call(
+            [this, path, done](
+                const boost::system::error_code& ec,
+                const std::map<std::string, std::vector<std::string>>&
+                    objects) {
+            if (ec || objects.empty())
+            {
+                sensorReadFailed(path, ec ? ec.message() : "no service");
+                done(NAN);
+                return;
+            }
+            sensorServices[path] = objects.begin()->first;
+            readSensor(path, done);
+        },
+            MAPPER_BUSNAME, MAPPER_PATH, MAPPER_INTERFACE, "GetObject", path,
+            std::vector<std::string>{sensorValueIface});
+        return;
+    }
+    shared.conn->async_method_call(
+        [this, path, done](const boost::system::error_code& ec,
+                           const std::map<std::string, Value>& properties) {
+        auto value = properties.find("Value");
+        if (ec || value == properties.end())
+        {
+            // the service may have restarted, look it up again next time
+            sensorServices.erase(path);
+            sensorReadFailed(path, ec ? ec.message() : "no Value");
+            done(NAN);
+            return;
+        }
+        if (failingSensors.erase(path))
+        {
+            std::cerr << "readSensor " << path << " readable again"
+                      << std::endl;
+        }
+        auto reading = std::get_if<double>(&value->second);
+        done(reading && std::isfinite(*reading) && *reading >= 0 ? *reading
+                                                                  : NAN);
+    },
+        service->second, path, util::PROPERTY_INTF, "GetAll",
+        sensorValueIface);
+}
+
+void PowerManager::sensorReadFailed(const std::string& path,
+                                    const std::string& reason)
+{
+    // logged when the sensor starts failing only, a missing sensor would
+    // otherwise log every period
+    if (failingSensors.insert(path).second)
+    {
+        std::cerr << "readSensor " << path << ": " << reason << std::endl;
+    }
+    sensorReadErrors++;
+    if (sharingInterface)
+    {
+        sharingInterface->set_property("SensorReadErrorCount",
+                                       sensorReadErrors);
+    }
+}
+
+void PowerManager::sharePower(const std::vector<double>& modulePower)
+{
+    std::vector<sharing::ModuleShare> modules;
+    std::vector<uint32_t> power;
+    uint64_t budget = 0;
+    for (size_t i = 0; i < moduleCapTargets.size(); i++)
+    {
+        const auto& target = moduleCapTargets[i];
+        sharing::ModuleShare module{};
+        module.devices = target.numOfDevices;
+        module.cap = target.sharedCap;
+        budget += uint64_t{target.operatorCap} * target.numOfDevices;
+
+        if (target.powerSensorPath.empty())
+        {
+            // not shared, pinned to the even split
+            module.floor = target.operatorCap;
+            module.ceiling = target.operatorCap;
+        }
+        else if (std::isfinite(modulePower[i]))
+        {
+            module.floor = target.shareFloor;
+            module.ceiling = target.shareCeiling;
+        }
+        else
+        {
+            // without telemetry the caps are left as they are
+            return;
+        }
+        modules.push_back(module);
+        // the sensor reports the power of all devices of the module
+        power.push_back(
+            std::isfinite(modulePower[i])
+                ? static_cast<uint32_t>(modulePower[i] / target.numOfDevices)
+                : 0);
+    }
+
+    if (!sharing::rebalance(modules, power, budget, sharingPolicy))
+    {
+        return;
+    }
+    for (size_t i = 0; i < moduleCapTargets.size(); i++)
+    {
+        moduleCapTargets[i].sharedCap = modules[i].cap;
+    }
+    applyModuleCaps(true);
+    sharingInterface->set_property("RebalanceCount", ++rebalanceCount);
+}
+
+void PowerManager::publishSnapshot()
+{
+    if (!snapshotWriter)
+    {
+        return;
+    }
+    snapshot::PowerCapState state{};
+    state.mode = powerCappingInfo.mode;
+    state.currentPowerLimit = powerCappingInfo.currentPowerLimit;
+    state.chassisPowerLimit_P = powerCappingInfo.chassisPowerLimit_P;
+    state.chassisPowerLimit_Q = powerCappingInfo.chassisPowerLimit_Q;
+    state.chassisPowerLimit_Min = powerCappingInfo.chassisPowerLimit_Min;
+    state.chassisPowerLimit_Max = powerCappingInfo.chassisPowerLimit_Max;
+    state.restOfSystemPower = powerCappingInfo.restOfSystemPower;
+    state.moduleCount = std::min<size_t>(MODULE_NUM, snapshot::maxModules);
+    for (size_t i = 0; i < state.moduleCount; i++)
+    {
+        state.modulePowerLimit[i] = powerCappingInfo.modulePowerLimit[i];
+        state.modulePowerLimit_Min[i] =
+            powerCappingInfo.modulePowerLimit_Min[i];
+        state.modulePowerLimit_Max[i] =
+            powerCappingInfo.modulePowerLimit_Max[i];
+        state.modulePowerLimitPercentage[i] =
+            powerCappingInfo.modulePowerLimitPercentage[i];
+    }
+    for (const auto& target : moduleCapTargets)
+    {
+        if (target.propObj == nullptr ||
+            state.allocationCount == snapshot::maxAllocations)
+        {
+            continue;
+        }
+        auto& allocation = state.allocations[state.allocationCount++];
+        std::strncpy(allocation.module, target.module.c_str(),
+                     snapshot::moduleNameSize - 1);
+        allocation.powerCap = target.propObj->getValue();
+    }
+    snapshotWriter->write(state);
+}
+
+std::string PowerManager::modulePowerSensor(const nlohmann::json& config,
+                                            const ModuleCapTarget& target)
+{
+    for (const auto& jsonData0 :
+         config.value("modules", nlohmann::json::array()))
+    {
+        if (jsonData0["powerModule"] == target.module)
+        {
+            return jsonData0["powerSensorPath"].get<std::string>();
+        }
+    }
+    // the dynamicPowerSharing sensor is used unless one is configured
+    return target.powerSensorPath;
+}
+
+void PowerManager::createRestOfSystemEstimation()
+{
+    if (!JsonConfigData.contains("restOfSystemEstimation") ||
+        !JsonConfigData["restOfSystemEstimation"].value("enabled", false))
+    {
+        return;
+    }
+    const auto& restJson = JsonConfigData["restOfSystemEstimation"];
+    restChassisSensorPath =
+        restJson["chassisPowerSensorPath"].get<std::string>();
+    for (const auto& target : moduleCapTargets)
+    {
+        auto path = modulePowerSensor(restJson, target);
+        if (path.empty())
+        {
+            // its power would be counted in the rest of the system
+            std::cerr << "Rest of system estimation needs the power sensor of "
+                      << target.module << std::endl;
+            return;
+        }
+        restModuleSensorPaths.push_back(path);
+    }
+
+    rest::EstimatorPolicy policy{};
+    policy.riseTimeConstant = restJson.value("riseTimeConstantMs", 1000U) /
+                              1000.0;
+    policy.fallTimeConstant = restJson.value("fallTimeConstantMs", 30000U) /
+                              1000.0;
+    policy.marginWatts = restJson.value("marginWatts", 150U);
+    policy.minWatts = restJson.value("minWatts", 0U);
+    policy.maxWatts = restJson.value("maxWatts", 100000U);
+    policy.staleSamples = restJson.value("staleSamples", 5U);
+    restEstimator.emplace(policy);
+    restPeriod = std::chrono::milliseconds(restJson.value("periodMs", 1000U));
+    restHysteresis = restJson.value("hysteresisWatts", 25U);
+    restFeedsAllocation = restJson.value("feedAllocation", false);
+
+    restInterface = objServer.add_interface(
+        managerObjPath, "com.Nvidia.Powermanager.RestOfSystemEstimation");
+    restInterface->register_property(
+        "FeedsAllocation", restFeedsAllocation,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    restInterface->register_property(
+        "Valid", false, sdbusplus::asio::PropertyPermission::readOnly);
+    restInterface->register_property(
+        "EstimateWatts", static_cast<uint32_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    restInterface->register_property(
+        "AppliedWatts", static_cast<uint32_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    restInterface->initialize();
+
+    restTimer = std::make_unique<boost::asio::steady_timer>(io);
+    lastRestSample = std::chrono::steady_clock::now();
+    startRestTimer();
+}
+
+void PowerManager::startRestTimer()
+{
+    restTimer->expires_after(restPeriod);
+    restTimer->async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        sampleRestOfSystem();
+    });
+}
+
+void PowerManager::sampleRestOfSystem()
+{
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - lastRestSample).count();
+    lastRestSample = now;
+
+    std::vector<std::string> paths{restChassisSensorPath};
+    paths.insert(paths.end(), restModuleSensorPaths.begin(),
+                 restModuleSensorPaths.end());
+    readSensors(paths, [this, seconds](const std::vector<double>& power) {
+        // an unreadable module sensor makes the sum unknown
+        double modules = 0;
+        for (size_t i = 1; i < power.size(); i++)
+        {
+            modules += power[i];
+        }
+        updateRestOfSystem(power[0], modules, seconds);
+        startRestTimer();
+    });
+}
+
+void PowerManager::updateRestOfSystem(double chassis, double modules,
+                                      double seconds)
+{
+    restEstimator->update(chassis, modules, seconds);
+
+    auto estimate = restEstimator->estimate();
+    restInterface->set_property("Valid", estimate.has_value());
+    restInterface->set_property("EstimateWatts", estimate.value_or(0));
+    if (!restFeedsAllocation)
+    {
+        return;
+    }
+    // without an estimate the chassis limit is split by percentages again
+    bool changed = estimate.has_value() != appliedRestOfSystemPower.has_value();
+    if (estimate && appliedRestOfSystemPower)
+    {
+        auto delta = static_cast<int64_t>(*estimate) - *appliedRestOfSystemPower;
+        changed = std::abs(delta) >= static_cast<int64_t>(restHysteresis);
+    }
+    if (changed)
+    {
+        appliedRestOfSystemPower = estimate;
+        restInterface->set_property("AppliedWatts", estimate.value_or(0));
+        updateEmergencyCaps();
+        updateRestOfSystemPower();
+    }
+}
+
+void PowerManager::createPowerHistory()
+{
+    if (!JsonConfigData.contains("powerHistory") ||
+        !JsonConfigData["powerHistory"].value("enabled", false))
+    {
+        return;
+    }
+    const auto& historyJson = JsonConfigData["powerHistory"];
+    history::SeriesPolicy policy{};
+    policy.retentionMs =
+        int64_t{historyJson.value("retentionHours", 24U)} * 3600 * 1000;
+    policy.blockMs =
+        int64_t{historyJson.value("blockMinutes", 60U)} * 60 * 1000;
+    historyPeriod =
+        std::chrono::milliseconds(historyJson.value("periodMs", 1000U));
+
+    historySeries.emplace(
+        "Chassis",
+        HistorySeries{{"PowerLimit", "Power"},
+                      historyJson.value("chassisPowerSensorPath", ""),
+                      history::Series(2, policy)});
+    for (const auto& target : moduleCapTargets)
+    {
+        auto path = modulePowerSensor(historyJson, target);
+        historySeries.emplace(
+            target.module,
+            HistorySeries{{"PowerCap", "Allocation", "Power"}, path,
+                          history::Series(3, policy)});
+    }
+
+    std::vector<std::string> names;
+    for (const auto& [name, entry] : historySeries)
+    {
+        names.push_back(name);
+    }
+    historyInterface = objServer.add_interface(
+        managerObjPath, "com.Nvidia.Powermanager.PowerHistory");
+    historyInterface->register_property(
+        "PeriodMs", static_cast<uint64_t>(historyPeriod.count()),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    historyInterface->register_property(
+        "Series", names, sdbusplus::asio::PropertyPermission::readOnly);
+    historyInterface->register_method(
+        "Query", [this](const std::string& series, const std::string& column,
+                        uint64_t fromMs, uint64_t toMs, uint64_t bucketMs) {
+        return queryHistory(series, column, fromMs, toMs, bucketMs);
+    });
+    historyInterface->register_method("EnergyJoules", [this]() {
+        std::map<std::string, double> energy;
+        for (const auto& [name, entry] : historySeries)
+        {
+            // the last column is the measured power
+            energy[name] = entry.series.integral(entry.columns.size() - 1);
+        }
+        return energy;
+    });
+    historyInterface->register_method("MemoryBytes", [this]() {
+        uint64_t bytes = 0;
+        for (const auto& [name, entry] : historySeries)
+        {
+            bytes += entry.series.bytes();
+        }
+        return bytes;
+    });
+    historyInterface->initialize();
+
+    historyTimer = std::make_unique<boost::asio::steady_timer>(io);
+    startHistoryTimer();
+}
+
+void PowerManager::startHistoryTimer()
+{
+    historyTimer->expires_after(historyPeriod);
+    historyTimer->async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        sampleHistory();
+    });
+}
+
+void PowerManager::sampleHistory()
+{
+    // the samples are ordered and integrated on the steady clock, the wall
+    // clock only dates them for the queries and may be stepped by NTP
+    auto toMs = [](auto time) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   time.time_since_epoch())
+            .count();
+    };
+    int64_t monotonicMs = toMs(std::chrono::steady_clock::now());
+    int64_t wallMs = toMs(std::chrono::system_clock::now());
+
+    std::vector<std::string> paths{historySeries.at("Chassis").powerSensorPath};
+    for (const auto& target : moduleCapTargets)
+    {
+        paths.push_back(historySeries.at(target.module).powerSensorPath);
+    }
+    readSensors(paths, [this, monotonicMs,
+                        wallMs](const std::vector<double>& power) {
+        auto& chassis = historySeries.at("Chassis");
+        chassis.series.append(monotonicMs, wallMs,
+                              {static_cast<double>(enforcedPowerLimit),
+                               power[0]});
+        for (size_t i = 0; i < moduleCapTargets.size(); i++)
+        {
+            const auto& target = moduleCapTargets[i];
+            auto& entry = historySeries.at(target.module);
+            double cap = target.propObj
+                             ? static_cast<double>(target.propObj->getValue())
+                             : NAN;
+            double allocation = sharingPeriod.count() ? target.sharedCap
+                                                      : target.operatorCap;
+            entry.series.append(monotonicMs, wallMs,
+                                {cap, allocation, power[i + 1]});
+        }
+        startHistoryTimer();
+    });
+}
+
+std::vector<std::tuple<uint64_t, double, double, double, uint32_t>>
+    PowerManager::queryHistory(const std::string& series,
+                               const std::string& column, uint64_t fromMs,
+                               uint64_t toMs, uint64_t bucketMs)
+{
+    auto entry = historySeries.find(series);
+    if (entry == historySeries.end())
+    {
+        throw sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument();
+    }
+    const auto& columns = entry->second.columns;
+    auto index = std::find(columns.begin(), columns.end(), column);
+    if (index == columns.end() || fromMs > toMs ||
+        toMs > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+    {
+        throw sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument();
+    }
+
+    std::vector<std::tuple<uint64_t, double, double, double, uint32_t>> result;
+    for (const auto& bucket : entry->second.series.downsample(
+             index - columns.begin(), fromMs, toMs, bucketMs))
+    {
+        result.emplace_back(bucket.startMs, bucket.min, bucket.max, bucket.avg,
+                            bucket.count);
+    }
+    return result;
+}
+
+void PowerManager::handleEmergencyEvent(
+    const std::string& path, bool asserted,
+    std::chrono::steady_clock::time_point received)
+{
+    if (asserted)
+    {
+        assertedEmergencyEvents.insert(path);
+    }
+    else
+    {
+        assertedEmergencyEvents.erase(path);
+    }
+
+    // the entry with the least healthy PSUs is the most restrictive one
+    const EmergencyCapEntry* entry = nullptr;
+    for (const auto& eventPath : assertedEmergencyEvents)
+    {
+        const auto& candidate =
+            emergencyCapTable.at(emergencyEvents.at(eventPath).healthyPsus);
+        if (entry == nullptr || candidate.healthyPsus < entry->healthyPsus)
+        {
+            entry = &candidate;
+        }
+    }
+    if (entry == activeEmergencyCap)
+    {
+        return;
+    }
+    activeEmergencyCap = entry;
+    applyModuleCaps(true);
+
+    uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - received)
+                           .count();
+    if (entry != nullptr)
+    {
+        clampCount++;
+        maxClampLatencyUsec = std::max(maxClampLatencyUsec, latency);
+        log<level::INFO>(
+            fmt::format("Emergency power caps applied for {} healthy PSUs, "
+                        "chassis limit {}W, latency {}us",
+                        entry->healthyPsus, entry->chassisPowerLimit, latency)
+                .c_str());
+    }
+    else
+    {
+        log<level::INFO>("PSU redundancy recovered, operator power caps "
+                         "restored");
+    }
+
+    if (emergencyInterface)
+    {
+        emergencyInterface->set_property("Active", entry != nullptr);
+        emergencyInterface->set_property(
+            "HealthyPsus", entry ? entry->healthyPsus : uint32_t{0});
+        if (entry != nullptr)
+        {
+            emergencyInterface->set_property("ClampCount", clampCount);
+            emergencyInterface->set_property("LastClampLatencyUsec", latency);
+            emergencyInterface->set_property("MaxClampLatencyUsec",
+                                             maxClampLatencyUsec);
+        }
+    }
+}
+
+uint8_t PowerManager::caluclateChecksum(uint8_t* data, size_t length)
+{
+    try
+    {
+        uint8_t checksum = 0;
+        for (int i = 0; i < static_cast<int>(length); i++)
+        {
+            checksum += data[i];
+        }
+        return ((~checksum) + 1);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << __func__ << e.what() << std::endl;
+    }
+}
+
+bool PowerManager::checkChecksum(uint8_t* data, size_t length)
+{
+    try
+    {
+        uint8_t checksum = 0;
+        for (int i = 0; i < static_cast<int>(length); i++)
+        {
+            checksum += data[i];
+        }
+        return (checksum) ? false : true;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << __func__ << e.what() << std::endl;
+    }
+}
+
+void PowerManager::updatePowerCappingStructure(bool fileExist)
+{
+    try
+    {
+        for (const auto& jsonData0 : JsonConfigData["powerCappingConfigs"])
+        {
+            for (const auto& jsonData1 : jsonData0["property"])
+            {
+                std::string propertyname = jsonData1["propertyName"];
+
+                std::string path(jsonData0["objectName"]);
+
+                //  get the index of the module or chassis
+                std::size_t found = path.find_last_of("/");
+                int index = -1;
+                std::string file;
+                // the object path starts with ProcessorModule_{instance_id}
+                // so we can get the module index where index is 0 based.
+                if (found != std::string::npos)
+                {
+                    file = path.substr(found + 1);
+                    found = file.find_first_of("_");
+                }
+                if (found != std::string::npos)
+                {
+                    std::string num = file.substr(found + 1, 1);
+                    index = std::stoi(num);
+                }
+
+                if (propertyname == "PowerCap" && index >= 0)
+                {
+                    powerCappingInfo.modulePowerLimit[index] =
+                        jsonData1["value"];
+                }
+                else if (propertyname == "PowerCap")
+                {
+                    powerCappingInfo.currentPowerLimit = jsonData1["value"];
+                }
+                else if (propertyname == "PowerCapPercentage" && index >= 0)
+                {
+                    powerCappingInfo.modulePowerLimitPercentage[index] =
+                        jsonData1["value"];
+                }
+                else if (propertyname == "MinPowerCapValue" && index >= 0)
+                {
+                    powerCappingInfo.modulePowerLimit_Min[index] =
+                        jsonData1["value"];
+                }
+                else if (propertyname == "MinPowerCapValue")
+                {
+                    powerCappingInfo.chassisPowerLimit_Min = jsonData1["value"];
+                }
+                else if (propertyname == "PowerMode")
+                {
+                    powerCappingInfo.mode =
+                        jsonData1["value"].get<property::PowerMode>();
+                }
+                else if (propertyname == "MaxPowerCapValue" &&
+                         file == "CurrentChassisLimit")
+                {
+                    powerCappingInfo.chassisPowerLimit_Max = jsonData1["value"];
+                }
+                else if (propertyname == "MaxPowerCapValue" && index >= 0 &&
+                         file.find(MODULE_OBJ_PATH_PREFIX) != std::string::npos)
+                {
+                    powerCappingInfo.modulePowerLimit_Max[index] =
+                        jsonData1["value"];
+                }
+                else if (propertyname == "MaxPowerCapValue" &&
+                         file == "ChassisLimitQ")
+                {
+                    powerCappingInfo.chassisPowerLimit_Q = jsonData1["value"];
+                }
+                else if (propertyname == "MaxPowerCapValue" &&
+                         file == "ChassisLimitP")
+                {
+                    powerCappingInfo.chassisPowerLimit_P = jsonData1["value"];
+                }
+                else if (propertyname == "Value")
+                {
+                    powerCappingInfo.restOfSystemPower = jsonData1["value"];
+                }
+            }
+        }
+        std::string powerCapBinPath = JsonConfigData["powerCappingSavePath"];
+        size_t size = fileExist ? getPowerCapFileLength(powerCapBinPath.c_str())
+                                : sizeof(struct PowerCappingInfo);
+        powerCappingInfo.checksum = 0;
+        powerCappingInfo.checksum = caluclateChecksum(
+            reinterpret_cast<uint8_t*>(&powerCappingInfo), size);
+
+        util::dumpPowerCapIntoFile(
+            powerCapBinPath.c_str(),
+            reinterpret_cast<uint8_t*>(&powerCappingInfo), size);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << __func__ << e.what() << std::endl;
+    }
+}
+
+void PowerManager::getDataForAppend(nlohmann::json dataJson,
+                                    sdbusplus::message::message& methodObj)
+{
+    try
+    {
+        std::string parameter = dataJson["dataType"];
+        switch (parameter.at(0))
+        {
+            case DBUSTYPE_SIGNED_INT16:
+                if (dataJson["data"].type() == json::value_t::array)
+                {
                     std::vector<int16_t> data = dataJson["data"];
                     if (dataJson.contains("variant"))
                     {
@@ -867,126 +2095,832 @@ void PowerManager::getDataForAppend(nlohmann::json dataJson,
                 break;
             case DBUSTYPE_BOOL:
             {
-                bool data = dataJson["data"];
-                if (dataJson.contains("variant"))
-                {
-                    Value variantdata = data;
-                    methodObj.append(variantdata);
-                }
-                else
+                bool data = dataJson["data"];
+                if (dataJson.contains("variant"))
+                {
+                    Value variantdata = data;
+                    methodObj.append(variantdata);
+                }
+                else
+                {
+                    methodObj.append(data);
+                }
+            }
+            break;
+            case DBUSTYPE_DICT:
+                if (dataJson["data"].type() == json::value_t::array)
+                {
+                    std::vector<std::map<std::string, std::string>> dict =
+                        dataJson["data"];
+                    std::map<std::string, std::string> appendMsg;
+                    for (auto item : dict)
+                    {
+                        for (auto i : item)
+                        {
+                            appendMsg[i.first] = i.second;
+                        }
+                    }
+                    methodObj.append(appendMsg);
+                }
+                break;
+            default:
+                std::cout << "unknown data type" << std::endl;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << __func__ << e.what() << std::endl;
+    }
+}
+
+bool PowerManager::executeConditionBlock(nlohmann::json jsonData)
+{
+    auto conditionSuccess = true;
+    for (const auto& jsonData1 : jsonData["conditionBlock"])
+    {
+        if (jsonData1.contains("timeDelay"))
+        {
+            sleep(jsonData1["timeDelay"]);
+        }
+        const std::string Obj = jsonData1["serviceName"];
+        const std::string Path = jsonData1["objectpath"];
+        const std::string AddInterface = jsonData1["interfaceName"];
+        const std::string propertyName = jsonData1["propertyName"];
+        if (Obj == BUSNAME)
+        {
+            conditionSuccess = false;
+            for (const auto& propObj : PowerManager::propertyObjs)
+            {
+                if (propObj->getInterfaceName()->get_object_path() == Path &&
+                    propObj->getPropertyName() == propertyName)
+                {
+                    if (propertyName == "PowerMode")
+                    {
+                        std::string mode = jsonData1["propertyValue"];
+                        if (propObj->getPowerMode() == mode)
+                        {
+                            conditionSuccess = true;
+                        }
+                        else
+                        {
+                            conditionSuccess = false;
+                            break;
+                        }
+                    }
+                    else
+                    {
+                        uint32_t value = jsonData1["propertyValue"];
+                        if (propObj->getValue() == value)
+                        {
+                            conditionSuccess = true;
+                        }
+                        else
+                        {
+                            conditionSuccess = false;
+                            break;
+                        }
+                    }
+                }
+            }
+            return conditionSuccess;
+        }
+        auto bus = sdbusplus::bus::new_default();
+        if (jsonData1["propertyValue"].type() == json::value_t::string)
+        {
+            std::string value;
+            std::string jsonVal = jsonData1["propertyValue"];
+            util::getProperty<std::string>(AddInterface, propertyName, Path,
+                                           Obj, bus, value);
+            if (value != jsonVal)
+            {
+                conditionSuccess = false;
+                break;
+            }
+        }
+        else if (jsonData1["propertyValue"].type() == json::value_t::boolean)
+        {
+            bool value;
+            bool jsonVal = jsonData1["propertyValue"];
+            util::getProperty<bool>(AddInterface, propertyName, Path, Obj, bus,
+                                    value);
+            if (value != jsonVal)
+            {
+                conditionSuccess = false;
+                break;
+            }
+        }
+    }
+    return conditionSuccess;
+}
+void PowerManager::createActionInterface()
+{
+    actionStatsInterface = objServer.add_interface(
+        managerObjPath, "com.Nvidia.Powermanager.Actions");
+    actionStatsInterface->register_property(
+        "ElidedSetCount", elidedSetCount,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    actionStatsInterface->initialize();
+}
+
+void PowerManager::createPowerOnStaging()
+{
+    if (!JsonConfigData.contains("powerOnStaging") ||
+        !JsonConfigData["powerOnStaging"].value("enabled", false))
+    {
+        return;
+    }
+    const auto& stagingJson = JsonConfigData["powerOnStaging"];
+    stagingTimeout =
+        std::chrono::milliseconds(stagingJson.value("timeoutMs", 2000U));
+    for (const auto& jsonData0 :
+         stagingJson.value("acknowledgements", nlohmann::json::array()))
+    {
+        std::string module = jsonData0["powerModule"];
+        auto target = std::find_if(
+            moduleCapTargets.begin(), moduleCapTargets.end(),
+            [&module](const auto& target) { return target.module == module; });
+        if (target == moduleCapTargets.end() || !target->propObj)
+        {
+            std::cerr << "Power on staging module " << module
+                      << " not found in powerCappingAlgorithm" << std::endl;
+            continue;
+        }
+        size_t ack = stagingAckTargets.size();
+        stagingAckTargets.push_back(target - moduleCapTargets.begin());
+        shared.router.subscribe(
+            jsonData0["objectName"].get<std::string>(),
+            jsonData0["interfaceName"].get<std::string>(),
+            jsonData0["propertyName"].get<std::string>(),
+            [this, ack](const std::string&, const std::string&,
+                        const Value* value) {
+            this->stagingAckChanged(ack, value);
+        });
+    }
+
+    stagingInterface = objServer.add_interface(
+        managerObjPath, "com.Nvidia.Powermanager.PowerOnStaging");
+    stagingInterface->register_property(
+        "State", stagingState, sdbusplus::asio::PropertyPermission::readOnly);
+    stagingInterface->register_property(
+        "LastAckLatencyUsec", static_cast<uint64_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    stagingInterface->register_property(
+        "MaxAckLatencyUsec", maxAckLatencyUsec,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    stagingInterface->register_property(
+        "TimeoutCount", stagingTimeoutCount,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    stagingInterface->register_method("Stage",
+                                      [this]() { stagePowerOnCaps(); });
+    stagingInterface->initialize();
+
+    stagingTimer = std::make_unique<boost::asio::steady_timer>(io);
+}
+
+void PowerManager::stagePowerOnCaps()
+{
+    if (stagingState == "Staging")
+    {
+        // the caller waits for the staging in progress
+        return;
+    }
+    stagedForPowerOn = true;
+    stagingStart = std::chrono::steady_clock::now();
+    stagingState = "Staging";
+    stagingInterface->set_property("State", stagingState);
+
+    // the devices come up with their default caps, the caps are signalled
+    // even when unchanged so that they are applied again
+    updatePowerCappingLimit(false);
+    if (capRamp)
+    {
+        // the devices are not drawing power yet, nothing to ramp
+        capRamp->restart(capRamp->targets(), ramp::Clock::now());
+        applyModuleCaps(false);
+    }
+    for (const auto& target : moduleCapTargets)
+    {
+        if (target.propObj)
+        {
+            target.propObj->triggerEmitChangeSignal();
+        }
+    }
+
+    pendingStagingAcks.clear();
+    for (size_t ack = 0; ack < stagingAckTargets.size(); ack++)
+    {
+        pendingStagingAcks.insert(ack);
+    }
+    if (pendingStagingAcks.empty())
+    {
+        finishStaging(true);
+        return;
+    }
+    stagingTimer->expires_after(stagingTimeout);
+    stagingTimer->async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        finishStaging(false);
+    });
+}
+
+void PowerManager::stagingAckChanged(size_t ack, const Value* value)
+{
+    if (stagingState != "Staging" || !value)
+    {
+        return;
+    }
+    auto applied = std::visit(
+        [](const auto& v) -> std::optional<long> {
+        if constexpr (std::is_arithmetic_v<std::decay_t<decltype(v)>>)
+        {
+            return std::lround(static_cast<double>(v));
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    },
+        *value);
+    const auto& target = moduleCapTargets[stagingAckTargets[ack]];
+    if (applied && *applied == static_cast<long>(target.propObj->getValue()))
+    {
+        pendingStagingAcks.erase(ack);
+        if (pendingStagingAcks.empty())
+        {
+            finishStaging(true);
+        }
+    }
+}
+
+void PowerManager::finishStaging(bool acknowledged)
+{
+    stagingTimer->cancel();
+    auto latencyUsec = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - stagingStart)
+                           .count();
+    if (acknowledged)
+    {
+        stagingState = "Acknowledged";
+        maxAckLatencyUsec =
+            std::max(maxAckLatencyUsec, static_cast<uint64_t>(latencyUsec));
+        stagingInterface->set_property("LastAckLatencyUsec",
+                                       static_cast<uint64_t>(latencyUsec));
+        stagingInterface->set_property("MaxAckLatencyUsec", maxAckLatencyUsec);
+    }
+    else
+    {
+        stagingState = "TimedOut";
+        stagingInterface->set_property("TimeoutCount", ++stagingTimeoutCount);
+        std::cerr << "Power on caps not acknowledged within "
+                  << stagingTimeout.count() << "ms" << std::endl;
+    }
+    stagingInterface->set_property("State", stagingState);
+}
+
+void PowerManager::createCapBroker()
+{
+    if (!JsonConfigData.contains("capBroker") ||
+        !JsonConfigData["capBroker"].value("enabled", false))
+    {
+        return;
+    }
+    maxLease = std::chrono::seconds(
+        JsonConfigData["capBroker"].value("maxLeaseSeconds", 3600U));
+
+    brokerInterface = objServer.add_interface(
+        managerObjPath, "com.Nvidia.Powermanager.CapBroker");
+    brokerInterface->register_property(
+        "Owner", std::string(), sdbusplus::asio::PropertyPermission::readOnly);
+    brokerInterface->register_property(
+        "Cap", static_cast<uint32_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    brokerInterface->register_property(
+        "Priority", static_cast<uint8_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    brokerInterface->register_property(
+        "ActiveRequests", static_cast<uint32_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    brokerInterface->register_method(
+        "RequestCap", [this](const std::string& owner, uint32_t cap,
+                             uint8_t priority, uint32_t leaseSeconds) {
+        return requestCap(owner, cap, priority, leaseSeconds);
+    });
+    brokerInterface->register_method("ReleaseCap",
+                                     [this](const std::string& owner) {
+        if (capBroker.release(owner))
+        {
+            updateBrokerCap();
+        }
+        startLeaseTimer();
+    });
+    brokerInterface->initialize();
+
+    leaseTimer = std::make_unique<boost::asio::steady_timer>(io);
+}
+
+uint32_t PowerManager::requestCap(const std::string& owner, uint32_t cap,
+                                  uint8_t priority, uint32_t leaseSeconds)
+{
+    if (owner.empty() || leaseSeconds == 0 ||
+        std::chrono::seconds(leaseSeconds) > maxLease)
+    {
+        throw sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument();
+    }
+    if (cap < powerCappingInfo.chassisPowerLimit_Min ||
+        cap > powerCappingInfo.chassisPowerLimit_Max)
+    {
+        throw ChassisLimitOutOfRange();
+    }
+
+    auto now = broker::Clock::now();
+    bool changed = capBroker.expire(now);
+    changed |= capBroker.submit(broker::CapRequest{
+        owner, cap, priority, now + std::chrono::seconds(leaseSeconds)});
+    if (changed)
+    {
+        updateBrokerCap();
+    }
+    startLeaseTimer();
+    return enforcedPowerLimit;
+}
+
+void PowerManager::updateBrokerCap()
+{
+    auto winner = capBroker.winner();
+    brokerInterface->set_property("Owner",
+                                  winner ? winner->owner : std::string());
+    brokerInterface->set_property("Cap", winner ? winner->cap : 0U);
+    brokerInterface->set_property(
+        "Priority", winner ? winner->priority : static_cast<uint8_t>(0));
+    brokerInterface->set_property("ActiveRequests",
+                                  static_cast<uint32_t>(capBroker.size()));
+
+    // the leases overlay the operator limit, which stays as configured and
+    // persisted, the caps only move when the enforced limit changes
+    if (brokerLimit(curentPowerLimit) != enforcedPowerLimit)
+    {
+        updatePowerCappingLimit(true);
+    }
+}
+
+uint32_t PowerManager::brokerLimit(uint32_t chassisLimit) const
+{
+    auto winner = capBroker.winner();
+    return winner ? std::min(chassisLimit, winner->cap) : chassisLimit;
+}
+
+void PowerManager::startLeaseTimer()
+{
+    auto next = capBroker.nextExpiry();
+    if (!next)
+    {
+        leaseTimer->cancel();
+        return;
+    }
+    leaseTimer->expires_at(*next);
+    leaseTimer->async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        if (capBroker.expire(broker::Clock::now()))
+        {
+            updateBrokerCap();
+        }
+        startLeaseTimer();
+    });
+}
+
+void PowerManager::createCapReconciliation()
+{
+    if (!JsonConfigData.contains("capReconciliation") ||
+        !JsonConfigData["capReconciliation"].value("enabled", false))
+    {
+        return;
+    }
+    const auto& reconcileJson = JsonConfigData["capReconciliation"];
+    reconcilePeriod =
+        std::chrono::milliseconds(reconcileJson.value("periodMs", 1000U));
+    for (const auto& jsonData0 :
+         reconcileJson.value("targets", nlohmann::json::array()))
+    {
+        std::string module = jsonData0["powerModule"];
+        auto target = std::find_if(
+            moduleCapTargets.begin(), moduleCapTargets.end(),
+            [&module](const auto& target) { return target.module == module; });
+        if (target == moduleCapTargets.end() || !target->propObj)
+        {
+            std::cerr << "Cap reconciliation module " << module
+                      << " not found in powerCappingAlgorithm" << std::endl;
+            continue;
+        }
+        ReconcileTarget reconcileTarget{
+            static_cast<size_t>(target - moduleCapTargets.begin()),
+            ActionSetKey{jsonData0["serviceName"].get<std::string>(),
+                         jsonData0["objectName"].get<std::string>(),
+                         jsonData0.value("interfaceName",
+                                         "xyz.openbmc_project.Control.Power.Cap"),
+                         jsonData0.value("propertyName", "PowerCap")},
+            nullptr};
+
+        // the Set action block of the module writing this target, if any,
+        // is the one replayed to push the cap
+        for (const auto& jsonData1 : JsonConfigData["powerCappingConfigs"])
+        {
+            if (jsonData1["module"] != target->propObj->getPowerModuleName())
+            {
+                continue;
+            }
+            for (const auto& jsonData2 : jsonData1["property"])
+            {
+                if (jsonData2["propertyName"] != "PowerCap" ||
+                    !jsonData2.contains("action"))
                 {
-                    methodObj.append(data);
+                    continue;
                 }
-            }
-            break;
-            case DBUSTYPE_DICT:
-                if (dataJson["data"].type() == json::value_t::array)
+                for (const auto& action : jsonData2["action"])
                 {
-                    std::vector<std::map<std::string, std::string>> dict =
-                        dataJson["data"];
-                    std::map<std::string, std::string> appendMsg;
-                    for (auto item : dict)
+                    if (getActionSetKey(action) == reconcileTarget.key)
                     {
-                        for (auto i : item)
-                        {
-                            appendMsg[i.first] = i.second;
-                        }
+                        reconcileTarget.setAction = &action;
                     }
-                    methodObj.append(appendMsg);
                 }
-                break;
-            default:
-                std::cout << "unknown data type" << std::endl;
+            }
         }
+
+        // the targets of an ObjectManager are read together, the others
+        // with one GetAll per object and interface
+        ReconcileRead batch{};
+        batch.service = std::get<0>(reconcileTarget.key);
+        batch.path = jsonData0.value("objectManagerPath", std::string());
+        if (batch.path.empty())
+        {
+            batch.path = std::get<1>(reconcileTarget.key);
+            batch.interface = std::get<2>(reconcileTarget.key);
+        }
+        auto read = std::find_if(reconcileReads.begin(), reconcileReads.end(),
+                                 [&batch](const auto& other) {
+            return other.service == batch.service &&
+                   other.path == batch.path &&
+                   other.interface == batch.interface;
+        });
+        if (read == reconcileReads.end())
+        {
+            read = reconcileReads.insert(reconcileReads.end(),
+                                         std::move(batch));
+        }
+        read->targets.push_back(reconcileTargets.size());
+        reconcileTargets.push_back(std::move(reconcileTarget));
     }
-    catch (const std::exception& e)
-    {
-        std::cerr << __func__ << e.what() << std::endl;
-    }
+
+    reconcile::ReconcilePolicy policy{};
+    policy.backoff = std::chrono::milliseconds(
+        reconcileJson.value("backoffMs", reconcilePeriod.count()));
+    policy.maxBackoff = std::chrono::milliseconds(
+        reconcileJson.value("maxBackoffMs", 60000U));
+    capReconciler.emplace(policy, reconcileTargets.size());
+
+    reconcileInterface = objServer.add_interface(
+        managerObjPath, "com.Nvidia.Powermanager.Reconciliation");
+    reconcileInterface->register_property(
+        "PeriodMs", static_cast<uint64_t>(reconcilePeriod.count()),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    reconcileInterface->register_property(
+        "DriftCount", static_cast<uint64_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    reconcileInterface->register_property(
+        "PushCount", static_cast<uint64_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    reconcileInterface->register_property(
+        "ReadErrorCount", reconcileReadErrors,
+        sdbusplus::asio::PropertyPermission::readOnly);
+    reconcileInterface->register_property(
+        "MismatchedTargets", static_cast<uint32_t>(0),
+        sdbusplus::asio::PropertyPermission::readOnly);
+    reconcileInterface->initialize();
+
+    reconcileTimer = std::make_unique<boost::asio::steady_timer>(io);
+    startReconcileTimer();
 }
 
-bool PowerManager::executeConditionBlock(nlohmann::json jsonData)
+void PowerManager::startReconcileTimer()
 {
-    auto conditionSuccess = true;
-    for (const auto& jsonData1 : jsonData["conditionBlock"])
+    reconcileTimer->expires_after(reconcilePeriod);
+    reconcileTimer->async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        reconcileCaps();
+    });
+}
+
+void PowerManager::reconcileCaps()
+{
+    using ManagedObjects = std::map<
+        sdbusplus::message::object_path,
+        std::map<std::string, std::map<std::string, Value>>>;
+
+    if (reconcileReads.empty())
     {
-        if (jsonData1.contains("timeDelay"))
+        startReconcileTimer();
+        return;
+    }
+    // one read per ObjectManager or per object, all in flight together, the
+    // next cycle starts once they all answered
+    auto pending = std::make_shared<size_t>(reconcileReads.size());
+    auto now = reconcile::Clock::now();
+    auto finish = [this, pending]() {
+        if (--*pending > 0)
         {
-            sleep(jsonData1["timeDelay"]);
+            return;
         }
-        const std::string Obj = jsonData1["serviceName"];
-        const std::string Path = jsonData1["objectpath"];
-        const std::string AddInterface = jsonData1["interfaceName"];
-        const std::string propertyName = jsonData1["propertyName"];
-        if (Obj == BUSNAME)
+        reconcileInterface->set_property("DriftCount",
+                                         capReconciler->drifts());
+        reconcileInterface->set_property("PushCount", capReconciler->pushes());
+        reconcileInterface->set_property("ReadErrorCount",
+                                         reconcileReadErrors);
+        reconcileInterface->set_property("MismatchedTargets",
+                                         capReconciler->mismatched());
+        startReconcileTimer();
+    };
+
+    for (size_t read = 0; read < reconcileReads.size(); read++)
+    {
+        const auto& batch = reconcileReads[read];
+        if (batch.interface.empty())
         {
-            conditionSuccess = false;
-            for (const auto& propObj : PowerManager::propertyObjs)
-            {
-                if (propObj->getInterfaceName()->get_object_path() == Path &&
-                    propObj->getPropertyName() == propertyName)
+            shared.conn->async_method_call(
+                [this, read, now, finish](const boost::system::error_code& ec,
+                                          const ManagedObjects& objects) {
+                if (reconcileReadDone(read, ec))
                 {
-                    if (propertyName == "PowerMode")
+                    for (auto index : reconcileReads[read].targets)
                     {
-                        std::string mode = jsonData1["propertyValue"];
-                        if (propObj->getPowerMode() == mode)
-                        {
-                            conditionSuccess = true;
-                        }
-                        else
-                        {
-                            conditionSuccess = false;
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        uint32_t value = jsonData1["propertyValue"];
-                        if (propObj->getValue() == value)
-                        {
-                            conditionSuccess = true;
-                        }
-                        else
+                        const auto& [service, path, iface, property] =
+                            reconcileTargets[index].key;
+                        const Value* value = nullptr;
+                        auto object = objects.find(
+                            sdbusplus::message::object_path(path));
+                        if (object != objects.end())
                         {
-                            conditionSuccess = false;
-                            break;
+                            auto properties = object->second.find(iface);
+                            if (properties != object->second.end())
+                            {
+                                auto found = properties->second.find(property);
+                                if (found != properties->second.end())
+                                {
+                                    value = &found->second;
+                                }
+                            }
                         }
+                        reconcileCap(index, value, now);
                     }
                 }
-            }
-            return conditionSuccess;
+                finish();
+            },
+                batch.service, batch.path, "org.freedesktop.DBus.ObjectManager",
+                "GetManagedObjects");
+            continue;
         }
-        auto bus = sdbusplus::bus::new_default();
-        if (jsonData1["propertyValue"].type() == json::value_t::string)
+        shared.conn->async_method_call(
+            [this, read, now, finish](
+                const boost::system::error_code& ec,
+                const std::map<std::string, Value>& properties) {
+            if (reconcileReadDone(read, ec))
+            {
+                for (auto index : reconcileReads[read].targets)
+                {
+                    const auto& property =
+                        std::get<3>(reconcileTargets[index].key);
+                    auto found = properties.find(property);
+                    reconcileCap(index,
+                                 found != properties.end() ? &found->second
+                                                           : nullptr,
+                                 now);
+                }
+            }
+            finish();
+        },
+            batch.service, batch.path, util::PROPERTY_INTF, "GetAll",
+            batch.interface);
+    }
+}
+
+bool PowerManager::reconcileReadDone(size_t read,
+                                     const boost::system::error_code& ec)
+{
+    auto& batch = reconcileReads[read];
+    if (!ec)
+    {
+        if (batch.failing)
         {
-            std::string value;
-            std::string jsonVal = jsonData1["propertyValue"];
-            util::getProperty<std::string>(AddInterface, propertyName, Path,
-                                           Obj, bus, value);
-            if (value != jsonVal)
+            batch.failing = false;
+            std::cerr << "reconcileCaps " << batch.service << " "
+                      << batch.path << " readable again" << std::endl;
+        }
+        return true;
+    }
+    // the service may be restarting, its caps are checked next cycle, the
+    // failure is logged once
+    reconcileReadErrors++;
+    if (!batch.failing)
+    {
+        batch.failing = true;
+        std::cerr << "reconcileCaps " << batch.service << " " << batch.path
+                  << ": " << ec.message() << std::endl;
+    }
+    return false;
+}
+
+void PowerManager::reconcileCap(size_t index, const Value* value,
+                                reconcile::Clock::time_point now)
+{
+    const auto& target = reconcileTargets[index];
+    std::optional<uint32_t> reported;
+    if (value)
+    {
+        reported = std::visit(
+            [](const auto& v) -> std::optional<uint32_t> {
+            if constexpr (std::is_arithmetic_v<std::decay_t<decltype(v)>>)
             {
-                conditionSuccess = false;
-                break;
+                return std::lround(static_cast<double>(v));
+            }
+            else
+            {
+                return std::nullopt;
             }
+        },
+            *value);
+    }
+    uint32_t desired = moduleCapTargets[target.module].propObj->getValue();
+    if (capReconciler->observe(index, reported, desired, now) ==
+        reconcile::Decision::Push)
+    {
+        pushReconciledCap(target, desired);
+    }
+}
+
+void PowerManager::pushReconciledCap(const ReconcileTarget& target,
+                                     uint32_t cap)
+{
+    const auto& module = moduleCapTargets[target.module];
+    log<level::INFO>(fmt::format("{} reports a cap other than {}W, pushing it",
+                                 std::get<1>(target.key), cap)
+                         .c_str());
+    if (!target.setAction)
+    {
+        // the cap reaches this target through the change signal
+        module.propObj->triggerEmitChangeSignal();
+        return;
+    }
+    try
+    {
+        if (target.setAction->contains("conditionBlock") &&
+            !executeConditionBlock(*target.setAction))
+        {
+            return;
         }
-        else if (jsonData1["propertyValue"].type() == json::value_t::boolean)
+        // the value written last is no longer held by the target
+        lastSetValues.erase(target.key);
+        executeActionBlock<uint32_t>(*target.setAction, "PowerCap", cap);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << __func__ << e.what() << std::endl;
+    }
+}
+
+std::optional<ActionSetKey>
+    PowerManager::getActionSetKey(const nlohmann::json& jsonData)
+{
+    if (jsonData["methodName"] != "Set" ||
+        jsonData["interfaceName"] != util::PROPERTY_INTF ||
+        !jsonData.contains("appendData") || jsonData["appendData"].size() != 3)
+    {
+        return std::nullopt;
+    }
+    const auto& appendData = jsonData["appendData"];
+    auto iface = appendData[0].value("data", nlohmann::json());
+    auto property = appendData[1].value("data", nlohmann::json());
+    if (!iface.is_string() || !property.is_string() ||
+        appendData[2].value("data", nlohmann::json()) == "OEM")
+    {
+        return std::nullopt;
+    }
+    return ActionSetKey{jsonData["serviceName"].get<std::string>(),
+                        jsonData["objectpath"].get<std::string>(),
+                        iface.get<std::string>(), property.get<std::string>()};
+}
+
+void PowerManager::rememberSetValue(const ActionSetKey& key,
+                                    const nlohmann::json& value)
+{
+    lastSetValues[key] = value;
+
+    if (watchedSetTargets.insert(key).second)
+    {
+        const auto& [service, path, iface, property] = key;
+        shared.router.subscribe(
+            path, iface, property,
+            [this, key](const std::string&, const std::string&,
+                        const Value* value) {
+            this->setTargetChanged(key, value);
+        });
+    }
+}
+
+void PowerManager::setTargetChanged(const ActionSetKey& key,
+                                    const Value* value)
+{
+    auto lastValue = lastSetValues.find(key);
+    if (lastValue == lastSetValues.end())
+    {
+        return;
+    }
+    // a type we do not know is taken as changed
+    if (!value || std::visit([](const auto& v) { return nlohmann::json(v); },
+                             *value) != lastValue->second)
+    {
+        lastSetValues.erase(lastValue);
+    }
+}
+
+template <typename T>
+void PowerManager::executeActionBlock(nlohmann::json jsonData,
+                                      std::string propertyName, T& state)
+{
+    const std::string actionMethod = jsonData["methodName"];
+
+    // skip a Set which would write the value the target already holds
+    auto setKey = getActionSetKey(jsonData);
+    nlohmann::json setValue;
+    if (setKey)
+    {
+        const auto& valueJson = jsonData["appendData"][2]["data"];
+        setValue = valueJson == "PropertyValue" ? nlohmann::json(state)
+                                                : valueJson;
+        auto written = lastSetValues.find(*setKey);
+        if (!jsonData.value("force", false) &&
+            written != lastSetValues.end() && written->second == setValue)
         {
-            bool value;
-            bool jsonVal = jsonData1["propertyValue"];
-            util::getProperty<bool>(AddInterface, propertyName, Path, Obj, bus,
-                                    value);
-            if (value != jsonVal)
+            actionStatsInterface->set_property("ElidedSetCount",
+                                               ++elidedSetCount);
+            return;
+        }
+    }
+
+    if (selAggregator && selMethods.contains(actionMethod))
+    {
+        // the class defaults to the property and the message of the record
+        std::string eventClass = propertyName;
+        for (const auto& jsonData1 : jsonData["appendData"])
+        {
+            if (jsonData1.value("dataType", "") == "s")
             {
-                conditionSuccess = false;
+                eventClass += ": " + jsonData1["data"].get<std::string>();
                 break;
             }
         }
+        eventClass = jsonData.value("selClass", eventClass);
+
+        // every event still goes to the journal
+        nlohmann::json value(state);
+        log<level::INFO>(("SEL event " + eventClass + " " + value.dump())
+                             .c_str());
+        auto record = [this, jsonData, propertyName,
+                       state](const SelAggregate* aggregate) mutable {
+            callActionBlock<T>(jsonData, propertyName, state, aggregate);
+        };
+        if (!selAggregator->event(eventClass, std::move(record), value,
+                                  sel::Clock::now()))
+        {
+            startSelTimer();
+            return;
+        }
+    }
+
+    bool success = callActionBlock<T>(jsonData, propertyName, state, nullptr);
+    if (setKey)
+    {
+        if (success)
+        {
+            rememberSetValue(*setKey, setValue);
+        }
+        else
+        {
+            lastSetValues.erase(*setKey);
+        }
     }
-    return conditionSuccess;
 }
+
 template <typename T>
-void PowerManager::executeActionBlock(nlohmann::json jsonData,
-                                      std::string propertyName, T& state)
+bool PowerManager::callActionBlock(const nlohmann::json& jsonData,
+                                   const std::string& propertyName, T& state,
+                                   const SelAggregate* aggregate)
 {
     const std::string actionObj = jsonData["serviceName"];
     const std::string actionPath = jsonData["objectpath"];
@@ -998,6 +2932,7 @@ void PowerManager::executeActionBlock(nlohmann::json jsonData,
                                          actionInterface.c_str(),
                                          actionMethod.c_str());
 
+    bool summarized = false;
     for (const auto& jsonData1 : jsonData["appendData"])
     {
         if (jsonData1["data"] == "PropertyValue")
@@ -1012,7 +2947,18 @@ void PowerManager::executeActionBlock(nlohmann::json jsonData,
             {
                 key = jsonData1["key"];
             }
-            oemKeyHandler(methodObj, propertyName, key);
+            oemKeyHandler(methodObj, propertyName, key, aggregate);
+        }
+        else if (aggregate && !summarized &&
+                 jsonData1.value("dataType", "") == "s")
+        {
+            // the message of an aggregated record carries the events count
+            // and the first and last values
+            methodObj.append(jsonData1["data"].get<std::string>() + " (" +
+                             std::to_string(aggregate->count) +
+                             " events, first " + aggregate->first.dump() +
+                             ", last " + aggregate->last.dump() + ")");
+            summarized = true;
         }
         else
         {
@@ -1022,6 +2968,7 @@ void PowerManager::executeActionBlock(nlohmann::json jsonData,
     try
     {
         auto res = bus.call(methodObj);
+        return true;
     }
     catch (sdbusplus::exception_t& e)
     {
@@ -1051,51 +2998,79 @@ void PowerManager::executeActionBlock(nlohmann::json jsonData,
                 phosphor::logging::entry("EXCEPTION=%s", e.what()));
         }
     }
+    return false;
 }
-void PowerManager::EventTriggered(sdbusplus::message::message& msg)
+
+void PowerManager::createSelAggregation()
 {
-    try
+    if (!JsonConfigData.contains("selAggregation") ||
+        !JsonConfigData["selAggregation"].value("enabled", false))
     {
-        bool state = 0;
-        std::string msgInterface;
-        std::map<std::string, std::variant<bool, std::string>> msgData;
-        msg.read(msgInterface, msgData);
+        return;
+    }
+    const auto& selJson = JsonConfigData["selAggregation"];
+    sel::SelPolicy policy;
+    policy.window =
+        std::chrono::milliseconds(selJson.value("windowMs", 10000U));
+    policy.maxRecords = selJson.value("maxRecords", 0U);
+    policy.ratePeriod =
+        std::chrono::seconds(selJson.value("ratePeriodSeconds", 3600U));
+    selAggregator.emplace(policy);
+    selMethods = selJson.value(
+        "methods", std::set<std::string>{"IpmiSelAdd", "IpmiSelAddOem"});
+    selTimer = std::make_unique<boost::asio::steady_timer>(io);
+}
 
-        for (const auto& jsonData0 : JsonConfigData["PowerRedundancyConfigs"])
+void PowerManager::startSelTimer()
+{
+    auto next = selAggregator->nextDeadline();
+    if (!next)
+    {
+        return;
+    }
+    selTimer->expires_at(*next);
+    selTimer->async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        for (auto& [record, aggregate] :
+             selAggregator->due(sel::Clock::now()))
+        {
+            record(&aggregate);
+        }
+        startSelTimer();
+    });
+}
+
+void PowerManager::EventTriggered(const nlohmann::json& rule,
+                                  const Value* value)
+{
+    try
+    {
+        auto state = value ? std::get_if<bool>(value) : nullptr;
+        if (!state || !rule.contains("action"))
         {
-            if (jsonData0["objectName"] == msg.get_path())
+            return;
+        }
+        for (const auto& jsonData1 : rule["action"])
+        {
+            if (!jsonData1.contains("trigger") ||
+                jsonData1["trigger"] == *state)
             {
-                auto valPropMap = msgData.find(jsonData0["propertyName"]);
-                if (valPropMap != msgData.end())
+                if (jsonData1.contains("conditionBlock"))
                 {
-                    state = std::get<bool>(valPropMap->second);
-                    if (jsonData0.contains("action"))
+                    auto conditionSuccess = true;
+                    conditionSuccess = executeConditionBlock(jsonData1);
+                    if (conditionSuccess == false)
                     {
-                        for (const auto& jsonData1 : jsonData0["action"])
-                        {
-                            if (!jsonData1.contains("trigger") ||
-                                jsonData1["trigger"] == state)
-                            {
-                                if (jsonData1.contains("conditionBlock"))
-                                {
-                                    auto conditionSuccess = true;
-                                    conditionSuccess =
-                                        executeConditionBlock(jsonData1);
-                                    if (conditionSuccess == false)
-                                    {
-                                        continue;
-                                    }
-                                }
-                                std::string propertyName =
-                                    jsonData0["propertyName"];
-                                uint32_t triggeredState =
-                                    static_cast<uint32_t>(state);
-                                executeActionBlock<uint32_t>(
-                                    jsonData1, propertyName, triggeredState);
-                            }
-                        }
+                        continue;
                     }
                 }
+                std::string propertyName = rule["propertyName"];
+                uint32_t triggeredState = static_cast<uint32_t>(*state);
+                executeActionBlock<uint32_t>(jsonData1, propertyName,
+                                             triggeredState);
             }
         }
     }
@@ -1162,11 +3137,28 @@ void PowerManager::updatePowerModePropertyValue(uint8_t mode)
 }
 
 void PowerManager::oemKeyHandler(sdbusplus::message::message& methodObj,
-                                 std::string propertyName, std::string key)
+                                 std::string propertyName, std::string key,
+                                 const SelAggregate* aggregate)
 {
     try
     {
-        if (propertyName == "PowerCap" && key == "AddSel")
+        if (propertyName == "PowerCap" && key == "AddSel" && aggregate &&
+            aggregate->first.is_number_unsigned() &&
+            aggregate->last.is_number_unsigned())
+        {
+            // aggregated record: first and last limits and the events count
+            auto first = aggregate->first.get<uint32_t>();
+            auto last = aggregate->last.get<uint32_t>();
+            std::vector<std::uint8_t> data;
+            data.push_back(03);
+            data.push_back(first & 0xFF);
+            data.push_back((first >> 8) & 0xFF);
+            data.push_back(last & 0xFF);
+            data.push_back((last >> 8) & 0xFF);
+            data.push_back(std::min<uint32_t>(aggregate->count, 0xFF));
+            methodObj.append(data);
+        }
+        else if (propertyName == "PowerCap" && key == "AddSel")
         {
             std::vector<std::uint8_t> data;
             data.push_back(02);
@@ -1268,6 +3260,7 @@ void PowerManager::PropertyTriggered(
         util::dumpPowerCapIntoFile(
             powerCapBinPath.c_str(),
             reinterpret_cast<uint8_t*>(&powerCappingInfo), fileLen);
+        publishSnapshot();
     }
     catch (const std::exception& e)
     {
@@ -1275,19 +3268,31 @@ void PowerManager::PropertyTriggered(
     }
 }
 
-void PowerManager::powerStateTriggered(sdbusplus::message::message& msg)
+void PowerManager::powerStateTriggered(const Value* value)
 {
     try
     {
-        std::string msgInterface;
         std::string state;
-        std::map<std::string, std::variant<uint32_t, std::string>> msgData;
-        msg.read(msgInterface, msgData);
-        auto valPropMap =
-            msgData.find(JsonConfigData["powerState"]["propertyName"]);
-        if (valPropMap != msgData.end())
+        if (value)
         {
-            state = std::get<std::string>(valPropMap->second);
+            state = std::get<std::string>(*value);
+            if (stagingInterface)
+            {
+                if (state == "xyz.openbmc_project.State.Chassis.PowerState."
+                             "TransitioningToOn")
+                {
+                    // once per power on, a Stage call may have run it
+                    if (!stagedForPowerOn)
+                    {
+                        stagePowerOnCaps();
+                    }
+                }
+                else if (state ==
+                         "xyz.openbmc_project.State.Chassis.PowerState.Off")
+                {
+                    stagedForPowerOn = false;
+                }
+            }
             if (JsonConfigData["powerState"].contains("action"))
             {
                 for (const auto& jsonData0 :
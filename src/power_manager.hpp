@@ -16,7 +16,26 @@
  */
 
 #pragma once
+#include "cap_broker.hpp"
+#include "cap_reconciler.hpp"
+#include "cap_ramp.hpp"
+#include "power_allocation.hpp"
+#include "power_cap_snapshot.hpp"
+#include "power_history.hpp"
 #include "power_manager_property.hpp"
+#include "power_sharing.hpp"
+#include "rest_estimator.hpp"
+#include "sel_aggregator.hpp"
+#include "signal_router.hpp"
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <set>
+#include <tuple>
 using namespace phosphor::logging;
 
 namespace nvidia::power::manager
@@ -42,6 +61,171 @@ using Value =
                  std::vector<int64_t>, std::vector<uint64_t>,
                  std::vector<double>, std::vector<std::string>>;
 
+/**
+ * @brief Module PowerCap property driven by the power capping algorithm,
+ * resolved once at start up so that cap updates do not walk the json
+ * configuration.
+ */
+struct ModuleCapTarget
+{
+    std::string module;
+    int percentage;
+    int numOfDevices;
+    property::Property* propObj;
+    /** @brief MinPowerCapValue and MaxPowerCapValue of the module, nullptr
+     * if not configured */
+    property::Property* minPropObj;
+    property::Property* maxPropObj;
+    /** @brief cap computed from the operator chassis limit */
+    uint32_t operatorCap;
+    /** @brief power sensor of the module, empty if the module does not take
+     * part in the dynamic power sharing */
+    std::string powerSensorPath;
+    uint32_t shareFloor;
+    uint32_t shareCeiling;
+    /** @brief cap moved by the dynamic power sharing, starts at operatorCap
+     * whenever the operator limit changes */
+    uint32_t sharedCap;
+};
+
+/**
+ * @brief Precomputed module caps applied when the number of healthy PSUs
+ * drops, indexed like PowerManager::moduleCapTargets.
+ */
+struct EmergencyCapEntry
+{
+    uint32_t healthyPsus;
+    uint32_t chassisPowerLimit;
+    std::vector<uint32_t> moduleCaps;
+};
+
+/**
+ * @brief PSU drop event watched by the emergency capping fast path
+ */
+struct EmergencyEvent
+{
+    std::string propertyName;
+    uint32_t healthyPsus;
+};
+
+/**
+ * @brief Target of a Set action block: service, path, interface and property
+ */
+using ActionSetKey =
+    std::tuple<std::string, std::string, std::string, std::string>;
+
+/**
+ * @class SignalRouter
+ *
+ * Watches the PropertiesChanged signals with one bus match per interface and
+ * routes the changes to the subscribers of each property.
+ */
+class SignalRouter
+{
+  public:
+    using Handler = signal::SignalTable<Value>::Handler;
+
+    SignalRouter(sdbusplus::bus::bus& bus, boost::asio::io_service& io) :
+        bus(bus), io(io)
+    {}
+
+    /**
+     * @brief Subscribe to the changes of a property, the match of the
+     * interface is added or widened when needed
+     *
+     * @param[in] path - object path
+     * @param[in] interface - interface of the property
+     * @param[in] property - property name
+     * @param[in] handler - called with the new value, or nullptr when the
+     * signal could not be decoded
+     * @param[in] priority - urgent handlers run before the others of the
+     * same signal, whichever chassis subscribed them first
+     */
+    void subscribe(const std::string& path, const std::string& interface,
+                   const std::string& property, Handler handler,
+                   signal::Priority priority = signal::Priority::Normal);
+
+    /** @brief number of match rules registered with the bus */
+    size_t matchCount() const
+    {
+        return matches.size();
+    }
+
+  private:
+    /** @brief Callback of all the matches */
+    void route(sdbusplus::message::message& msg);
+
+    /** @brief Register the match of an interface group, replacing the
+     * previous one */
+    void updateMatch(const std::string& interface);
+
+    sdbusplus::bus::bus& bus;
+
+    boost::asio::io_service& io;
+
+    /** @brief True while a signal is routed, a match can not be replaced
+     * from its own callback */
+    bool routing = false;
+
+    /** @brief interface groups whose match must be replaced */
+    std::set<std::string> staleMatches;
+
+    signal::SignalTable<Value> table;
+
+    /** @brief match of each interface group */
+    std::map<std::string, std::unique_ptr<sdbusplus::bus::match_t>> matches;
+};
+
+/**
+ * @brief Resources shared by the PowerManager instances of all the chassis
+ * served by the daemon
+ */
+struct SharedResources
+{
+    SharedResources(sdbusplus::bus::bus& bus, boost::asio::io_service& io,
+                    std::shared_ptr<sdbusplus::asio::connection> conn) :
+        router(bus, io),
+        conn(std::move(conn))
+    {}
+
+    /** @brief PropertiesChanged subscriptions of all chassis */
+    SignalRouter router;
+
+    /** @brief ObjectManagers keyed by path, registered once for all chassis */
+    std::map<std::string,
+             std::unique_ptr<sdbusplus::server::manager::manager>>
+        objManagers;
+
+    /** @brief system chassis found by the mapper, looked up once */
+    std::optional<std::string> systemChassisPath;
+
+    /** @brief connection of the event loop, used by the periodic reads so
+     * that they do not block it */
+    std::shared_ptr<sdbusplus::asio::connection> conn;
+};
+
+/**
+ * @brief Configuration of one chassis
+ */
+struct ChassisConfig
+{
+    /** @brief empty for a single chassis configuration */
+    std::string name;
+    nlohmann::json config;
+};
+
+/**
+ * @brief Split the power manager configuration into the chassis configurations
+ *
+ * A configuration without a "chassis" array describes a single chassis.
+ * Otherwise every entry of the array is a chassis configuration, keys outside
+ * of the array are defaults for all of them.
+ *
+ * @param[in] config - the parsed powermanager.json
+ * @return the configuration of each chassis
+ */
+std::vector<ChassisConfig> getChassisConfigs(const nlohmann::json& config);
+
 /**
  * @class PowerManager
  *
@@ -60,15 +244,20 @@ class PowerManager
     PowerManager& operator=(PowerManager&&) = delete;
 
     /**
-     * Constructor to read the configuration file and create the Power capping
-     * properties and register watch call back functions for any changes in the
-     * PSU sensors and power Capping property state changes.
+     * Constructor to create the Power capping properties of a chassis and
+     * register watch call back functions for any changes in the PSU sensors
+     * and power Capping property state changes.
      *
      * @param[in] bus - D-Bus bus object
      * @param[in] objectServer - event object
+     * @param[in] io - io service running the periodic tasks
+     * @param[in] shared - resources shared with the other chassis
+     * @param[in] chassis - configuration of the chassis
      */
     PowerManager(sdbusplus::bus::bus& bus,
-                 sdbusplus::asio::object_server& objectServer);
+                 sdbusplus::asio::object_server& objectServer,
+                 boost::asio::io_service& io, SharedResources& shared,
+                 const ChassisConfig& chassis);
 
   private:
     /**
@@ -83,8 +272,23 @@ class PowerManager
 
     sdbusplus::asio::object_server& objServer;
 
+    boost::asio::io_service& io;
+
+    SharedResources& shared;
+
+    /** @brief chassis name, empty for a single chassis configuration */
+    std::string chassisName;
+
+    /** @brief object path of the com.Nvidia.Powermanager interfaces of the
+     * chassis */
+    std::string managerObjPath;
+
     uint32_t curentPowerLimit;
 
+    /** @brief Chassis limit the module caps are allocated from, the limit of
+     * the power mode lowered by the winning broker request */
+    uint32_t enforcedPowerLimit = 0;
+
     std::string chassisObjectPath;
 
     /** @brief True if the power is on. */
@@ -101,24 +305,28 @@ class PowerManager
     void getDataForAppend(nlohmann::json dataJson,
                           sdbusplus::message::message& methodObj);
 
-    /** @brief Used to subscribe to D-Bus events and property state changes */
-    std::vector<std::unique_ptr<sdbusplus::bus::match_t>> matchEvent;
-
     /** @brief Used to create Property objects to register Power Capping
      * Properties */
     std::vector<std::unique_ptr<property::Property>> propertyObjs;
 
     std::vector<std::unique_ptr<property::areaObject>> areaObjs;
 
-    /** @brief Used to subscribe to D-Bus power state changes */
-    std::unique_ptr<sdbusplus::bus::match_t> currentPowerState;
+    /** @brief Register ObjectManagers on the power control path and on the
+     * parent of any configured object outside of it, before the capping
+     * objects so that InterfacesAdded is emitted for them */
+    void createObjectManagers();
 
     /** @brief Used to store Dbus interface objects Power Capping Properties */
     std::vector<std::shared_ptr<sdbusplus::asio::dbus_interface>>
         enabledInterface;
 
+    /** @brief The chassis the power control objects are associated with,
+     * chassisObjectPath from the configuration or the system chassis */
     std::string getSystemChassisObjectPath();
 
+    /** @brief Look up the chassis implementing the Item.System interface */
+    static std::string findSystemChassisObjectPath(sdbusplus::bus::bus& bus);
+
     /** @brief Used to update Global Power Capping Properties structure from the
      * power manager configuration
      *
@@ -132,6 +340,10 @@ class PowerManager
      * manager configuration*/
     void updatePowerCappingLimit(bool emitsChange);
 
+    /** @brief Allocate the enforced chassis limit to the operatorCap of the
+     * modules */
+    void allocateOperatorCaps();
+
     void updatePowerModePropertyValue(uint8_t mode);
 
     /** @brief Used to update PowerCap property based on Mode
@@ -144,6 +356,23 @@ class PowerManager
     void executeActionBlock(nlohmann::json jsonData, std::string propertyName,
                             T& state);
 
+    /** @brief SEL events collapsed into one record */
+    using SelAggregate = sel::Aggregate<nlohmann::json>;
+
+    /** @brief Build and call the method of an action block
+     *
+     * @param[in] jsonData - Json data containing Action block parameters
+     * @param[in] propertyName - property name which triggered the action block
+     * @param[in] state - value which triggered the action block
+     * @param[in] aggregate - events collapsed into this SEL record, nullptr
+     * for a single event
+     * @return true if the call succeeded
+     */
+    template <typename T>
+    bool callActionBlock(const nlohmann::json& jsonData,
+                         const std::string& propertyName, T& state,
+                         const SelAggregate* aggregate);
+
     /** @brief Used to update PowerCap property based on Mode
      *
      * @param[in] jsonData - Json data containing Condition block parameters
@@ -159,9 +388,10 @@ class PowerManager
      * when the function call back is called it go through the json data and
      * perform the Action blocks defined in the powermanager.json
      *
-     * @param[in] msg - Data associated with the state signal
+     * @param[in] rule - PowerRedundancyConfigs entry of the sensor
+     * @param[in] value - new value of the sensor property
      */
-    void EventTriggered(sdbusplus::message::message& msg);
+    void EventTriggered(const nlohmann::json& rule, const Value* value);
 
     /**
      * @brief Callback for power capping properties state changes
@@ -189,9 +419,9 @@ class PowerManager
      * when the function call back is called it go through the json data and
      * perform the Action blocks defined in the powermanager.json
      *
-     * @param[in] msg - Data associated with the state signal
+     * @param[in] value - new value of the power state property
      */
-    void powerStateTriggered(sdbusplus::message::message& msg);
+    void powerStateTriggered(const Value* value);
 
     /** @brief Used to update PowerCap property based on Mode
      *
@@ -203,7 +433,8 @@ class PowerManager
     /** @brief Handler to add OEM specific Parameters to the Dbus Method Calls
      * of action/conditon Blocks */
     void oemKeyHandler(sdbusplus::message::message& methodObj,
-                       std::string propertyName, std::string key);
+                       std::string propertyName, std::string key,
+                       const SelAggregate* aggregate = nullptr);
 
     /** @brief Used to Calculate the checksum of data buffer
      *
@@ -226,8 +457,531 @@ class PowerManager
     /** @brief Triggers Emit change on Property */
     void triggerSystemPowerCapSignal();
 
+    /** @brief Module PowerCap properties updated by the capping algorithm */
+    std::vector<ModuleCapTarget> moduleCapTargets;
+
+    /** @brief Emergency cap table keyed by the number of healthy PSUs */
+    std::map<uint32_t, EmergencyCapEntry> emergencyCapTable;
+
+    /** @brief PSU drop events keyed by the event object path */
+    std::map<std::string, EmergencyEvent> emergencyEvents;
+
+    /** @brief PSU drop events currently asserted */
+    std::set<std::string> assertedEmergencyEvents;
+
+    /** @brief Emergency cap entry in effect, nullptr when redundant */
+    const EmergencyCapEntry* activeEmergencyCap = nullptr;
+
+    /** @brief Used to publish the emergency capping state */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> emergencyInterface;
+
+    uint64_t maxClampLatencyUsec = 0;
+
+    uint32_t clampCount = 0;
+
+    /** @brief Chassis limit of a power mode
+     *
+     * @param[in] mode - power mode
+     * @param[in] oemLimit - chassis limit used in the OEM mode
+     * @return the limit, the current one in the Static mode
+     */
+    uint32_t modeLimit(uint8_t mode, uint32_t oemLimit);
+
+    /** @brief Share of each module of moduleCapTargets, with the cap ranges
+     * currently configured */
+    void fillModuleShares(std::vector<allocation::ModuleShare>& shares);
+
+    /** @brief Object reporting the cap applied to a module */
+    struct ReconcileTarget
+    {
+        /** @brief index in moduleCapTargets */
+        size_t module;
+        /** @brief service, object, interface and property reporting the
+         * cap */
+        ActionSetKey key;
+        /** @brief Set action block of the module PowerCap writing the
+         * reported property, nullptr if the cap is only signalled */
+        const nlohmann::json* setAction;
+    };
+
+    std::vector<ReconcileTarget> reconcileTargets;
+
+    /** @brief Targets read with one call */
+    struct ReconcileRead
+    {
+        std::string service;
+        /** @brief ObjectManager path, or object path with interface set */
+        std::string path;
+        /** @brief interface read with GetAll, empty for GetManagedObjects */
+        std::string interface;
+        /** @brief indexes in reconcileTargets */
+        std::vector<size_t> targets;
+        /** @brief the last read failed, logged once */
+        bool failing = false;
+    };
+
+    std::vector<ReconcileRead> reconcileReads;
+
+    std::optional<reconcile::CapReconciler> capReconciler;
+
+    std::chrono::milliseconds reconcilePeriod{1000};
+
+    uint64_t reconcileReadErrors = 0;
+
+    std::unique_ptr<boost::asio::steady_timer> reconcileTimer;
+
+    /** @brief Used to publish the drift counters */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> reconcileInterface;
+
+    /** @brief Register the cap reconciliation if configured */
+    void createCapReconciliation();
+
+    /** @brief Schedule the next reconciliation cycle */
+    void startReconcileTimer();
+
+    /** @brief Read the caps reported by the targets without blocking the
+     * event loop, one call per ObjectManager or object, push the ones which
+     * drifted and schedule the next cycle once all reads answered */
+    void reconcileCaps();
+
+    /** @brief Account the result of a read of reconcileReads
+     *
+     * @param[in] read - index in reconcileReads
+     * @param[in] ec - error of the read
+     * @return true if the read succeeded and its targets can be checked
+     */
+    bool reconcileReadDone(size_t read, const boost::system::error_code& ec);
+
+    /** @brief Compare the cap reported by a target with the cap of its
+     * module, pushing it when it drifted
+     *
+     * @param[in] index - index in reconcileTargets
+     * @param[in] value - reported cap, nullptr if it could not be read
+     * @param[in] now - start of the cycle
+     */
+    void reconcileCap(size_t index, const Value* value,
+                      reconcile::Clock::time_point now);
+
+    /** @brief Push the cap of a module to a target reporting another one
+     *
+     * @param[in] target - target which drifted
+     * @param[in] cap - cap of the module
+     */
+    void pushReconciledCap(const ReconcileTarget& target, uint32_t cap);
+
+    /** @brief Live rest of system power estimation, nullopt when disabled */
+    std::optional<rest::RestEstimator> restEstimator;
+
+    std::string restChassisSensorPath;
+
+    /** @brief Power sensor of each module, indexed like moduleCapTargets */
+    std::vector<std::string> restModuleSensorPaths;
+
+    std::chrono::milliseconds restPeriod{1000};
+
+    std::chrono::steady_clock::time_point lastRestSample;
+
+    /** @brief Change of the estimate reallocating the module caps */
+    uint32_t restHysteresis = 25;
+
+    bool restFeedsAllocation = false;
+
+    /** @brief Rest of system power the module caps are allocated with,
+     * nullopt to split the chassis limit by percentages */
+    std::optional<uint32_t> appliedRestOfSystemPower;
+
+    std::unique_ptr<boost::asio::steady_timer> restTimer;
+
+    /** @brief Used to publish the rest of system estimate */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> restInterface;
+
+    /** @brief Register the rest of system estimation if configured */
+    void createRestOfSystemEstimation();
+
+    /** @brief Schedule the next rest of system sample */
+    void startRestTimer();
+
+    /** @brief Read the chassis and module power, then update the estimate
+     * and schedule the next sample */
+    void sampleRestOfSystem();
+
+    /** @brief Update the estimate and reallocate the module caps when it
+     * moved by more than the hysteresis
+     *
+     * @param[in] chassis - chassis power, NaN if unknown
+     * @param[in] modules - power of all modules, NaN if unknown
+     * @param[in] seconds - time since the previous sample
+     */
+    void updateRestOfSystem(double chassis, double modules, double seconds);
+
+    /** @brief Reallocate the module caps for a new rest of system power,
+     * the shared caps are kept and only lowered as far as the smaller
+     * budget requires */
+    void updateRestOfSystemPower();
+
+    /** @brief Storage reused by each allocation */
+    std::vector<allocation::ModuleShare> allocationShares;
+    std::vector<uint32_t> allocationCaps;
+    std::vector<allocation::Violation> allocationViolations;
+
+    /** @brief Used to take the allocation previews */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> previewInterface;
+
+    /** @brief Register the allocation preview D-Bus interface */
+    void createAllocationPreview();
+
+    /** @brief Module caps a hypothetical input would give, nothing is
+     * applied, persisted or signalled
+     *
+     * @param[in] mode - power mode, empty for the current one
+     * @param[in] oemLimit - chassis limit of the OEM mode, 0 for the current
+     * one
+     * @param[in] percentages - percentage of a module replacing the
+     * configured one, keyed by module name
+     * @return the chassis limit, the cap of a device of each module in
+     * moduleCapTargets order and the violated ranges
+     */
+    std::tuple<uint32_t, std::vector<uint32_t>, std::vector<std::string>>
+        previewAllocation(const std::string& mode, uint32_t oemLimit,
+                          const std::map<std::string, int32_t>& percentages);
+
+    /** @brief Resolve the module PowerCap properties used by the capping
+     * algorithm */
+    void createModuleCapTargets();
+
+    /** @brief Precompute the module caps for each configured PSU drop event
+     * and register the D-Bus interface publishing the clamp state
+     *
+     * @throw std::invalid_argument if two events have the same object or
+     * the same number of healthy PSUs
+     */
+    void createEmergencyCapTable();
+
+    /** @brief Compute the module caps of each emergency entry from its
+     * chassis limit, less the applied rest of system power when the
+     * estimate feeds the allocation */
+    void updateEmergencyCaps();
+
+    /** @brief Read the state of the PSU drop events once and clamp the caps
+     * if one is already asserted */
+    void readEmergencyEvents();
+
+    /** @brief Apply the operator caps, clamped by the active emergency entry,
+     * to the module PowerCap properties, through the ramp if configured
+     *
+     * @param[in] emitsChange - emits change signal boolean value
+     */
+    void applyModuleCaps(bool emitsChange);
+
+    /** @brief Fast path for PSU drop events, applies the precomputed caps
+     * before any configured action block is executed
+     *
+     * @param[in] path - object path of the event
+     * @param[in] asserted - event state
+     * @param[in] received - time the signal was dispatched
+     */
+    void handleEmergencyEvent(
+        const std::string& path, bool asserted,
+        std::chrono::steady_clock::time_point received);
+
+    /** @brief Slew rate limited ramp of the module caps, nullopt when the
+     * caps are applied at once */
+    std::optional<ramp::CapRamp> capRamp;
+
+    /** @brief Interval the caps are stepped at while ramping */
+    std::chrono::milliseconds rampStep{100};
+
+    std::unique_ptr<boost::asio::steady_timer> rampTimer;
+
+    bool rampTimerArmed = false;
+
+    /** @brief Used to publish the ramp targets and their ETA */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> rampInterface;
+
+    /** @brief Register the cap ramping if configured */
+    void createCapRamping();
+
+    /** @brief Ramp towards the given caps and keep stepping them until the
+     * targets are reached
+     *
+     * @param[in] targets - per device cap of each module
+     * @return the caps to apply now
+     */
+    std::vector<uint32_t> rampModuleCaps(const std::vector<uint32_t>& targets);
+
+    /** @brief Dynamic power sharing policy */
+    sharing::SharingPolicy sharingPolicy;
+
+    /** @brief Dynamic power sharing control period, zero when disabled */
+    std::chrono::milliseconds sharingPeriod{0};
+
+    std::unique_ptr<boost::asio::steady_timer> sharingTimer;
+
+    /** @brief Used to publish the dynamic power sharing state */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> sharingInterface;
+
+    uint32_t rebalanceCount = 0;
+
+    /** @brief Service names of the module power sensors */
+    std::map<std::string, std::string> sensorServices;
+
+    /** @brief Sensors whose last read failed, logged once until they are
+     * readable again */
+    std::set<std::string> failingSensors;
+
+    /** @brief Failed reads of the power sensors */
+    uint64_t sensorReadErrors = 0;
+
+    /** @brief Read the dynamicPowerSharing configuration, register its D-Bus
+     * interface and start the control period */
+    void createPowerSharing();
+
+    /** @brief Schedule the next dynamic power sharing control period */
+    void startSharingTimer();
+
+    /** @brief Dynamic power sharing control period, moves headroom to the
+     * modules running at their cap
+     *
+     * @param[in] modulePower - power of each module of moduleCapTargets, NaN
+     * if unknown or not shared
+     */
+    void sharePower(const std::vector<double>& modulePower);
+
+    /** @brief Read xyz.openbmc_project.Sensor.Value sensors without blocking
+     * the event loop, all reads are in flight together
+     *
+     * @param[in] paths - object paths of the sensors, empty to skip one
+     * @param[in] done - called from the event loop once all sensors
+     * answered, with their values in paths order, NaN for a sensor which
+     * could not be read or is not a valid power
+     */
+    void readSensors(const std::vector<std::string>& paths,
+                     std::function<void(const std::vector<double>&)> done);
+
+    /** @brief Read one sensor of readSensors, looking up its service first
+     * if not known yet
+     *
+     * @param[in] path - object path of the sensor
+     * @param[in] done - called with the value, NaN if invalid
+     */
+    void readSensor(const std::string& path, std::function<void(double)> done);
+
+    /** @brief Count a failed sensor read, logging it only when the sensor
+     * was readable before
+     *
+     * @param[in] path - object path of the sensor
+     * @param[in] reason - error of the read
+     */
+    void sensorReadFailed(const std::string& path, const std::string& reason);
+
+    /** @brief Compressed history of a chassis or module */
+    struct HistorySeries
+    {
+        /** @brief names of the columns, the last one is the measured power */
+        std::vector<std::string> columns;
+        /** @brief power sensor, the power is unknown if empty */
+        std::string powerSensorPath;
+        history::Series series;
+    };
+
+    /** @brief History of the chassis and of each module keyed by name */
+    std::map<std::string, HistorySeries> historySeries;
+
+    std::chrono::milliseconds historyPeriod{1000};
+
+    std::unique_ptr<boost::asio::steady_timer> historyTimer;
+
+    /** @brief Used to query the power history */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> historyInterface;
+
+    /** @brief Power sensor of a module
+     *
+     * @param[in] config - object with an optional modules array of
+     * powerModule and powerSensorPath
+     * @param[in] target - module
+     * @return the configured sensor, the dynamicPowerSharing one otherwise,
+     * empty if there is none
+     */
+    static std::string modulePowerSensor(const nlohmann::json& config,
+                                         const ModuleCapTarget& target);
+
+    /** @brief Register the power history if configured and start sampling */
+    void createPowerHistory();
+
+    /** @brief Schedule the next power history sample */
+    void startHistoryTimer();
+
+    /** @brief Read the power sensors, then append the current limit, caps
+     * and power to the history and schedule the next sample */
+    void sampleHistory();
+
+    /** @brief Downsampled history of a column
+     *
+     * @param[in] series - Chassis or a module name
+     * @param[in] column - column name
+     * @param[in] fromMs - start of the range, ms since the epoch
+     * @param[in] toMs - end of the range, ms since the epoch
+     * @param[in] bucketMs - span of a bucket, 0 for the raw samples
+     * @return start, min, max, average and sample count of each bucket
+     */
+    std::vector<std::tuple<uint64_t, double, double, double, uint32_t>>
+        queryHistory(const std::string& series, const std::string& column,
+                     uint64_t fromMs, uint64_t toMs, uint64_t bucketMs);
+
+    /** @brief Values last written successfully by Set action blocks */
+    std::map<ActionSetKey, nlohmann::json> lastSetValues;
+
+    /** @brief Set targets subscribed to, used to forget the written values
+     * changed by someone else */
+    std::set<ActionSetKey> watchedSetTargets;
+
+    /** @brief Used to publish the action block statistics */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> actionStatsInterface;
+
+    uint64_t elidedSetCount = 0;
+
+    /** @brief Register the D-Bus interface publishing the action block
+     * statistics */
+    void createActionInterface();
+
+    /** @brief Get the target of a Set action block which may be elided
+     *
+     * @param[in] jsonData - Json data containing Action block parameters
+     * @return the target, nullopt for other methods or when the value is
+     * only known when the call is built
+     */
+    std::optional<ActionSetKey> getActionSetKey(const nlohmann::json& jsonData);
+
+    /** @brief Remember a value written by a Set action block and watch the
+     * target for changes made by someone else
+     *
+     * @param[in] key - target of the Set
+     * @param[in] value - value written
+     */
+    void rememberSetValue(const ActionSetKey& key, const nlohmann::json& value);
+
+    /** @brief Callback for property changes of a Set target, forgets the
+     * written values which no longer hold
+     *
+     * @param[in] key - target of the Set
+     * @param[in] value - new value of the target, nullptr if unknown
+     */
+    void setTargetChanged(const ActionSetKey& key, const Value* value);
+
+    /** @brief Cap requests of the clients of the broker */
+    broker::CapBroker capBroker;
+
+    /** @brief Used to publish the broker requests and take new ones */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> brokerInterface;
+
+    /** @brief Expires the broker leases */
+    std::unique_ptr<boost::asio::steady_timer> leaseTimer;
+
+    /** @brief Longest lease granted by the broker */
+    std::chrono::seconds maxLease{0};
+
+    /** @brief Register the cap broker interface if configured */
+    void createCapBroker();
+
+    /** @brief Add or replace the cap request of a broker client
+     *
+     * @param[in] owner - id of the client
+     * @param[in] cap - requested chassis power cap in watts
+     * @param[in] priority - tie break between requests of the same cap
+     * @param[in] leaseSeconds - lifetime of the request
+     * @return the enforced chassis power cap
+     */
+    uint32_t requestCap(const std::string& owner, uint32_t cap,
+                        uint8_t priority, uint32_t leaseSeconds);
+
+    /** @brief Publish the winning request and reallocate the module caps
+     * when the enforced chassis limit changes */
+    void updateBrokerCap();
+
+    /** @brief Chassis limit lowered by the winning broker request
+     *
+     * @param[in] chassisLimit - limit of the power mode
+     * @return the lower of the limit and the winning cap
+     */
+    uint32_t brokerLimit(uint32_t chassisLimit) const;
+
+    /** @brief Arm the lease timer for the next expiry */
+    void startLeaseTimer();
+
+    /** @brief Aggregates the SEL action blocks, unset when disabled */
+    std::optional<sel::SelAggregator<std::function<void(const SelAggregate*)>,
+                                     nlohmann::json>>
+        selAggregator;
+
+    /** @brief Methods of the action blocks adding SEL records */
+    std::set<std::string> selMethods;
+
+    /** @brief Emits the aggregated SEL records */
+    std::unique_ptr<boost::asio::steady_timer> selTimer;
+
+    /** @brief Set up the SEL aggregation if configured */
+    void createSelAggregation();
+
+    /** @brief Arm the SEL timer for the next aggregated record */
+    void startSelTimer();
+
+    /** @brief Module of each object acknowledging the staged caps, indexed
+     * like the powerOnStaging acknowledgements */
+    std::vector<size_t> stagingAckTargets;
+
+    /** @brief Acknowledgements still awaited by the current staging */
+    std::set<size_t> pendingStagingAcks;
+
+    /** @brief Idle, Staging, Acknowledged or TimedOut */
+    std::string stagingState = "Idle";
+
+    /** @brief The caps were staged for the current power on, cleared when
+     * the chassis is off, TransitioningToOn only stages when unset */
+    bool stagedForPowerOn = false;
+
+    std::chrono::steady_clock::time_point stagingStart;
+
+    std::chrono::milliseconds stagingTimeout{0};
+
+    uint64_t maxAckLatencyUsec = 0;
+
+    uint64_t stagingTimeoutCount = 0;
+
+    /** @brief Used to publish the staging state and take Stage calls */
+    std::shared_ptr<sdbusplus::asio::dbus_interface> stagingInterface;
+
+    /** @brief Bounds the wait for the acknowledgements */
+    std::unique_ptr<boost::asio::steady_timer> stagingTimer;
+
+    /** @brief Register the power on staging if configured */
+    void createPowerOnStaging();
+
+    /** @brief Push the module caps ahead of a power on and wait for them to
+     * be acknowledged, nothing is done while a staging is in progress */
+    void stagePowerOnCaps();
+
+    /** @brief Callback for the property acknowledging a staged cap
+     *
+     * @param[in] ack - index of the acknowledgement
+     * @param[in] value - cap reported, nullptr if unknown
+     */
+    void stagingAckChanged(size_t ack, const Value* value);
+
+    /** @brief End the staging and publish the acknowledgement latency
+     *
+     * @param[in] acknowledged - false if the timeout expired
+     */
+    void finishStaging(bool acknowledged);
+
     /** @brief structure object which holds power capping information. */
     struct PowerCappingInfo powerCappingInfo;
+
+    /** @brief Used to share the power capping state with in-BMC readers */
+    std::unique_ptr<snapshot::SnapshotWriter> snapshotWriter;
+
+    /** @brief Publish powerCappingInfo and the module caps to the shared
+     * memory snapshot */
+    void publishSnapshot();
 };
 
 } // namespace nvidia::power::manager
@@ -31,23 +31,54 @@
  * limitations under the License.
  */
 #include "power_manager.hpp"
+#include "startup_profiler.hpp"
 using namespace nvidia::power;
+using nvidia::startup::startupProfiler;
 int main(void)
 {
     try
     {
         using namespace phosphor::logging;
 
+        auto connectPhase = startupProfiler().phase("connect");
         auto bus = sdbusplus::bus::new_default();
         auto event = sdeventplus::Event::get_default();
         bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
         boost::asio::io_service io;
         auto systemBus = std::make_shared<sdbusplus::asio::connection>(io);
+        connectPhase.stop();
 
+        auto namePhase = startupProfiler().phase("request-name");
         systemBus->request_name(BUSNAME);
+        namePhase.stop();
         sdbusplus::asio::object_server objectServer(systemBus);
 
-        manager::PowerManager manager(bus, objectServer);
+        auto jsonPhase = startupProfiler().phase("json-parse");
+        auto config = util::loadJSONFromFile(POWERMANAGER_JSON_PATH);
+        jsonPhase.stop();
+        if (config == nullptr)
+        {
+            log<level::ERR>("InternalFailure when parsing the JSON file");
+            return -EXIT_FAILURE;
+        }
+
+        // all the chassis share the bus connection, the bus name and the
+        // ObjectManagers
+        manager::SharedResources shared(bus, io, systemBus);
+        std::vector<std::unique_ptr<manager::PowerManager>> managers;
+        for (const auto& chassis : manager::getChassisConfigs(config))
+        {
+            managers.emplace_back(std::make_unique<manager::PowerManager>(
+                bus, objectServer, io, shared, chassis));
+        }
+
+        startupProfiler().ready();
+        startupProfiler().publish(bus, MANAGER_OBJ_PATH);
+        log<level::INFO>(startupProfiler().summary("nvidia-power-mgrd").c_str());
+        log<level::INFO>(
+            ("nvidia-power-mgrd: " +
+             std::to_string(shared.router.matchCount()) + " signal matches")
+                .c_str());
 
         return io.run();
     }
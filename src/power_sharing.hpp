@@ -0,0 +1,236 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Dynamic power sharing between the modules of the power capping algorithm.
+ *
+ * Every control period the per device power of each module is compared with
+ * its cap. Modules consuming well below their cap donate the unused headroom
+ * to the modules running at their cap. All caps stay within the configured
+ * floor and ceiling and the sum over all devices never exceeds the budget.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace nvidia::power::sharing
+{
+
+/** @brief Module taking part in the power sharing, values are per device in
+ * watts */
+struct ModuleShare
+{
+    uint32_t devices;
+    uint32_t floor;
+    uint32_t ceiling;
+    /** @brief cap currently applied, updated by rebalance() */
+    uint32_t cap;
+};
+
+struct SharingPolicy
+{
+    /** @brief headroom left above the consumption of a donor module, a
+     * module within half of it from its cap is considered saturated */
+    uint32_t headroom = 20;
+    /** @brief largest change of a cap in one control period, 0 for none */
+    uint32_t maxStep = 0;
+};
+
+namespace detail
+{
+
+/** @brief Raise the caps towards level, splitting the remaining budget in
+ * proportion to the missing watts when it is not enough for all */
+inline void fill(const std::vector<ModuleShare>& modules,
+                 std::vector<uint32_t>& caps,
+                 const std::vector<uint32_t>& level, uint64_t& remaining)
+{
+    uint64_t missing = 0;
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        if (level[i] > caps[i])
+        {
+            missing += uint64_t{level[i] - caps[i]} * modules[i].devices;
+        }
+    }
+    if (missing == 0)
+    {
+        return;
+    }
+    uint64_t pool = remaining;
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        if (level[i] <= caps[i])
+        {
+            continue;
+        }
+        uint64_t want = uint64_t{level[i] - caps[i]} * modules[i].devices;
+        uint64_t grant = missing <= pool ? want : want * pool / missing;
+        uint32_t perDevice = grant / modules[i].devices;
+        caps[i] += perDevice;
+        remaining -= uint64_t{perDevice} * modules[i].devices;
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Caps the modules converge to for the given consumption
+ *
+ * The budget is handed out in tiers, every tier is only served once the
+ * previous one is complete: the floors, the consumption plus headroom of the
+ * donors, the ceilings of the saturated modules, then the ceilings of all
+ * modules.
+ *
+ * @param[in] modules - modules with their current caps
+ * @param[in] power - per device power of each module
+ * @param[in] budget - watts available to all devices of all modules
+ * @param[in] policy - sharing policy
+ *
+ * @return per device cap of each module
+ */
+inline std::vector<uint32_t> targetCaps(const std::vector<ModuleShare>& modules,
+                                        const std::vector<uint32_t>& power,
+                                        uint64_t budget,
+                                        const SharingPolicy& policy)
+{
+    std::vector<uint32_t> caps(modules.size());
+    uint64_t floors = 0;
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        caps[i] = modules[i].floor;
+        floors += uint64_t{modules[i].floor} * modules[i].devices;
+    }
+    if (floors > budget)
+    {
+        // the floors can not be honoured, scale them down to the budget
+        for (size_t i = 0; i < modules.size(); i++)
+        {
+            caps[i] = uint64_t{modules[i].floor} * budget / floors;
+        }
+        return caps;
+    }
+    uint64_t remaining = budget - floors;
+
+    // the consumption of a saturated module is limited by its cap and says
+    // nothing about its demand, it competes for the budget left by the donors
+    // with its full range so that the split does not depend on the caps
+    std::vector<bool> saturated(modules.size());
+    std::vector<uint32_t> donors(modules.size());
+    std::vector<uint32_t> ceilings(modules.size());
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        const auto& module = modules[i];
+        saturated[i] = power[i] + policy.headroom / 2 >= module.cap;
+        donors[i] = saturated[i] ? module.floor
+                                 : std::clamp(power[i] + policy.headroom,
+                                              module.floor, module.ceiling);
+        ceilings[i] = module.ceiling;
+    }
+    detail::fill(modules, caps, donors, remaining);
+    std::vector<uint32_t> receivers(caps);
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        if (saturated[i])
+        {
+            receivers[i] = modules[i].ceiling;
+        }
+    }
+    detail::fill(modules, caps, receivers, remaining);
+    detail::fill(modules, caps, ceilings, remaining);
+    return caps;
+}
+
+/**
+ * @brief Run one control period, moving the caps towards targetCaps()
+ *
+ * Caps are lowered before any cap is raised so that the budget also holds
+ * for the intermediate steps. With a constant consumption the caps settle in
+ * at most convergencePeriods() periods.
+ *
+ * @param[in,out] modules - modules, their caps are updated
+ * @param[in] power - per device power of each module
+ * @param[in] budget - watts available to all devices of all modules
+ * @param[in] policy - sharing policy
+ *
+ * @return true if any cap changed
+ */
+inline bool rebalance(std::vector<ModuleShare>& modules,
+                      const std::vector<uint32_t>& power, uint64_t budget,
+                      const SharingPolicy& policy)
+{
+    auto targets = targetCaps(modules, power, budget, policy);
+    uint32_t step = policy.maxStep ? policy.maxStep : UINT32_MAX;
+    bool changed = false;
+
+    uint64_t used = 0;
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        auto& module = modules[i];
+        if (targets[i] < module.cap)
+        {
+            module.cap -= std::min(module.cap - targets[i], step);
+            changed = true;
+        }
+        used += uint64_t{module.cap} * module.devices;
+    }
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        auto& module = modules[i];
+        if (targets[i] <= module.cap || used >= budget)
+        {
+            continue;
+        }
+        uint64_t available = (budget - used) / module.devices;
+        uint32_t raise = std::min<uint64_t>(
+            {uint64_t{targets[i] - module.cap}, step, available});
+        if (raise > 0)
+        {
+            module.cap += raise;
+            used += uint64_t{raise} * module.devices;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Upper bound of the control periods needed to settle once the
+ * consumption is constant
+ *
+ * Lowering the donors and raising the receivers take at most
+ * (ceiling - floor) / maxStep periods each. Every module changing from
+ * receiver to donor, once its cap overtakes its demand, restarts this.
+ */
+inline size_t convergencePeriods(const std::vector<ModuleShare>& modules,
+                                 const SharingPolicy& policy)
+{
+    uint32_t range = 0;
+    for (const auto& module : modules)
+    {
+        range = std::max(range, module.ceiling - module.floor);
+    }
+    size_t steps = policy.maxStep ? (range + policy.maxStep - 1) /
+                                        policy.maxStep
+                                  : 1;
+    return (modules.size() + 1) * 2 * steps + 1;
+}
+
+} // namespace nvidia::power::sharing
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Estimation of the power drawn by the rest of the system.
+ *
+ * The rest of the system is the chassis input power minus the power of the
+ * capped modules. The difference is filtered with a first order low pass
+ * whose time constant is short when the rest rises and long when it falls,
+ * so that the estimate follows a rise before the chassis limit is exceeded
+ * and ignores short dips. A margin is added on top of the filtered value.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+
+namespace nvidia::power::rest
+{
+
+struct EstimatorPolicy
+{
+    double riseTimeConstant = 1.0;
+    double fallTimeConstant = 30.0;
+    uint32_t marginWatts = 150;
+    /** @brief bounds of the estimate, margin included */
+    uint32_t minWatts = 0;
+    uint32_t maxWatts = 100000;
+    /** @brief consecutive invalid samples after which there is no estimate */
+    uint32_t staleSamples = 5;
+};
+
+/**
+ * @class RestEstimator
+ *
+ * Filtered rest of system power.
+ */
+class RestEstimator
+{
+  public:
+    explicit RestEstimator(const EstimatorPolicy& policy = EstimatorPolicy{}) :
+        policy(policy)
+    {}
+
+    /**
+     * @brief Account a sample
+     *
+     * @param[in] chassisWatts - chassis input power, NaN if unknown
+     * @param[in] modulesWatts - power of all capped modules, NaN if unknown
+     * @param[in] seconds - time since the previous sample
+     */
+    void update(double chassisWatts, double modulesWatts, double seconds)
+    {
+        double raw = chassisWatts - modulesWatts;
+        if (!std::isfinite(raw) || seconds <= 0)
+        {
+            invalid++;
+            return;
+        }
+        raw = std::max(raw, 0.0);
+        invalid = 0;
+        lastRaw = raw;
+        if (!initialized)
+        {
+            filtered = raw;
+            initialized = true;
+            return;
+        }
+        double tau = raw > filtered ? policy.riseTimeConstant
+                                    : policy.fallTimeConstant;
+        double alpha = tau > 0 ? 1 - std::exp(-seconds / tau) : 1.0;
+        filtered += alpha * (raw - filtered);
+    }
+
+    /** @brief filtered rest of system power plus the margin, nullopt before
+     * the first valid sample or once the samples are stale */
+    std::optional<uint32_t> estimate() const
+    {
+        if (!initialized || invalid >= policy.staleSamples)
+        {
+            return std::nullopt;
+        }
+        double watts = std::ceil(filtered) + policy.marginWatts;
+        return static_cast<uint32_t>(
+            std::clamp<double>(watts, policy.minWatts, policy.maxWatts));
+    }
+
+    /** @brief last unfiltered rest of system power */
+    double raw() const
+    {
+        return lastRaw;
+    }
+
+  private:
+    EstimatorPolicy policy;
+    double filtered = 0;
+    bool initialized = false;
+    double lastRaw = NAN;
+    uint32_t invalid = 0;
+};
+
+} // namespace nvidia::power::rest
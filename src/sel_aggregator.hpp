@@ -0,0 +1,206 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Aggregation of the SEL records emitted by the action blocks.
+ *
+ * The first event of a class is recorded right away and opens an aggregation
+ * window. The events of the same class arriving within the window are held
+ * and collapse into a single record carrying their count, first and last
+ * values once the window is over. Each class is also limited to a number of
+ * records per rate period, held events wait for the limit to allow a record.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nvidia::power::sel
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct SelPolicy
+{
+    /** @brief events of a class within this time of its last record are
+     * aggregated */
+    Clock::duration window = std::chrono::seconds(10);
+    /** @brief records of a class per rate period, 0 for no limit */
+    uint32_t maxRecords = 0;
+    Clock::duration ratePeriod = std::chrono::hours(1);
+};
+
+/** @brief Events held and collapsed into one record */
+template <typename Value>
+struct Aggregate
+{
+    uint32_t count = 0;
+    Value first{};
+    Value last{};
+};
+
+/**
+ * @class SelAggregator
+ *
+ * Per class aggregation state. Record is whatever emits the record of an
+ * event, the one of the last held event emits the aggregated record.
+ */
+template <typename Record, typename Value>
+class SelAggregator
+{
+  public:
+    explicit SelAggregator(const SelPolicy& policy = SelPolicy{}) :
+        policy(policy)
+    {}
+
+    /**
+     * @brief Account an event
+     *
+     * @param[in] eventClass - class of the event
+     * @param[in] record - emits the record of the event
+     * @param[in] value - value carried by the event
+     * @param[in] now - current time
+     * @return true if the record must be emitted right away, otherwise the
+     * event is held until due() returns its class
+     */
+    bool event(const std::string& eventClass, Record record, const Value& value,
+               Clock::time_point now)
+    {
+        auto& state = classes[eventClass];
+        if (state.held.count == 0 && now >= state.windowEnd &&
+            allowed(state, now))
+        {
+            emitted(state, now);
+            return true;
+        }
+        if (state.held.count == 0)
+        {
+            state.held.first = value;
+        }
+        state.held.count++;
+        state.held.last = value;
+        state.record = std::move(record);
+        return false;
+    }
+
+    /**
+     * @brief Take the aggregated records which are due
+     *
+     * @param[in] now - current time
+     * @return the record of the last held event of each class with the
+     * aggregate to emit with it
+     */
+    std::vector<std::pair<Record, Aggregate<Value>>> due(Clock::time_point now)
+    {
+        std::vector<std::pair<Record, Aggregate<Value>>> records;
+        for (auto& [eventClass, state] : classes)
+        {
+            if (state.held.count == 0 || now < state.windowEnd ||
+                !allowed(state, now))
+            {
+                continue;
+            }
+            records.emplace_back(std::move(*state.record), state.held);
+            state.record.reset();
+            state.held = Aggregate<Value>{};
+            emitted(state, now);
+        }
+        return records;
+    }
+
+    /** @brief time of the next aggregated record, nullopt if no event is
+     * held */
+    std::optional<Clock::time_point> nextDeadline() const
+    {
+        std::optional<Clock::time_point> next;
+        for (const auto& [eventClass, state] : classes)
+        {
+            if (state.held.count == 0)
+            {
+                continue;
+            }
+            auto deadline = state.windowEnd;
+            if (policy.maxRecords && state.records.size() >= policy.maxRecords)
+            {
+                deadline = std::max(deadline, state.records.front() +
+                                                  policy.ratePeriod);
+            }
+            if (!next || deadline < *next)
+            {
+                next = deadline;
+            }
+        }
+        return next;
+    }
+
+    /** @brief events held over all classes */
+    uint32_t held() const
+    {
+        uint32_t count = 0;
+        for (const auto& [eventClass, state] : classes)
+        {
+            count += state.held.count;
+        }
+        return count;
+    }
+
+  private:
+    struct ClassState
+    {
+        Clock::time_point windowEnd{};
+        /** @brief times of the records within the rate period */
+        std::deque<Clock::time_point> records;
+        Aggregate<Value> held;
+        std::optional<Record> record;
+    };
+
+    bool allowed(ClassState& state, Clock::time_point now) const
+    {
+        if (!policy.maxRecords)
+        {
+            return true;
+        }
+        while (!state.records.empty() &&
+               state.records.front() + policy.ratePeriod <= now)
+        {
+            state.records.pop_front();
+        }
+        return state.records.size() < policy.maxRecords;
+    }
+
+    void emitted(ClassState& state, Clock::time_point now)
+    {
+        state.windowEnd = now + policy.window;
+        if (policy.maxRecords)
+        {
+            state.records.push_back(now);
+        }
+    }
+
+    SelPolicy policy;
+    std::map<std::string, ClassState> classes;
+};
+
+} // namespace nvidia::power::sel
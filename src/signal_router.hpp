@@ -0,0 +1,261 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Routing table of the PropertiesChanged signals watched by
+ * nvidia-power-mgrd.
+ *
+ * Instead of one bus match per watched object, the subscriptions are grouped
+ * by interface and each group is covered by a single match on the deepest
+ * path namespace containing all of its objects. Incoming changes are routed
+ * to the subscribers through a hash table keyed on path, interface and
+ * property.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace nvidia::power::signal
+{
+
+/**
+ * @brief Deepest path namespace containing both paths
+ *
+ * @param[in] a - object path or path namespace
+ * @param[in] b - object path or path namespace
+ * @return the common namespace, "/" when they only share the root
+ */
+inline std::string commonNamespace(const std::string& a, const std::string& b)
+{
+    size_t common = 0;
+    size_t i = 0;
+    while (i < a.size() && i < b.size() && a[i] == b[i])
+    {
+        i++;
+        if ((i == a.size() || a[i] == '/') && (i == b.size() || b[i] == '/'))
+        {
+            common = i;
+        }
+    }
+    return common <= 1 ? std::string("/") : a.substr(0, common);
+}
+
+/**
+ * @brief Match rule for the PropertiesChanged signals of an interface
+ *
+ * @param[in] interface - interface whose properties are watched
+ * @param[in] pathNamespace - namespace of the watched objects
+ * @return the D-Bus match rule
+ */
+inline std::string matchRule(const std::string& interface,
+                             const std::string& pathNamespace)
+{
+    std::string rule = "type='signal',"
+                       "interface='org.freedesktop.DBus.Properties',"
+                       "member='PropertiesChanged',arg0='" +
+                       interface + "',";
+    if (pathNamespace != "/")
+    {
+        rule += "path_namespace='" + pathNamespace + "',";
+    }
+    return rule;
+}
+
+/** @brief Order in which the subscribers of a change are called */
+enum class Priority
+{
+    /** @brief called before all other handlers of the signal, whatever the
+     * chassis they belong to */
+    Urgent,
+    Normal,
+};
+
+/**
+ * @class SignalTable
+ *
+ * Subscriptions of the PropertiesChanged signals, grouped by interface.
+ */
+template <typename ValueType>
+class SignalTable
+{
+  public:
+    /** @brief called with the changed value, nullptr when the value could
+     * not be decoded */
+    using Handler = std::function<void(const std::string& path,
+                                       const std::string& property,
+                                       const ValueType* value)>;
+
+    /**
+     * @brief Subscribe to the changes of a property
+     *
+     * @param[in] path - object path
+     * @param[in] interface - interface of the property
+     * @param[in] property - property name
+     * @param[in] handler - called on every change
+     * @param[in] priority - handlers are called by priority, then in
+     * subscription order
+     * @return true if the namespace of the interface group changed and its
+     * match has to be replaced
+     */
+    bool add(const std::string& path, const std::string& interface,
+             const std::string& property, Handler handler,
+             Priority priority = Priority::Normal)
+    {
+        handlers[key(path, interface, property)]
+                [static_cast<size_t>(priority)]
+                    .push_back(std::move(handler));
+        auto& properties = objectProperties[key(path, interface)];
+        if (std::find(properties.begin(), properties.end(), property) ==
+            properties.end())
+        {
+            properties.push_back(property);
+        }
+
+        auto group = namespaces.find(interface);
+        if (group == namespaces.end())
+        {
+            namespaces.emplace(interface, path);
+            return true;
+        }
+        auto pathNamespace = commonNamespace(group->second, path);
+        if (pathNamespace == group->second)
+        {
+            return false;
+        }
+        group->second = pathNamespace;
+        return true;
+    }
+
+    /** @brief path namespace of each interface group */
+    const std::map<std::string, std::string>& groups() const
+    {
+        return namespaces;
+    }
+
+    /**
+     * @brief Route the change of a property to its subscribers
+     *
+     * @return the number of handlers called
+     */
+    size_t dispatch(const std::string& path, const std::string& interface,
+                    const std::string& property, const ValueType& value) const
+    {
+        size_t called = 0;
+        for (size_t priority = 0; priority < priorities; priority++)
+        {
+            called += dispatch(path, interface, property, &value, priority);
+        }
+        return called;
+    }
+
+    /**
+     * @brief Route the changes of a signal to their subscribers, the urgent
+     * handlers of all the changed properties are called first
+     *
+     * @return the number of handlers called
+     */
+    size_t dispatch(const std::string& path, const std::string& interface,
+                    const std::map<std::string, ValueType>& values) const
+    {
+        size_t called = 0;
+        for (size_t priority = 0; priority < priorities; priority++)
+        {
+            for (const auto& [property, value] : values)
+            {
+                called +=
+                    dispatch(path, interface, property, &value, priority);
+            }
+        }
+        return called;
+    }
+
+    /**
+     * @brief Tell all subscribers of an object interface that its values are
+     * unknown, used when a signal could not be decoded
+     */
+    void dispatchUnknown(const std::string& path,
+                         const std::string& interface) const
+    {
+        auto properties = objectProperties.find(key(path, interface));
+        if (properties == objectProperties.end())
+        {
+            return;
+        }
+        const auto& subscribed = properties->second;
+        for (size_t priority = 0; priority < priorities; priority++)
+        {
+            for (size_t i = 0; i < subscribed.size(); i++)
+            {
+                auto property = subscribed[i];
+                dispatch(path, interface, property, nullptr, priority);
+            }
+        }
+    }
+
+  private:
+    static constexpr size_t priorities =
+        static_cast<size_t>(Priority::Normal) + 1;
+
+    /** @brief call the handlers of a key with the given priority */
+    size_t dispatch(const std::string& path, const std::string& interface,
+                    const std::string& property, const ValueType* value,
+                    size_t priority) const
+    {
+        auto entry = handlers.find(key(path, interface, property));
+        if (entry == handlers.end())
+        {
+            return 0;
+        }
+        // indexed as the handlers may subscribe more
+        const auto& subscribers = entry->second[priority];
+        size_t i = 0;
+        for (; i < subscribers.size(); i++)
+        {
+            subscribers[i](path, property, value);
+        }
+        return i;
+    }
+
+    template <typename... Args>
+    static std::string key(const std::string& first, const Args&... rest)
+    {
+        std::string k = first;
+        ((k += '\0', k += rest), ...);
+        return k;
+    }
+
+    /** @brief deques keep the handlers in place when more are added while
+     * they run */
+    std::unordered_map<std::string,
+                       std::array<std::deque<Handler>, priorities>>
+        handlers;
+
+    /** @brief subscribed properties keyed by path and interface */
+    std::unordered_map<std::string, std::deque<std::string>> objectProperties;
+
+    /** @brief path namespace keyed by interface */
+    std::map<std::string, std::string> namespaces;
+};
+
+} // namespace nvidia::power::signal
@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Cost of a snapshot read, alone and against a writer updating the
+ * snapshot as fast as it can:
+ *
+ *   bench_power_cap_snapshot [reads]
+ *
+ * Every state written has all its fields derived from one counter, a read
+ * mixing two states is counted as torn and fails the run.
+ */
+
+#include "power_cap_snapshot.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using namespace nvidia::power::snapshot;
+
+static PowerCapState makeState(uint32_t value)
+{
+    PowerCapState state{};
+    state.currentPowerLimit = value;
+    state.chassisPowerLimit_Max = value;
+    state.moduleCount = maxModules;
+    for (size_t i = 0; i < maxModules; i++)
+    {
+        state.modulePowerLimit[i] = value;
+    }
+    state.allocationCount = maxAllocations;
+    for (size_t i = 0; i < maxAllocations; i++)
+    {
+        state.allocations[i].powerCap = value;
+    }
+    return state;
+}
+
+static bool torn(const PowerCapState& state)
+{
+    uint32_t value = state.currentPowerLimit;
+    for (size_t i = 0; i < maxAllocations; i++)
+    {
+        if (state.allocations[i].powerCap != value)
+        {
+            return true;
+        }
+    }
+    return state.chassisPowerLimit_Max != value ||
+           state.modulePowerLimit[maxModules - 1] != value;
+}
+
+/** @brief ns per read and the number of torn and failed reads */
+static double readAll(const SnapshotReader& reader, int reads,
+                      uint64_t& tornReads, uint64_t& failedReads)
+{
+    PowerCapState state{};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; i++)
+    {
+        if (!reader.read(state))
+        {
+            failedReads++;
+            continue;
+        }
+        tornReads += torn(state);
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / reads;
+}
+
+int main(int argc, char** argv)
+{
+    int reads = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    auto path = (std::filesystem::temp_directory_path() /
+                 ("bench_power_cap_snapshot_" + std::to_string(getpid())))
+                    .string();
+
+    SnapshotWriter writer(path);
+    writer.write(makeState(0));
+    SnapshotReader reader(path.c_str());
+    if (!writer.valid() || !reader.valid())
+    {
+        std::fprintf(stderr, "unable to map %s\n", path.c_str());
+        return 1;
+    }
+
+    uint64_t tornReads = 0;
+    uint64_t failedReads = 0;
+    double alone = readAll(reader, reads, tornReads, failedReads);
+
+    std::atomic<bool> stop = false;
+    uint64_t writes = 0;
+    std::thread spinning([&]() {
+        for (uint32_t value = 1; !stop; value++, writes++)
+        {
+            writer.write(makeState(value));
+        }
+    });
+    double contended = readAll(reader, reads, tornReads, failedReads);
+    stop = true;
+    spinning.join();
+    std::filesystem::remove(path);
+
+    std::printf("%d reads: %.1f ns per read, %.1f ns per read against a "
+                "spinning writer (%llu writes)\n",
+                reads, alone, contended,
+                static_cast<unsigned long long>(writes));
+    std::printf("%llu torn reads, %llu reads given up\n",
+                static_cast<unsigned long long>(tornReads),
+                static_cast<unsigned long long>(failedReads));
+    return tornReads ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cap_broker.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::power::broker;
+using namespace std::chrono_literals;
+
+static const Clock::time_point start{};
+
+TEST(CapBrokerTest, MostRestrictiveRequestWins)
+{
+    CapBroker broker;
+    EXPECT_FALSE(broker.winner());
+
+    EXPECT_TRUE(broker.submit({"orchestrator", 6000, 1, start + 60s}));
+    EXPECT_TRUE(broker.submit({"thermal", 5200, 0, start + 60s}));
+    EXPECT_FALSE(broker.submit({"inband", 5800, 9, start + 60s}));
+
+    auto winner = broker.winner();
+    ASSERT_TRUE(winner);
+    EXPECT_EQ(winner->owner, "thermal");
+    EXPECT_EQ(winner->cap, 5200);
+    EXPECT_EQ(broker.size(), 3);
+}
+
+TEST(CapBrokerTest, PriorityBreaksTies)
+{
+    CapBroker broker;
+    broker.submit({"a", 5000, 1, start + 60s});
+    EXPECT_TRUE(broker.submit({"b", 5000, 2, start + 60s}));
+    EXPECT_EQ(broker.winner()->owner, "b");
+    EXPECT_FALSE(broker.submit({"c", 5000, 0, start + 60s}));
+}
+
+TEST(CapBrokerTest, OwnerReplacesItsRequest)
+{
+    CapBroker broker;
+    broker.submit({"thermal", 5000, 0, start + 60s});
+    broker.submit({"orchestrator", 5500, 0, start + 60s});
+
+    // relaxing its own request hands over to the next most restrictive one
+    EXPECT_TRUE(broker.submit({"thermal", 6000, 0, start + 60s}));
+    EXPECT_EQ(broker.winner()->owner, "orchestrator");
+    EXPECT_EQ(broker.size(), 2);
+
+    // renewing the lease of the winner does not change it
+    EXPECT_FALSE(broker.submit({"orchestrator", 5500, 0, start + 120s}));
+}
+
+TEST(CapBrokerTest, LeasesExpire)
+{
+    CapBroker broker;
+    broker.submit({"thermal", 5000, 0, start + 10s});
+    broker.submit({"orchestrator", 5500, 0, start + 30s});
+    EXPECT_EQ(broker.nextExpiry(), start + 10s);
+
+    EXPECT_FALSE(broker.expire(start + 9s));
+    EXPECT_TRUE(broker.expire(start + 10s));
+    EXPECT_EQ(broker.winner()->owner, "orchestrator");
+    EXPECT_EQ(broker.nextExpiry(), start + 30s);
+
+    EXPECT_TRUE(broker.expire(start + 31s));
+    EXPECT_FALSE(broker.winner());
+    EXPECT_FALSE(broker.nextExpiry());
+}
+
+TEST(CapBrokerTest, ReleaseDropsRequest)
+{
+    CapBroker broker;
+    broker.submit({"thermal", 5000, 0, start + 10s});
+    broker.submit({"orchestrator", 5500, 0, start + 30s});
+
+    EXPECT_FALSE(broker.release("orchestrator"));
+    EXPECT_FALSE(broker.release("unknown"));
+    EXPECT_TRUE(broker.release("thermal"));
+    EXPECT_FALSE(broker.winner());
+}
+
+TEST(CapBrokerTest, FightingClientsSettle)
+{
+    // two clients rewriting their requests every second only move the
+    // enforced cap when the winning value changes
+    CapBroker broker;
+    size_t changes = 0;
+    for (int t = 0; t < 100; t++)
+    {
+        auto now = start + std::chrono::seconds(t);
+        changes += broker.expire(now);
+        changes += broker.submit({"orchestrator", 6000, 1, now + 5s});
+        changes += broker.submit({"thermal", 5400, 0, now + 5s});
+    }
+    EXPECT_EQ(changes, 2);
+    EXPECT_EQ(broker.winner()->cap, 5400);
+}
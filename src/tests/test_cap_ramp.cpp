@@ -0,0 +1,127 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cap_ramp.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::power::ramp;
+using namespace std::chrono_literals;
+
+static const Clock::time_point start{};
+
+static uint64_t chassisPower(const std::vector<uint32_t>& caps,
+                             const std::vector<uint32_t>& devices)
+{
+    uint64_t power = 0;
+    for (size_t i = 0; i < caps.size(); i++)
+    {
+        power += uint64_t{caps[i]} * devices[i];
+    }
+    return power;
+}
+
+TEST(CapRampTest, DropIsSlewRateLimited)
+{
+    std::vector<uint32_t> devices{4, 4};
+    CapRamp ramp(RampPolicy{100, 200}, devices);
+    ramp.restart({700, 700}, start);
+
+    // 5600W to 4000W at 200W/s takes 8s
+    EXPECT_TRUE(ramp.retarget({500, 500}, start));
+    EXPECT_EQ(ramp.eta(), start + 8s);
+
+    auto previous = chassisPower(ramp.caps(start), devices);
+    EXPECT_EQ(previous, 5600);
+    for (auto t = start + 100ms; t <= start + 9s; t += 100ms)
+    {
+        auto power = chassisPower(ramp.caps(t), devices);
+        EXPECT_LE(power, previous);
+        // 20W per 100ms plus the rounding of each module
+        EXPECT_LE(previous - power, 20 + 2 * 4);
+        previous = power;
+    }
+    EXPECT_FALSE(ramp.ramping(start + 8s));
+    EXPECT_EQ(ramp.caps(start + 8s), (std::vector<uint32_t>{500, 500}));
+    EXPECT_EQ(ramp.caps(start + 4s), (std::vector<uint32_t>{600, 600}));
+}
+
+TEST(CapRampTest, RaiseUsesItsOwnRate)
+{
+    std::vector<uint32_t> devices{2};
+    CapRamp ramp(RampPolicy{100, 0}, devices);
+    ramp.restart({400}, start);
+
+    // lowering is instant with a zero rate
+    EXPECT_TRUE(ramp.retarget({300}, start));
+    EXPECT_FALSE(ramp.ramping(start));
+    EXPECT_EQ(ramp.caps(start), (std::vector<uint32_t>{300}));
+
+    EXPECT_TRUE(ramp.retarget({400}, start));
+    EXPECT_EQ(ramp.eta(), start + 2s);
+    EXPECT_EQ(ramp.caps(start + 1s), (std::vector<uint32_t>{350}));
+}
+
+TEST(CapRampTest, SameTargetsKeepTheRamp)
+{
+    std::vector<uint32_t> devices{1};
+    CapRamp ramp(RampPolicy{10, 10}, devices);
+    ramp.restart({100}, start);
+    ramp.retarget({50}, start);
+    EXPECT_FALSE(ramp.retarget({50}, start + 2s));
+    EXPECT_EQ(ramp.eta(), start + 5s);
+}
+
+TEST(CapRampTest, RetargetStartsFromCurrentCaps)
+{
+    std::vector<uint32_t> devices{1, 1};
+    CapRamp ramp(RampPolicy{10, 10}, devices);
+    ramp.restart({100, 100}, start);
+    ramp.retarget({0, 100}, start);
+
+    // half way the first module is at 50, going back up takes 5s
+    EXPECT_TRUE(ramp.retarget({100, 100}, start + 5s));
+    EXPECT_EQ(ramp.caps(start + 5s), (std::vector<uint32_t>{50, 100}));
+    EXPECT_EQ(ramp.eta(), start + 10s);
+}
+
+TEST(CapRampTest, ModulesFinishTogether)
+{
+    std::vector<uint32_t> devices{1, 3};
+    CapRamp ramp(RampPolicy{0, 50}, devices);
+    ramp.restart({600, 400}, start);
+
+    // 100W + 3 * 100W lowered at 50W/s
+    ramp.retarget({500, 300}, start);
+    EXPECT_EQ(ramp.eta(), start + 8s);
+    auto caps = ramp.caps(start + 4s);
+    EXPECT_EQ(caps, (std::vector<uint32_t>{550, 350}));
+}
+
+TEST(CapRampTest, RestartBypassesTheRamp)
+{
+    // an emergency clamp sets the caps at once, the ramp resumes from them
+    std::vector<uint32_t> devices{1};
+    CapRamp ramp(RampPolicy{10, 10}, devices);
+    ramp.restart({500}, start);
+    ramp.retarget({400}, start);
+
+    ramp.restart({200}, start + 1s);
+    EXPECT_FALSE(ramp.ramping(start + 1s));
+    EXPECT_TRUE(ramp.retarget({400}, start + 1s));
+    EXPECT_EQ(ramp.eta(), start + 21s);
+}
@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cap_reconciler.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::power::reconcile;
+using namespace std::chrono_literals;
+
+static const Clock::time_point start{};
+
+TEST(CapReconcilerTest, NewCapGetsACycle)
+{
+    CapReconciler reconciler(ReconcilePolicy{1s, 60s}, 1);
+    EXPECT_EQ(reconciler.observe(0, 400, 500, start), Decision::Wait);
+    EXPECT_EQ(reconciler.observe(0, 500, 500, start + 1s), Decision::InSync);
+    EXPECT_EQ(reconciler.drifts(), 0);
+    EXPECT_EQ(reconciler.pushes(), 0);
+}
+
+TEST(CapReconcilerTest, DriftIsPushedOnce)
+{
+    CapReconciler reconciler(ReconcilePolicy{1s, 60s}, 2);
+    reconciler.observe(0, 500, 500, start);
+    reconciler.observe(1, 500, 500, start);
+
+    // the GPU manager restarted with its default cap
+    EXPECT_EQ(reconciler.observe(0, 700, 500, start + 1s), Decision::Push);
+    EXPECT_EQ(reconciler.observe(1, 500, 500, start + 1s), Decision::InSync);
+    EXPECT_EQ(reconciler.mismatched(), 1);
+    EXPECT_EQ(reconciler.observe(0, 500, 500, start + 2s), Decision::InSync);
+    EXPECT_EQ(reconciler.mismatched(), 0);
+    EXPECT_EQ(reconciler.drifts(), 1);
+    EXPECT_EQ(reconciler.pushes(), 1);
+}
+
+TEST(CapReconcilerTest, PersistentMismatchBacksOff)
+{
+    CapReconciler reconciler(ReconcilePolicy{1s, 8s}, 1);
+    reconciler.observe(0, 500, 500, start);
+
+    std::vector<int> pushedAt;
+    for (int t = 1; t < 60; t++)
+    {
+        if (reconciler.observe(0, 700, 500, start + std::chrono::seconds(t)) ==
+            Decision::Push)
+        {
+            pushedAt.push_back(t);
+        }
+    }
+    // 1s, 2s, 4s, then 8s apart
+    EXPECT_EQ(pushedAt, (std::vector<int>{1, 2, 4, 8, 16, 24, 32, 40, 48, 56}));
+    EXPECT_EQ(reconciler.drifts(), 1);
+}
+
+TEST(CapReconcilerTest, UnknownReportIsNotADrift)
+{
+    CapReconciler reconciler(ReconcilePolicy{1s, 60s}, 1);
+    reconciler.observe(0, 500, 500, start);
+    EXPECT_EQ(reconciler.observe(0, std::nullopt, 500, start + 1s),
+              Decision::InSync);
+    EXPECT_EQ(reconciler.drifts(), 0);
+}
+
+TEST(CapReconcilerTest, DesiredChangeResetsBackoff)
+{
+    CapReconciler reconciler(ReconcilePolicy{1s, 60s}, 1);
+    reconciler.observe(0, 500, 500, start);
+    reconciler.observe(0, 700, 500, start + 1s);
+    reconciler.observe(0, 700, 500, start + 2s);
+
+    EXPECT_EQ(reconciler.observe(0, 700, 450, start + 3s), Decision::Wait);
+    EXPECT_EQ(reconciler.mismatched(), 0);
+    EXPECT_EQ(reconciler.observe(0, 700, 450, start + 4s), Decision::Push);
+    EXPECT_EQ(reconciler.drifts(), 2);
+}
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "power_allocation.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+
+using namespace nvidia::power::allocation;
+
+static const std::vector<ModuleShare> modules{
+    {35, 4, 200, 700}, // GPU
+    {10, 2, 100, 400}, // CPU
+    {5, 1, 0, 4294967295u}, // not bounded
+};
+
+TEST(PowerAllocationTest, SplitsChassisLimit)
+{
+    std::vector<uint32_t> caps;
+    std::vector<Violation> violations;
+    allocate(6500, 4900, 6500, modules, caps, violations);
+    EXPECT_EQ(caps, (std::vector<uint32_t>{568, 325, 325}));
+    EXPECT_TRUE(violations.empty());
+
+    // same rounding as the module caps applied before
+    EXPECT_EQ(moduleCap(5500, 35, 4), 481);
+    EXPECT_EQ(moduleCap(4900, 10, 3), 163);
+}
+
+TEST(PowerAllocationTest, ReportsViolations)
+{
+    std::vector<uint32_t> caps;
+    std::vector<Violation> violations;
+    allocate(9000, 4900, 6500, modules, caps, violations);
+    ASSERT_EQ(violations.size(), 3);
+    EXPECT_EQ(violations[0].module, -1);
+    EXPECT_EQ(violations[0].value, 9000);
+    EXPECT_EQ(violations[1].module, 0);
+    EXPECT_EQ(violations[1].value, 787);
+    EXPECT_EQ(violations[1].max, 700);
+    EXPECT_EQ(violations[2].module, 1);
+    EXPECT_EQ(violations[2].value, 450);
+
+    // caps are still computed, only reported
+    EXPECT_EQ(caps.size(), 3);
+
+    // 100W of the CPU is at its bound, not outside
+    allocate(2000, 4900, 6500, modules, caps, violations);
+    ASSERT_EQ(violations.size(), 2);
+    EXPECT_EQ(violations[1].value, 175);
+    EXPECT_EQ(violations[1].min, 200);
+}
+
+TEST(PowerAllocationTest, CheapEnoughForSearches)
+{
+    std::vector<uint32_t> caps;
+    std::vector<Violation> violations;
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t limit = 0; limit < 1000000; limit++)
+    {
+        allocate(4000 + limit % 3000, 4900, 6500, modules, caps, violations);
+        sum += caps[0] + violations.size();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    EXPECT_GT(sum, 0);
+    std::cout << "allocation: " << elapsed / 1000000 << " ns" << std::endl;
+}
+
+TEST(PowerAllocationTest, SharesPowerLeftByRestOfSystem)
+{
+    std::vector<uint32_t> caps;
+    std::vector<Violation> violations;
+    // 6500W - 2500W shared 35:10:5 by 4, 2 and 1 devices
+    allocate(6500, 4900, 6500, modules, caps, violations, 2500);
+    EXPECT_EQ(caps, (std::vector<uint32_t>{700, 400, 400}));
+    EXPECT_TRUE(violations.empty());
+
+    allocate(6500, 4900, 6500, modules, caps, violations, 4500);
+    EXPECT_EQ(caps, (std::vector<uint32_t>{350, 200, 200}));
+
+    // nothing left
+    allocate(6500, 4900, 6500, modules, caps, violations, 7000);
+    EXPECT_EQ(caps, (std::vector<uint32_t>{0, 0, 0}));
+    EXPECT_EQ(violations.size(), 2);
+}
+
+TEST(PowerAllocationTest, EmergencyLimitLeavesTheRestOfSystemPower)
+{
+    // proportional shares adding up to 100, as used with the estimate
+    const std::vector<ModuleShare> proportional{
+        {80, 4, 0, 4294967295u}, // GPU
+        {20, 2, 0, 4294967295u}, // CPU
+    };
+    auto chassisPower = [&proportional](const std::vector<uint32_t>& caps,
+                                        uint32_t rest) {
+        uint64_t total = rest;
+        for (size_t i = 0; i < caps.size(); i++)
+        {
+            total += uint64_t{caps[i]} * proportional[i].numOfDevices;
+        }
+        return total;
+    };
+    std::vector<uint32_t> caps;
+    std::vector<Violation> violations;
+
+    // the percentages of the 2700W emergency limit leave nothing for the
+    // 600W drawn by the rest of the system
+    allocate(2700, 0, 6500, proportional, caps, violations);
+    EXPECT_GT(chassisPower(caps, 600), 2700);
+
+    // the emergency caps computed with the estimate hold the limit
+    allocate(2700, 0, 6500, proportional, caps, violations, 600);
+    EXPECT_EQ(caps, (std::vector<uint32_t>{420, 210}));
+    EXPECT_LE(chassisPower(caps, 600), 2700);
+}
@@ -0,0 +1,257 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "power_cap_snapshot.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+using namespace nvidia::power::snapshot;
+
+class PowerCapSnapshotTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        path = (std::filesystem::temp_directory_path() /
+                ("test_power_cap_snapshot_" + std::to_string(getpid())))
+                   .string();
+        std::filesystem::remove(path);
+    }
+
+    void TearDown() override
+    {
+        if (mapped)
+        {
+            munmap(mapped, sizeof(Snapshot));
+        }
+        std::filesystem::remove(path);
+    }
+
+    /** @brief writable mapping of the file, as another writer would see
+     * it */
+    Snapshot* map()
+    {
+        int fd = open(path.c_str(), O_RDWR);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+        void* addr = mmap(nullptr, sizeof(Snapshot), PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        mapped = static_cast<Snapshot*>(addr);
+        return mapped;
+    }
+
+    /** @brief a state whose fields all derive from one value */
+    static PowerCapState makeState(uint32_t value)
+    {
+        PowerCapState state{};
+        state.mode = static_cast<uint8_t>(value);
+        state.currentPowerLimit = value;
+        state.chassisPowerLimit_P = value + 1;
+        state.chassisPowerLimit_Q = value + 2;
+        state.chassisPowerLimit_Min = value + 3;
+        state.chassisPowerLimit_Max = value + 4;
+        state.restOfSystemPower = value + 5;
+        state.moduleCount = maxModules;
+        for (size_t i = 0; i < maxModules; i++)
+        {
+            state.modulePowerLimit[i] = value + 10 + i;
+        }
+        state.allocationCount = 1;
+        std::strncpy(state.allocations[0].module, "GPU",
+                     moduleNameSize - 1);
+        state.allocations[0].powerCap = value;
+        return state;
+    }
+
+    static bool consistent(const PowerCapState& state)
+    {
+        uint32_t value = state.currentPowerLimit;
+        if (state.mode != static_cast<uint8_t>(value) ||
+            state.chassisPowerLimit_Max != value + 4 ||
+            state.restOfSystemPower != value + 5 ||
+            state.allocations[0].powerCap != value)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < maxModules; i++)
+        {
+            if (state.modulePowerLimit[i] != value + 10 + i)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string path;
+    Snapshot* mapped = nullptr;
+};
+
+TEST_F(PowerCapSnapshotTest, WriteReadRoundTrip)
+{
+    SnapshotReader missing(path.c_str());
+    PowerCapState state{};
+    EXPECT_FALSE(missing.read(state));
+
+    SnapshotWriter writer(path);
+    ASSERT_TRUE(writer.valid());
+    writer.write(makeState(5200));
+
+    SnapshotReader reader(path.c_str());
+    ASSERT_TRUE(reader.valid());
+    ASSERT_TRUE(reader.read(state));
+    EXPECT_TRUE(consistent(state));
+    EXPECT_EQ(state.currentPowerLimit, 5200);
+    EXPECT_STREQ(state.allocations[0].module, "GPU");
+    EXPECT_EQ(state.generation, 1);
+
+    // the mapping follows the updates
+    writer.write(makeState(4800));
+    ASSERT_TRUE(reader.read(state));
+    EXPECT_EQ(state.currentPowerLimit, 4800);
+    EXPECT_EQ(state.generation, 2);
+}
+
+TEST_F(PowerCapSnapshotTest, ReaderRetriesWhileWriting)
+{
+    SnapshotWriter writer(path);
+    writer.write(makeState(5200));
+    SnapshotReader reader(path.c_str());
+    auto snapshot = map();
+    ASSERT_NE(snapshot, nullptr);
+
+    // an odd sequence is an update in progress
+    uint32_t sequence = snapshot->sequence.load();
+    snapshot->sequence.store(sequence + 1);
+    PowerCapState state{};
+    EXPECT_FALSE(reader.read(state, 100));
+
+    // the reader keeps retrying until the update is complete
+    std::atomic<bool> done = false;
+    std::thread waiting([&]() {
+        done = reader.read(state, std::numeric_limits<unsigned>::max());
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(done);
+    snapshot->state = makeState(4800);
+    snapshot->sequence.store(sequence + 2);
+    waiting.join();
+    EXPECT_TRUE(done);
+    EXPECT_EQ(state.currentPowerLimit, 4800);
+}
+
+TEST_F(PowerCapSnapshotTest, ReaderDiscardsChangedCopies)
+{
+    SnapshotWriter writer(path);
+    writer.write(makeState(0));
+    SnapshotReader reader(path.c_str());
+
+    // every copy taken while the sequence moved is discarded, a torn copy
+    // would mix the fields of two states
+    std::atomic<bool> stop = false;
+    std::thread spinning([&]() {
+        for (uint32_t value = 1; !stop; value++)
+        {
+            writer.write(makeState(value));
+        }
+    });
+    size_t reads = 0;
+    size_t torn = 0;
+    uint64_t generation = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        PowerCapState state{};
+        if (!reader.read(state))
+        {
+            continue;
+        }
+        reads++;
+        torn += !consistent(state);
+        EXPECT_GE(state.generation, generation);
+        generation = state.generation;
+    }
+    stop = true;
+    spinning.join();
+    EXPECT_GT(reads, 0);
+    EXPECT_EQ(torn, 0);
+}
+
+TEST_F(PowerCapSnapshotTest, WriterContinuesTheSequence)
+{
+    {
+        SnapshotWriter writer(path);
+        writer.write(makeState(1));
+        writer.write(makeState(2));
+    }
+    auto snapshot = map();
+    ASSERT_NE(snapshot, nullptr);
+    uint32_t sequence = snapshot->sequence.load();
+    EXPECT_EQ(sequence % 2, 0);
+
+    // a restarted daemon keeps the state and counts on
+    SnapshotWriter writer(path);
+    SnapshotReader reader(path.c_str());
+    PowerCapState state{};
+    ASSERT_TRUE(reader.read(state));
+    EXPECT_EQ(state.currentPowerLimit, 2);
+    EXPECT_EQ(snapshot->sequence.load(), sequence);
+
+    writer.write(makeState(3));
+    EXPECT_EQ(snapshot->sequence.load(), sequence + 2);
+    ASSERT_TRUE(reader.read(state));
+    EXPECT_EQ(state.generation, 3);
+}
+
+TEST_F(PowerCapSnapshotTest, WriterRecoversFromAnInterruptedUpdate)
+{
+    {
+        SnapshotWriter writer(path);
+        writer.write(makeState(1));
+    }
+    auto snapshot = map();
+    ASSERT_NE(snapshot, nullptr);
+    // the previous daemon died in the middle of an update
+    uint32_t sequence = snapshot->sequence.load() + 1;
+    snapshot->sequence.store(sequence);
+    snapshot->state.currentPowerLimit = 7;
+
+    SnapshotWriter writer(path);
+    EXPECT_EQ(snapshot->sequence.load() % 2, 0);
+    EXPECT_GT(snapshot->sequence.load(), sequence);
+
+    // the half written state is cleared rather than published
+    SnapshotReader reader(path.c_str());
+    PowerCapState state{};
+    ASSERT_TRUE(reader.read(state));
+    EXPECT_EQ(state.currentPowerLimit, 0);
+    writer.write(makeState(2));
+    ASSERT_TRUE(reader.read(state));
+    EXPECT_EQ(state.currentPowerLimit, 2);
+    EXPECT_EQ(state.generation, 1);
+}
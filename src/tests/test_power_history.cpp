@@ -0,0 +1,196 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "power_history.hpp"
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <random>
+
+using namespace nvidia::power::history;
+
+static constexpr int64_t day = 24 * 3600 * 1000;
+
+TEST(PowerHistoryTest, SamplesRoundTrip)
+{
+    Series series(3);
+    std::vector<Sample> expected;
+    std::mt19937 random(1);
+    int64_t time = 1700000000000;
+    for (int i = 0; i < 5000; i++)
+    {
+        // jittered period, a large gap and values of any kind
+        time += i == 2500 ? 600000 : 1000 + random() % 7 - 3;
+        std::vector<double> values{
+            700, 650.0 + random() % 50,
+            i % 100 == 0 ? NAN : 431.7 + (random() % 1000) / 7.0};
+        ASSERT_TRUE(series.append(time, values));
+        expected.push_back(Sample{time, values});
+    }
+    EXPECT_FALSE(series.append(time, {0, 0, 0}));
+    EXPECT_FALSE(series.append(time + 1, {0}));
+
+    auto samples = series.range(0, time);
+    ASSERT_EQ(samples.size(), expected.size());
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        ASSERT_EQ(samples[i].timeMs, expected[i].timeMs);
+        for (size_t c = 0; c < 3; c++)
+        {
+            if (std::isnan(expected[i].values[c]))
+            {
+                EXPECT_TRUE(std::isnan(samples[i].values[c]));
+            }
+            else
+            {
+                ASSERT_EQ(samples[i].values[c], expected[i].values[c]);
+            }
+        }
+    }
+
+    auto part = series.range(expected[10].timeMs, expected[19].timeMs);
+    ASSERT_EQ(part.size(), 10);
+    EXPECT_EQ(part.front().timeMs, expected[10].timeMs);
+}
+
+TEST(PowerHistoryTest, DayOfModuleSamplesFitsInOneMegabyte)
+{
+    // cap, allocation and measured power of a module at 1Hz for a day
+    Series series(3);
+    std::mt19937 random(2);
+    int64_t time = 1700000000000;
+    double cap = 700;
+    for (int i = 0; i < 24 * 3600; i++)
+    {
+        time += 1000 + random() % 5 - 2;
+        if (i % 600 == 0)
+        {
+            cap = 500 + random() % 200;
+        }
+        double power = std::round(cap * 0.9 + random() % 40 - 20);
+        series.append(time, {cap, cap, power});
+    }
+    EXPECT_EQ(series.samples(), 24 * 3600);
+    EXPECT_LT(series.bytes(), 1024 * 1024);
+    std::cout << "24h at 1Hz, 3 columns: " << series.bytes() << " bytes"
+              << std::endl;
+}
+
+TEST(PowerHistoryTest, RetentionDropsOldBlocks)
+{
+    Series series(1, SeriesPolicy{3600 * 1000, day});
+    int64_t time = 0;
+    for (int i = 0; i < 3 * 24 * 3600; i++)
+    {
+        time += 1000;
+        series.append(time, {100});
+    }
+    auto samples = series.range(0, time);
+    ASSERT_FALSE(samples.empty());
+    EXPECT_GE(samples.front().timeMs, time - day - 3600 * 1000);
+    EXPECT_LE(samples.front().timeMs, time - day);
+    // a constant value costs about 2 bits per sample
+    EXPECT_LT(series.bytes(), 30 * 1024);
+}
+
+TEST(PowerHistoryTest, Downsample)
+{
+    Series series(1);
+    for (int i = 0; i < 60; i++)
+    {
+        series.append(i * 1000, {i == 5 ? NAN : static_cast<double>(i)});
+    }
+    auto buckets = series.downsample(0, 0, 59000, 10000);
+    ASSERT_EQ(buckets.size(), 6);
+    EXPECT_EQ(buckets[0].startMs, 0);
+    EXPECT_EQ(buckets[0].count, 9);
+    EXPECT_EQ(buckets[0].min, 0);
+    EXPECT_EQ(buckets[0].max, 9);
+    EXPECT_DOUBLE_EQ(buckets[0].avg, 40.0 / 9);
+    EXPECT_EQ(buckets[5].startMs, 50000);
+    EXPECT_DOUBLE_EQ(buckets[5].avg, 54.5);
+
+    auto raw = series.downsample(0, 20000, 22000, 0);
+    ASSERT_EQ(raw.size(), 3);
+    EXPECT_EQ(raw[2].startMs, 22000);
+    EXPECT_EQ(raw[2].avg, 22);
+    EXPECT_TRUE(series.downsample(1, 0, 59000, 0).empty());
+}
+
+TEST(PowerHistoryTest, EnergyIntegratesPower)
+{
+    Series series(1, SeriesPolicy{3600 * 1000, 3600 * 1000});
+    // 500W for two hours, one hour of which fell out of the retention
+    for (int i = 0; i <= 7200; i++)
+    {
+        series.append(i * 1000, {500});
+    }
+    EXPECT_DOUBLE_EQ(series.integral(0), 500.0 * 7200);
+
+    // a ramp from 500W to 1500W over 10s adds 10kJ, unknown samples add
+    // nothing
+    series.append(7210 * 1000, {1500});
+    series.append(7211 * 1000, {NAN});
+    series.append(7212 * 1000, {1500});
+    EXPECT_DOUBLE_EQ(series.integral(0), 500.0 * 7200 + 10000);
+}
+
+TEST(PowerHistoryTest, WallClockStepsKeepTheSamples)
+{
+    Series series(1);
+    int64_t wall = 1700000000000;
+    // 500W sampled every second, NTP steps the wall clock back by an hour
+    // after 100s and forward by a day after 200s
+    for (int i = 0; i <= 300; i++)
+    {
+        if (i == 100)
+        {
+            wall -= 3600 * 1000;
+        }
+        if (i == 200)
+        {
+            wall += day;
+        }
+        ASSERT_TRUE(series.append(i * 1000, wall, {500}));
+        wall += 1000;
+    }
+    EXPECT_EQ(series.samples(), 301);
+    // the steps neither add nor lose energy
+    EXPECT_DOUBLE_EQ(series.integral(0), 500.0 * 300);
+
+    // the queries use the wall clock of each sample
+    auto before = series.range(1700000000000, 1700000000000 + 99 * 1000);
+    ASSERT_EQ(before.size(), 100);
+    auto stepped = series.range(1700000000000 - 3600 * 1000,
+                                1700000000000 - 3600 * 1000 + 199 * 1000);
+    ASSERT_EQ(stepped.size(), 100);
+    EXPECT_EQ(stepped.front().timeMs, 1700000000000 - 3600 * 1000 + 100 * 1000);
+    auto after = series.range(1700000000000 - 3600 * 1000 + day,
+                              1700000000000 + 2 * day);
+    ASSERT_EQ(after.size(), 101);
+    EXPECT_EQ(after.front().timeMs,
+              1700000000000 - 3600 * 1000 + day + 200 * 1000);
+
+    // a drift within the tolerance stays in the block
+    Series drifting(1);
+    for (int i = 0; i < 100; i++)
+    {
+        drifting.append(i * 1000, i * 1000 + i, {500});
+    }
+    EXPECT_EQ(drifting.range(0, 200000).size(), 100);
+}
@@ -0,0 +1,185 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "power_sharing.hpp"
+
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::power::sharing;
+
+/* demand of each module, per device, at a given control period */
+using Trace = std::function<std::vector<uint32_t>(size_t)>;
+
+struct SimulationResult
+{
+    /* control period of the last cap change */
+    size_t settledAfter = 0;
+    bool budgetHeld = true;
+    bool boundsHeld = true;
+};
+
+/* run the control loop against a synthetic trace, the modules draw their
+ * demand up to their cap */
+static SimulationResult simulate(std::vector<ModuleShare>& modules,
+                                 uint64_t budget, const SharingPolicy& policy,
+                                 const Trace& trace, size_t periods)
+{
+    SimulationResult result;
+    std::vector<uint32_t> power(modules.size());
+    for (size_t t = 0; t < periods; t++)
+    {
+        auto demand = trace(t);
+        for (size_t i = 0; i < modules.size(); i++)
+        {
+            power[i] = std::min(demand[i], modules[i].cap);
+        }
+        if (rebalance(modules, power, budget, policy))
+        {
+            result.settledAfter = t + 1;
+        }
+        uint64_t used = 0;
+        for (const auto& module : modules)
+        {
+            used += uint64_t{module.cap} * module.devices;
+            if (module.cap < module.floor || module.cap > module.ceiling)
+            {
+                result.boundsHeld = false;
+            }
+        }
+        if (used > budget)
+        {
+            result.budgetHeld = false;
+        }
+    }
+    return result;
+}
+
+TEST(PowerSharingTest, IdleModuleDonatesHeadroom)
+{
+    // two modules of 4 devices evenly split 3200W
+    std::vector<ModuleShare> modules{{4, 200, 700, 400}, {4, 200, 700, 400}};
+    SharingPolicy policy{20, 50};
+    Trace trace = [](size_t) { return std::vector<uint32_t>{650, 150}; };
+
+    auto result = simulate(modules, 3200, policy, trace, 100);
+
+    EXPECT_TRUE(result.budgetHeld);
+    EXPECT_TRUE(result.boundsHeld);
+    EXPECT_LE(result.settledAfter, convergencePeriods(modules, policy));
+    // the idle module keeps its floor, the busy one gets all it can draw
+    EXPECT_EQ(modules[1].cap, 200);
+    EXPECT_EQ(modules[0].cap, 600);
+}
+
+TEST(PowerSharingTest, BusyModulesShareEvenly)
+{
+    std::vector<ModuleShare> modules{{2, 200, 700, 400}, {2, 200, 700, 400}};
+    SharingPolicy policy{20, 0};
+    Trace trace = [](size_t) { return std::vector<uint32_t>{700, 700}; };
+
+    auto result = simulate(modules, 1600, policy, trace, 20);
+
+    EXPECT_TRUE(result.budgetHeld);
+    EXPECT_EQ(modules[0].cap, 400);
+    EXPECT_EQ(modules[1].cap, 400);
+    EXPECT_EQ(result.settledAfter, 0);
+}
+
+TEST(PowerSharingTest, ReconvergesAfterWorkloadSwap)
+{
+    std::vector<ModuleShare> modules{
+        {2, 150, 600, 350}, {2, 150, 600, 350}, {4, 100, 500, 250}};
+    SharingPolicy policy{20, 40};
+    constexpr size_t swapAt = 100;
+    Trace trace = [](size_t t) {
+        return t < swapAt ? std::vector<uint32_t>{580, 120, 250}
+                          : std::vector<uint32_t>{120, 580, 250};
+    };
+
+    auto result = simulate(modules, 2400, policy, trace, 2 * swapAt);
+
+    EXPECT_TRUE(result.budgetHeld);
+    EXPECT_TRUE(result.boundsHeld);
+    ASSERT_GT(result.settledAfter, swapAt);
+    EXPECT_LE(result.settledAfter - swapAt,
+              convergencePeriods(modules, policy));
+    EXPECT_GT(modules[1].cap, modules[0].cap);
+}
+
+TEST(PowerSharingTest, FloorsAboveBudgetAreScaled)
+{
+    std::vector<ModuleShare> modules{{1, 400, 700, 400}, {1, 400, 700, 400}};
+    auto caps = targetCaps(modules, {400, 400}, 600, SharingPolicy{});
+
+    EXPECT_EQ(caps[0], 300);
+    EXPECT_EQ(caps[1], 300);
+}
+
+TEST(PowerSharingTest, RandomTracesConverge)
+{
+    std::mt19937 rng(5);
+    for (int run = 0; run < 1000; run++)
+    {
+        size_t count = 2 + rng() % 4;
+        std::vector<ModuleShare> modules(count);
+        uint64_t budget = 0;
+        for (auto& module : modules)
+        {
+            module.devices = 1 + rng() % 4;
+            module.floor = 100 + rng() % 100;
+            module.ceiling = module.floor + 100 + rng() % 600;
+            module.cap = (module.floor + module.ceiling) / 2;
+            budget += uint64_t{module.cap} * module.devices;
+        }
+        SharingPolicy policy{20, static_cast<uint32_t>(rng() % 100)};
+        std::vector<uint32_t> demand(count);
+        for (auto& value : demand)
+        {
+            value = rng() % 900;
+        }
+        Trace trace = [&demand](size_t) { return demand; };
+
+        auto result = simulate(modules, budget, policy, trace, 500);
+
+        ASSERT_TRUE(result.budgetHeld) << "run " << run;
+        ASSERT_TRUE(result.boundsHeld) << "run " << run;
+        ASSERT_LE(result.settledAfter, convergencePeriods(modules, policy))
+            << "run " << run;
+    }
+}
+
+TEST(PowerSharingTest, NoisyTraceKeepsBudget)
+{
+    std::vector<ModuleShare> modules{
+        {4, 200, 700, 400}, {4, 200, 700, 400}, {2, 100, 400, 300}};
+    SharingPolicy policy{20, 25};
+    std::mt19937 rng(11);
+    Trace trace = [&rng](size_t) {
+        return std::vector<uint32_t>{static_cast<uint32_t>(rng() % 750),
+                                     static_cast<uint32_t>(rng() % 750),
+                                     static_cast<uint32_t>(rng() % 450)};
+    };
+
+    auto result = simulate(modules, 3800, policy, trace, 10000);
+
+    EXPECT_TRUE(result.budgetHeld);
+    EXPECT_TRUE(result.boundsHeld);
+}
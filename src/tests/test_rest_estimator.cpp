@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rest_estimator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <random>
+
+using namespace nvidia::power::rest;
+
+TEST(RestEstimatorTest, NoEstimateWithoutSamples)
+{
+    RestEstimator estimator;
+    EXPECT_FALSE(estimator.estimate());
+    estimator.update(NAN, 3000, 1);
+    EXPECT_FALSE(estimator.estimate());
+
+    estimator.update(6000, 3000, 1);
+    EXPECT_EQ(estimator.estimate(), 3000 + 150);
+    EXPECT_EQ(estimator.raw(), 3000);
+}
+
+TEST(RestEstimatorTest, StaleSamplesDropTheEstimate)
+{
+    RestEstimator estimator(EstimatorPolicy{1, 30, 0, 0, 100000, 3});
+    estimator.update(6000, 3000, 1);
+    estimator.update(6000, NAN, 1);
+    estimator.update(NAN, 3000, 1);
+    EXPECT_EQ(estimator.estimate(), 3000);
+    estimator.update(NAN, NAN, 1);
+    EXPECT_FALSE(estimator.estimate());
+    estimator.update(6000, 3100, 1);
+    EXPECT_TRUE(estimator.estimate());
+}
+
+TEST(RestEstimatorTest, EstimateIsBounded)
+{
+    RestEstimator estimator(EstimatorPolicy{1, 30, 100, 1000, 3000, 5});
+    estimator.update(3000, 3000, 1);
+    EXPECT_EQ(estimator.estimate(), 1000);
+    estimator.update(9000, 3000, 0.001);
+    estimator.update(9000, 3000, 60);
+    EXPECT_EQ(estimator.estimate(), 3000);
+}
+
+TEST(RestEstimatorTest, TracksSyntheticTrace)
+{
+    // two hours at 1Hz of a chassis whose rest of system power drops from
+    // 3300W to 2500W when the fans slow down, then jumps to 3800W when the
+    // CPUs get busy. The module power moves with the GPU load and the
+    // sensors are read a little apart, which adds noise to the difference.
+    EstimatorPolicy policy{};
+    RestEstimator estimator(policy);
+    std::mt19937 random(3);
+    std::normal_distribution<double> noise(0, 30);
+    std::uniform_real_distribution<double> gpuLoad(2000, 5000);
+
+    size_t under = 0;
+    size_t settled = 0;
+    double settledError = 0;
+    double worstSettledError = 0;
+    int lastStep = 0;
+    for (int t = 0; t < 7200; t++)
+    {
+        double rest = t < 1800 ? 3300 : t < 3600 ? 2500 : 3800;
+        if (t == 1800 || t == 3600)
+        {
+            lastStep = t;
+        }
+        double modules = gpuLoad(random);
+        estimator.update(rest + modules + noise(random), modules, 1);
+
+        auto estimate = estimator.estimate();
+        ASSERT_TRUE(estimate);
+        if (*estimate < rest)
+        {
+            under++;
+            // only right after the rise
+            EXPECT_GE(t, 3600);
+            EXPECT_LE(t, 3602);
+        }
+        // settled after 5 time constants of the fall
+        if (t - lastStep > 5 * policy.fallTimeConstant)
+        {
+            double error = static_cast<double>(*estimate) -
+                           policy.marginWatts - rest;
+            settledError += error;
+            worstSettledError = std::max(worstSettledError, std::abs(error));
+            settled++;
+        }
+    }
+    EXPECT_LE(under, 3);
+    // the fast rise makes the estimate follow the noise peaks, the bias is
+    // on the safe side and well within the margin
+    EXPECT_GT(settledError / settled, 0);
+    EXPECT_LT(settledError / settled, policy.marginWatts / 3.0);
+    EXPECT_LT(worstSettledError, 100);
+    std::cout << "settled tracking error: bias " << settledError / settled
+              << "W, worst " << worstSettledError << "W" << std::endl;
+}
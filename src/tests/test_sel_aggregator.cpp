@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sel_aggregator.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::power::sel;
+using namespace std::chrono_literals;
+
+/* the record is the id of the event which created it */
+using Aggregator = SelAggregator<int, uint32_t>;
+
+static const Clock::time_point start{};
+
+TEST(SelAggregatorTest, SingleEventIsRecordedRightAway)
+{
+    Aggregator aggregator(SelPolicy{10s, 0, 1h});
+    EXPECT_TRUE(aggregator.event("PowerCap", 0, 5000, start));
+    EXPECT_FALSE(aggregator.nextDeadline());
+    EXPECT_TRUE(aggregator.due(start + 1h).empty());
+}
+
+TEST(SelAggregatorTest, BurstCollapsesIntoOneRecord)
+{
+    Aggregator aggregator(SelPolicy{10s, 0, 1h});
+    EXPECT_TRUE(aggregator.event("PowerCap", 0, 5000, start));
+    for (int i = 1; i <= 50; i++)
+    {
+        EXPECT_FALSE(aggregator.event("PowerCap", i, 5000 + i,
+                                      start + std::chrono::milliseconds(i)));
+    }
+    EXPECT_EQ(aggregator.held(), 50);
+    EXPECT_EQ(aggregator.nextDeadline(), start + 10s);
+    EXPECT_TRUE(aggregator.due(start + 9s).empty());
+
+    auto records = aggregator.due(start + 10s);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].first, 50);
+    EXPECT_EQ(records[0].second.count, 50);
+    EXPECT_EQ(records[0].second.first, 5001);
+    EXPECT_EQ(records[0].second.last, 5050);
+    EXPECT_EQ(aggregator.held(), 0);
+
+    // the aggregated record opened a new window
+    EXPECT_FALSE(aggregator.event("PowerCap", 51, 6000, start + 15s));
+    records = aggregator.due(start + 20s);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].second.count, 1);
+
+    // a quiet class records right away again
+    EXPECT_TRUE(aggregator.event("PowerCap", 52, 6100, start + 40s));
+}
+
+TEST(SelAggregatorTest, ClassesAreIndependent)
+{
+    Aggregator aggregator(SelPolicy{10s, 0, 1h});
+    EXPECT_TRUE(aggregator.event("PowerCap", 0, 5000, start));
+    EXPECT_TRUE(aggregator.event("PowerMode", 1, 1, start + 1s));
+    EXPECT_FALSE(aggregator.event("PowerCap", 2, 5100, start + 2s));
+    EXPECT_FALSE(aggregator.event("PowerMode", 3, 2, start + 3s));
+
+    auto records = aggregator.due(start + 10s);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].first, 2);
+    records = aggregator.due(start + 11s);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].first, 3);
+}
+
+TEST(SelAggregatorTest, RateLimitHoldsRecords)
+{
+    // at most 3 records per class and hour, one event per second for an hour
+    Aggregator aggregator(SelPolicy{1s, 3, 1h});
+    size_t records = 0;
+    uint32_t aggregated = 0;
+    for (int t = 0; t < 3600; t++)
+    {
+        auto now = start + std::chrono::seconds(t);
+        for (const auto& [record, aggregate] : aggregator.due(now))
+        {
+            records++;
+            aggregated += aggregate.count;
+        }
+        if (aggregator.event("PowerCap", t, t, now))
+        {
+            records++;
+            aggregated++;
+        }
+    }
+    EXPECT_EQ(records, 3);
+    EXPECT_EQ(aggregator.nextDeadline(), start + 1h);
+
+    // nothing is lost, the held events are accounted in the next record
+    auto last = aggregator.due(start + 1h);
+    ASSERT_EQ(last.size(), 1);
+    aggregated += last[0].second.count;
+    EXPECT_EQ(aggregated, 3600);
+    EXPECT_EQ(last[0].second.last, 3599);
+}
@@ -0,0 +1,233 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2021-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "signal_router.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace nvidia::power::signal;
+
+struct Rule
+{
+    std::string path;
+    std::string interface;
+    std::string property;
+};
+
+/* 100 rules spread like a large powermanager.json: PSU drop events, PSU
+ * inventory status and a few chassis and host states */
+static std::vector<Rule> syntheticRules()
+{
+    std::vector<Rule> rules;
+    for (int i = 0; i < 60; i++)
+    {
+        rules.push_back({"/xyz/openbmc_project/sensors/power/psu_drop_" +
+                             std::to_string(i),
+                         "xyz.openbmc_project.Object.Enable", "Enabled"});
+    }
+    for (int i = 0; i < 30; i++)
+    {
+        rules.push_back(
+            {"/xyz/openbmc_project/inventory/system/powersupply/psu" +
+                 std::to_string(i),
+             "xyz.openbmc_project.State.Decorator.OperationalStatus",
+             "Functional"});
+    }
+    for (int i = 0; i < 10; i++)
+    {
+        rules.push_back({"/xyz/openbmc_project/state/chassis" +
+                             std::to_string(i),
+                         "xyz.openbmc_project.State.Chassis",
+                         "CurrentPowerState"});
+    }
+    return rules;
+}
+
+TEST(SignalRouterTest, CommonNamespace)
+{
+    EXPECT_EQ(commonNamespace("/a/b/c", "/a/b/d"), "/a/b");
+    EXPECT_EQ(commonNamespace("/a/b", "/a/b/c"), "/a/b");
+    EXPECT_EQ(commonNamespace("/a/bc", "/a/bd"), "/a");
+    EXPECT_EQ(commonNamespace("/a/b", "/a/b"), "/a/b");
+    EXPECT_EQ(commonNamespace("/a", "/b"), "/");
+}
+
+TEST(SignalRouterTest, MatchRule)
+{
+    EXPECT_EQ(matchRule("xyz.openbmc_project.Object.Enable",
+                        "/xyz/openbmc_project/sensors"),
+              "type='signal',interface='org.freedesktop.DBus.Properties',"
+              "member='PropertiesChanged',"
+              "arg0='xyz.openbmc_project.Object.Enable',"
+              "path_namespace='/xyz/openbmc_project/sensors',");
+    EXPECT_EQ(matchRule("a.b", "/").find("path_namespace"), std::string::npos);
+}
+
+TEST(SignalRouterTest, GroupsWidenOnlyWhenNeeded)
+{
+    SignalTable<int> table;
+    auto ignore = [](const std::string&, const std::string&, const int*) {};
+
+    EXPECT_TRUE(table.add("/a/b/c", "i", "P", ignore));
+    EXPECT_EQ(table.groups().at("i"), "/a/b/c");
+    EXPECT_TRUE(table.add("/a/b/d", "i", "P", ignore));
+    EXPECT_EQ(table.groups().at("i"), "/a/b");
+    EXPECT_FALSE(table.add("/a/b/e", "i", "P", ignore));
+    EXPECT_FALSE(table.add("/a/b/c", "i", "Q", ignore));
+    EXPECT_TRUE(table.add("/x", "j", "P", ignore));
+    EXPECT_EQ(table.groups().size(), 2);
+}
+
+TEST(SignalRouterTest, DispatchesOnlyToSubscribers)
+{
+    SignalTable<int> table;
+    std::vector<std::string> calls;
+    auto record = [&calls](const std::string& tag) {
+        return [&calls, tag](const std::string&, const std::string&,
+                             const int* value) {
+            calls.push_back(tag + (value ? std::to_string(*value) : "?"));
+        };
+    };
+    table.add("/a/b", "i", "P", record("first"));
+    table.add("/a/b", "i", "P", record("second"));
+    table.add("/a/b", "i", "Q", record("q"));
+    table.add("/a/c", "i", "P", record("other"));
+
+    EXPECT_EQ(table.dispatch("/a/b", "i", "P", 1), 2);
+    EXPECT_EQ(table.dispatch("/a/b", "j", "P", 1), 0);
+    EXPECT_EQ(table.dispatch("/a/b/c", "i", "P", 1), 0);
+    // handlers of a key are called in subscription order
+    EXPECT_EQ(calls, (std::vector<std::string>{"first1", "second1"}));
+
+    calls.clear();
+    table.dispatchUnknown("/a/b", "i");
+    EXPECT_EQ(calls, (std::vector<std::string>{"first?", "second?", "q?"}));
+}
+
+TEST(SignalRouterTest, UrgentHandlersRunFirst)
+{
+    SignalTable<int> table;
+    std::vector<std::string> calls;
+    auto record = [&calls](const std::string& tag) {
+        return [&calls, tag](const std::string&, const std::string& property,
+                             const int*) { calls.push_back(tag + property); };
+    };
+    // the redundancy handler of chassis A is registered before the
+    // emergency clamp of chassis B, as when the chassis are created in turn
+    table.add("/psu_drop", "i", "P", record("redundancyA"));
+    table.add("/psu_drop", "i", "P", record("clampA"), Priority::Urgent);
+    table.add("/psu_drop", "i", "Q", record("redundancyB"));
+    table.add("/psu_drop", "i", "P", record("clampB"), Priority::Urgent);
+
+    EXPECT_EQ(table.dispatch("/psu_drop", "i", "P", 1), 3);
+    EXPECT_EQ(calls, (std::vector<std::string>{"clampAP", "clampBP",
+                                               "redundancyAP"}));
+
+    // urgent handlers of all the properties of a signal go first
+    calls.clear();
+    EXPECT_EQ(table.dispatch("/psu_drop", "i",
+                             std::map<std::string, int>{{"P", 1}, {"Q", 1}}),
+              4);
+    EXPECT_EQ(calls, (std::vector<std::string>{"clampAP", "clampBP",
+                                               "redundancyAP",
+                                               "redundancyBQ"}));
+
+    calls.clear();
+    table.dispatchUnknown("/psu_drop", "i");
+    EXPECT_EQ(calls, (std::vector<std::string>{"clampAP", "clampBP",
+                                               "redundancyAP",
+                                               "redundancyBQ"}));
+}
+
+TEST(SignalRouterTest, HundredRulesNeedOneMatchPerInterface)
+{
+    auto rules = syntheticRules();
+    SignalTable<bool> table;
+    size_t delivered = 0;
+    for (const auto& rule : rules)
+    {
+        table.add(rule.path, rule.interface, rule.property,
+                  [&delivered](const std::string&, const std::string&,
+                               const bool*) { delivered++; });
+    }
+
+    // one match per rule before, one per interface now
+    ASSERT_EQ(table.groups().size(), 3);
+    EXPECT_EQ(table.groups().at("xyz.openbmc_project.Object.Enable"),
+              "/xyz/openbmc_project/sensors/power");
+    EXPECT_EQ(table.groups().at(
+                  "xyz.openbmc_project.State.Decorator.OperationalStatus"),
+              "/xyz/openbmc_project/inventory/system/powersupply");
+    EXPECT_EQ(table.groups().at("xyz.openbmc_project.State.Chassis"),
+              "/xyz/openbmc_project/state");
+
+    for (const auto& rule : rules)
+    {
+        table.dispatch(rule.path, rule.interface, rule.property, true);
+    }
+    EXPECT_EQ(delivered, rules.size());
+
+    // per signal cost of the hash dispatch against the scan of all rules the
+    // callbacks used to do, reported for reference only
+    constexpr size_t rounds = 2000;
+    size_t scanned = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++)
+    {
+        for (const auto& signal : rules)
+        {
+            for (const auto& rule : rules)
+            {
+                if (rule.path == signal.path &&
+                    rule.interface == signal.interface &&
+                    rule.property == signal.property)
+                {
+                    scanned++;
+                }
+            }
+        }
+    }
+    auto scanTime = std::chrono::steady_clock::now() - start;
+
+    delivered = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++)
+    {
+        for (const auto& signal : rules)
+        {
+            table.dispatch(signal.path, signal.interface, signal.property,
+                           true);
+        }
+    }
+    auto tableTime = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(delivered, scanned);
+
+    auto perSignal = [](auto time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time)
+                   .count() /
+               static_cast<double>(rounds * 100);
+    };
+    std::cout << "matches: " << rules.size() << " -> "
+              << table.groups().size() << ", per signal: "
+              << perSignal(scanTime) << "ns scan, " << perSignal(tableTime)
+              << "ns table" << std::endl;
+}